@@ -0,0 +1,77 @@
+#include "asynctask.h"
+
+#include <algorithm>
+
+CancellationToken::CancellationToken()
+{}
+
+CancellationToken::CancellationToken(std::shared_ptr<State> tokenState)
+    : state(std::move(tokenState))
+{}
+
+bool CancellationToken::IsCancelled() const
+{
+    return state && state->cancelled;
+}
+
+/**
+Method to register a handler called when the flow is cancelled, e.g. to abort a request in flight.
+The handler is not called if the flow is already cancelled or the token can't be cancelled.
+@param handler function called once, when the flow is cancelled.
+@return the id of the handler, to remove it when the operation finishes, -1 if it was not registered.
+*/
+int CancellationToken::OnCancel(std::function<void()> handler) const
+{
+    if(!state || state->cancelled)
+        return -1;
+
+    const int handlerId = state->nextHandlerId++;
+    state->handlers.emplace_back(handlerId, std::move(handler));
+    return handlerId;
+}
+
+void CancellationToken::RemoveHandler(int handlerId) const
+{
+    if(!state || handlerId < 0)
+        return;
+
+    auto &handlers = state->handlers;
+    handlers.erase(std::remove_if(handlers.begin(), handlers.end(),
+                                  [=](const std::pair<int, std::function<void()>> &handler){ return handler.first == handlerId;}),
+                   handlers.end());
+}
+
+CancellationSource::CancellationSource()
+    : state(std::make_shared<CancellationToken::State>())
+{}
+
+CancellationToken CancellationSource::Token() const
+{
+    return CancellationToken(state);
+}
+
+/**
+Method to cancel the flow. The handlers registered are called once, in the order they were registered.
+*/
+void CancellationSource::Cancel()
+{
+    if(state->cancelled)
+        return;
+
+    state->cancelled = true;
+
+    //Handlers resume the coroutines waiting, which can register or remove other handlers
+    std::vector<std::pair<int, std::function<void()>>> handlers;
+    handlers.swap(state->handlers);
+    for(auto &handler : handlers)
+        handler.second();
+}
+
+/**
+Method to cancel the current flow and start a new one, with new tokens.
+*/
+void CancellationSource::Reset()
+{
+    Cancel();
+    state = std::make_shared<CancellationToken::State>();
+}
@@ -0,0 +1,215 @@
+#ifndef ASYNCTASK_H
+#define ASYNCTASK_H
+
+#include <QVector>
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+/**
+ * Token shared by the operations of an asynchronous flow to know if the flow was cancelled. The operations
+ * waiting (e.g. a request in flight) register a handler that is called once when the flow is cancelled.
+ * Default tokens are never cancelled.
+ */
+class CancellationToken
+{
+public:
+    CancellationToken();
+
+    bool IsCancelled() const;
+    int OnCancel(std::function<void()> handler) const;
+    void RemoveHandler(int handlerId) const;
+
+private:
+    friend class CancellationSource;
+
+    struct State
+    {
+        bool cancelled = false;
+        int nextHandlerId = 0;
+        std::vector<std::pair<int, std::function<void()>>> handlers;
+    };
+
+    explicit CancellationToken(std::shared_ptr<State> tokenState);
+
+    std::shared_ptr<State> state;
+};
+
+/**
+ * Owner of the cancellation of an asynchronous flow: Token() is given to the operations of the flow and
+ * Cancel() cancels all of them. Reset() starts a new flow, cancelling the previous one.
+ */
+class CancellationSource
+{
+public:
+    CancellationSource();
+
+    CancellationToken Token() const;
+    void Cancel();
+    void Reset();
+
+private:
+    std::shared_ptr<CancellationToken::State> state;
+};
+
+template<typename T> class Task;
+
+namespace AsyncDetail {
+
+/**
+ * State shared by a coroutine and the Task objects referring to it: the result, once the coroutine returns,
+ * and the coroutine waiting for it.
+ */
+template<typename T>
+struct TaskState
+{
+    std::optional<T> value;
+    std::exception_ptr exception;
+    bool done = false;
+    std::coroutine_handle<> continuation;
+
+    T Result()
+    {
+        if(exception)
+            std::rethrow_exception(exception);
+        return std::move(*value);
+    }
+
+    void SetValue(T result) { value.emplace(std::move(result)); }
+};
+
+template<>
+struct TaskState<void>
+{
+    std::exception_ptr exception;
+    bool done = false;
+    std::coroutine_handle<> continuation;
+
+    void Result()
+    {
+        if(exception)
+            std::rethrow_exception(exception);
+    }
+};
+
+/**
+ * Final step of a coroutine: the frame is released and the coroutine waiting for the result, if any,
+ * is resumed in its place.
+ */
+template<typename State>
+struct FinalAwaiter
+{
+    std::shared_ptr<State> state;
+
+    bool await_ready() const noexcept { return false; }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> handle) noexcept
+    {
+        std::coroutine_handle<> continuation = state->continuation;
+        state->done = true;
+        handle.destroy();
+        return continuation ? continuation : std::noop_coroutine();
+    }
+
+    void await_resume() const noexcept {}
+};
+
+template<typename T>
+struct PromiseBase
+{
+    std::shared_ptr<TaskState<T>> state = std::make_shared<TaskState<T>>();
+
+    std::suspend_never initial_suspend() const noexcept { return {}; }
+    FinalAwaiter<TaskState<T>> final_suspend() const noexcept { return {state}; }
+    void unhandled_exception() { state->exception = std::current_exception(); }
+};
+
+}
+
+/**
+ * Implementation of Task class, the result of a coroutine that runs asynchronously (e.g. a flow of requests
+ * to the web api) and can be awaited by other coroutines with co_await.
+ *
+ * The coroutine starts when it is called and runs until its first co_await that suspends; it is resumed by
+ * the event that completes the operation awaited (e.g. the reply of a request). The frame releases itself
+ * when the coroutine returns, so a Task can be dropped to run the coroutine detached. Awaiting a Task
+ * already finished doesn't suspend. Exceptions thrown by the coroutine are rethrown by co_await.
+ * A Task can be awaited by one coroutine.
+ */
+template<typename T>
+class Task
+{
+public:
+    struct promise_type : AsyncDetail::PromiseBase<T>
+    {
+        Task get_return_object() { return Task(this->state); }
+        void return_value(T result) { this->state->SetValue(std::move(result)); }
+    };
+
+    Task() {}
+
+    bool IsDone() const { return state && state->done; }
+
+    bool await_ready() const noexcept { return state->done; }
+    void await_suspend(std::coroutine_handle<> handle) { state->continuation = handle; }
+    T await_resume() { return state->Result(); }
+
+private:
+    explicit Task(std::shared_ptr<AsyncDetail::TaskState<T>> taskState) : state(std::move(taskState)) {}
+
+    std::shared_ptr<AsyncDetail::TaskState<T>> state;
+};
+
+template<>
+class Task<void>
+{
+public:
+    struct promise_type : AsyncDetail::PromiseBase<void>
+    {
+        Task get_return_object() { return Task(this->state); }
+        void return_void() {}
+    };
+
+    Task() {}
+
+    bool IsDone() const { return state && state->done; }
+
+    bool await_ready() const noexcept { return state->done; }
+    void await_suspend(std::coroutine_handle<> handle) { state->continuation = handle; }
+    void await_resume() { state->Result(); }
+
+private:
+    explicit Task(std::shared_ptr<AsyncDetail::TaskState<void>> taskState) : state(std::move(taskState)) {}
+
+    std::shared_ptr<AsyncDetail::TaskState<void>> state;
+};
+
+/**
+Function to await several tasks running concurrently. The tasks are already running when they are given,
+so awaiting them in order takes as long as the slowest one.
+@param tasks tasks awaited.
+@return the results of the tasks, in the order of the tasks.
+*/
+template<typename T>
+Task<QVector<T>> WhenAll(QVector<Task<T>> tasks)
+{
+    QVector<T> results;
+    results.reserve(tasks.size());
+
+    for(Task<T> &task : tasks)
+        results.append(co_await task);
+
+    co_return results;
+}
+
+inline Task<void> WhenAll(QVector<Task<void>> tasks)
+{
+    for(Task<void> &task : tasks)
+        co_await task;
+}
+
+#endif // ASYNCTASK_H
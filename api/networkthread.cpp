@@ -0,0 +1,85 @@
+#include "networkthread.h"
+#include "utils/tracer.h"
+
+#include <QElapsedTimer>
+
+//Maximum time spent delivering results in one wake of the interface thread, the rest waits for the next wake
+static const int deliveryBudgetMs = 8;
+
+/**
+Constructor that creates the api and moves it to the network thread. The api is released in the network
+thread when the thread finishes.
+@param keysFile file with the user keys (see SpotifyAPI::ReadUserKeys).
+*/
+NetworkThread::NetworkThread(const char *keysFile, QObject *parent)
+    : QObject(parent),
+      deliveryPosted(false)
+{
+    api = new SpotifyAPI(keysFile);
+    api->moveToThread(&thread);
+    connect(&thread, &QThread::finished, api, &QObject::deleteLater);
+
+    thread.setObjectName("network");
+    thread.start();
+}
+
+NetworkThread::~NetworkThread()
+{
+    thread.quit();
+    thread.wait();
+
+    //Results not delivered are released without calling the interface
+    while(NetworkResult *result = results.Pop())
+        delete result;
+}
+
+/**
+Method to call the api in the network thread, e.g. to send a request. The call is queued and this method
+returns without waiting for it.
+@param call function called with the api.
+*/
+void NetworkThread::Post(std::function<void(SpotifyAPI*)> call)
+{
+    SpotifyAPI *networkApi = api;
+    QMetaObject::invokeMethod(networkApi, [=](){ call(networkApi);}, Qt::QueuedConnection);
+}
+
+/**
+Method called in the network thread to push a result to the interface thread. A delivery is posted to the
+interface thread only if none is pending, so a burst of results wakes it once.
+*/
+void NetworkThread::PushResult(std::function<void()> deliver)
+{
+    results.Push(new NetworkResult{{nullptr}, std::move(deliver)});
+
+    if(!deliveryPosted.exchange(true))
+        QMetaObject::invokeMethod(this, [=](){ this->DeliverResults();}, Qt::QueuedConnection);
+}
+
+/**
+Method called in the interface thread to deliver the results pushed by the network thread. When the
+budget is spent the remaining results are left for a new delivery, after the events waiting (e.g. painting).
+*/
+void NetworkThread::DeliverResults()
+{
+    TRACE_SCOPE("deliver network results", "network");
+
+    //Cleared before popping, so a result pushed from now on posts a new delivery
+    deliveryPosted.store(false);
+
+    QElapsedTimer budgetTimer;
+    budgetTimer.start();
+
+    while(NetworkResult *result = results.Pop())
+    {
+        result->deliver();
+        delete result;
+
+        if(budgetTimer.elapsed() >= deliveryBudgetMs)
+        {
+            if(!deliveryPosted.exchange(true))
+                QMetaObject::invokeMethod(this, [=](){ this->DeliverResults();}, Qt::QueuedConnection);
+            return;
+        }
+    }
+}
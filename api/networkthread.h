@@ -0,0 +1,67 @@
+#ifndef NETWORKTHREAD_H
+#define NETWORKTHREAD_H
+
+#include <QObject>
+#include <QThread>
+#include <atomic>
+#include <functional>
+#include "api/spotifyapi.h"
+#include "utils/mpscqueue.h"
+
+/**
+ * Result of the network thread waiting to be delivered in the interface thread: the call of the interface
+ * handler with the data of a SpotifyAPI signal, already parsed and extracted in the network thread.
+ */
+struct NetworkResult
+{
+    std::atomic<NetworkResult*> next;
+    std::function<void()> deliver;
+};
+
+/**
+ * Implementation of NetworkThread class to run a SpotifyAPI object, with all its requests, reply reads, Json
+ * parsing and timers, in a thread of its own, so heavy syncs don't compete with the painting of the interface.
+ *
+ * The interface calls the api with Post(), which runs the call in the network thread. The signals of the api
+ * are given to interface handlers with Deliver(): each signal emitted pushes the call of the handler, with a
+ * copy of its arguments, to a lock-free queue, and the network thread never waits for the interface thread.
+ * The interface thread is woken once for all the results pushed while it is busy, and delivers them within
+ * a time budget per wake, so a burst of results doesn't stall a frame.
+ */
+class NetworkThread : public QObject
+{
+    Q_OBJECT
+
+public:
+    NetworkThread(const char *keysFile, QObject *parent = nullptr);
+    ~NetworkThread();
+
+    void Post(std::function<void(SpotifyAPI*)> call);
+
+    /**
+    Method to call an interface handler each time the api emits a signal. The handler is called in the
+    thread of this object with the arguments of the signal.
+    @param signal signal of SpotifyAPI.
+    @param handler function with the arguments of the signal.
+    */
+    template<typename... Args, typename Handler>
+    void Deliver(void (SpotifyAPI::*signal)(Args...), Handler handler)
+    {
+        connect(api, signal, api, [=](Args... args){
+            this->PushResult([=](){ handler(args...);} );
+        }, Qt::DirectConnection);
+    }
+
+private:
+    void PushResult(std::function<void()> deliver);
+    void DeliverResults();
+
+    QThread thread;
+    SpotifyAPI *api;
+
+    //Results pushed by the network thread, and true while a delivery is posted to the interface thread
+    MpscQueue<NetworkResult> results;
+    std::atomic<bool> deliveryPosted;
+};
+
+#endif // NETWORKTHREAD_H
@@ -0,0 +1,423 @@
+#include "operationqueue.h"
+#include "utils/logger.h"
+
+#include <QFile>
+#include <QSaveFile>
+#include <QSet>
+#include <QUuid>
+#include <QJsonDocument>
+#include <QJsonArray>
+
+//Prefix of the ids given to playlists created locally
+static const QString localIdPrefix = "local:";
+
+static const char *typeNames[] = {"create_playlist", "add_tracks", "remove_tracks", "push_playlist"};
+
+QJsonObject QueuedOperation::ToJson() const
+{
+    return QJsonObject({{"type", typeNames[type]},
+                        {"playlist_id", playlistId},
+                        {"uris", QJsonArray::fromStringList(uris)},
+                        {"details", details},
+                        {"sent", sent}});
+}
+
+/**
+Method to read an operation written by ToJson(). The operation is read as not in flight and without id.
+@param obj Json object of the operation.
+@return the operation, of type CreatePlaylist with empty playlist id if the type is unknown.
+*/
+QueuedOperation QueuedOperation::FromJson(const QJsonObject &obj)
+{
+    QueuedOperation operation = {0, CreatePlaylist, QString(), QStringList(), obj.value("details").toObject(), false,
+                                 obj.value("sent").toBool()};
+
+    const QString type = obj.value("type").toString();
+    for(int i = 0; i <= PushPlaylist; i++)
+    {
+        if(type == typeNames[i])
+        {
+            operation.type = Type(i);
+            operation.playlistId = obj.value("playlist_id").toString();
+        }
+    }
+
+    for(const auto uri : obj.value("uris").toArray())
+        operation.uris.append(uri.toString());
+
+    return operation;
+}
+
+OperationQueue::OperationQueue()
+    : nextOperationId(1),
+      changed(false)
+{
+}
+
+/**
+Method to set the file where the queue is kept. Operations saved in the file by a previous session are
+queued before the operations made in this session.
+@param fileName path and name of file, empty to keep the queue only in memory.
+@return true if the file doesn't exist yet or its operations were read.
+*/
+bool OperationQueue::SetFile(const QString &fileName)
+{
+    file = fileName;
+    if(file.isEmpty() || !QFile::exists(file))
+        return true;
+
+    QFile loadFile(file);
+    if(!loadFile.open(QIODevice::ReadOnly))
+    {
+        LOG_WARNING("queue", "Couldn't open operations file " + file);
+        return false;
+    }
+
+    QList<QueuedOperation> loaded;
+    for(const auto value : QJsonDocument::fromJson(loadFile.readAll()).object().value("operations").toArray())
+    {
+        QueuedOperation operation = QueuedOperation::FromJson(value.toObject());
+        if(operation.playlistId.isEmpty())
+            continue;
+
+        operation.id = nextOperationId++;
+        loaded.append(operation);
+    }
+
+    operations = loaded + operations;
+    LOG_INFO("queue", QString("%1 operations waiting from previous session").arg(loaded.size()));
+
+    return true;
+}
+
+/**
+Method to set the function called when the queue changes, e.g. to save the queue after a burst of changes.
+Without handler the queue is saved after each change.
+@param handler function called after each change, the queue is written to the file by Save().
+*/
+void OperationQueue::SetChangedHandler(std::function<void()> handler)
+{
+    changedHandler = std::move(handler);
+}
+
+/**
+Method to queue the creation of a playlist.
+@param name name of the playlist.
+@param isPublic true if the playlist is public.
+@param description description of the playlist.
+@param playlistId local id of the playlist (see NewLocalId), empty to create a new one.
+@return local id of the playlist, used in the operations of the playlist until the server creates it.
+*/
+QString OperationQueue::CreatePlaylist(const QString &name, bool isPublic, const QString &description,
+                                       const QString &playlistId)
+{
+    const QString localId = playlistId.isEmpty() ? NewLocalId() : playlistId;
+
+    operations.append({nextOperationId++, QueuedOperation::CreatePlaylist, localId, QStringList(),
+                       QJsonObject({{"name", name}, {"public", isPublic}, {"description", description}}), false, false});
+    Changed();
+
+    return localId;
+}
+
+/**
+Method to queue tracks appended to a playlist. They are merged with the previous operation of the playlist
+if it also adds tracks.
+@param playlistId id of the playlist.
+@param uris uris of the tracks.
+*/
+void OperationQueue::AddTracks(const QString &playlistId, const QStringList &uris)
+{
+    if(uris.isEmpty())
+        return;
+
+    const int last = LastWaiting(playlistId);
+    if(last >= 0 && operations[last].type == QueuedOperation::AddTracks)
+        operations[last].uris.append(uris);
+    else
+        operations.append({nextOperationId++, QueuedOperation::AddTracks, playlistId, uris, QJsonObject(), false, false});
+
+    Changed();
+}
+
+/**
+Method to queue tracks removed from a playlist. A track added by an operation still waiting cancels that
+add, the other tracks are merged with the previous operation of the playlist if it also removes tracks.
+@param playlistId id of the playlist.
+@param uris uris of the tracks, one occurrence of each uri is removed.
+*/
+void OperationQueue::RemoveTracks(const QString &playlistId, const QStringList &uris)
+{
+    QStringList removed;
+
+    for(const QString &uri : uris)
+    {
+        bool cancelled = false;
+
+        //Look for the add among the adds and removals waiting after the last push of the playlist
+        for(int i = operations.size() - 1; i >= 0 && !cancelled; i--)
+        {
+            QueuedOperation &operation = operations[i];
+            if(operation.playlistId != playlistId)
+                continue;
+            if(operation.inFlight || operation.sent || (operation.type != QueuedOperation::AddTracks
+                                      && operation.type != QueuedOperation::RemoveTracks))
+                break;
+
+            const int position = operation.type == QueuedOperation::AddTracks ? operation.uris.lastIndexOf(uri) : -1;
+            if(position >= 0)
+            {
+                operation.uris.removeAt(position);
+                if(operation.uris.isEmpty())
+                    operations.removeAt(i);
+                cancelled = true;
+            }
+        }
+
+        if(!cancelled)
+            removed.append(uri);
+    }
+
+    if(!removed.isEmpty())
+    {
+        const int last = LastWaiting(playlistId);
+        if(last >= 0 && operations[last].type == QueuedOperation::RemoveTracks)
+            operations[last].uris.append(removed);
+        else
+            operations.append({nextOperationId++, QueuedOperation::RemoveTracks, playlistId, removed, QJsonObject(), false, false});
+    }
+
+    Changed();
+}
+
+/**
+Method to queue a push of the tracks of a playlist. The adds, removals and pushes of the playlist waiting
+are replaced by it, since the tracks pushed already have their changes.
+@param playlistId id of the playlist.
+@param uris uris of the tracks in playlist order.
+*/
+void OperationQueue::PushPlaylist(const QString &playlistId, const QStringList &uris)
+{
+    for(int i = operations.size() - 1; i >= 0; i--)
+    {
+        const QueuedOperation &operation = operations[i];
+        if(operation.playlistId == playlistId && !operation.inFlight && operation.type != QueuedOperation::CreatePlaylist)
+            operations.removeAt(i);
+    }
+
+    operations.append({nextOperationId++, QueuedOperation::PushPlaylist, playlistId, uris, QJsonObject(), false, false});
+    Changed();
+}
+
+/**
+Method to get the operations that can be sent now, which are marked as sent. The first operation waiting of
+each playlist is ready if no operation of the playlist is in flight and the playlist has a server id (or the
+operation creates it).
+@param maxInFlight maximum number of operations in flight, including the ones sent before.
+@param canStart function to check other conditions to send an operation, e.g. the server tracks are known.
+@return operations to send, in queue order.
+*/
+QVector<QueuedOperation> OperationQueue::TakeReady(int maxInFlight, std::function<bool(const QueuedOperation&)> canStart)
+{
+    QSet<QString> blocked;
+    int inFlight = 0;
+    for(const QueuedOperation &operation : qAsConst(operations))
+    {
+        if(operation.inFlight)
+        {
+            blocked.insert(operation.playlistId);
+            inFlight++;
+        }
+    }
+
+    QVector<QueuedOperation> ready;
+    for(int i = 0; i < operations.size() && inFlight < maxInFlight; i++)
+    {
+        QueuedOperation &operation = operations[i];
+        if(operation.inFlight || blocked.contains(operation.playlistId))
+            continue;
+
+        //The next operations of the playlist wait for this one
+        blocked.insert(operation.playlistId);
+
+        if(operation.type != QueuedOperation::CreatePlaylist && IsLocalId(operation.playlistId))
+            continue;
+        if(canStart && !canStart(operation))
+            continue;
+
+        operation.inFlight = true;
+        operation.sent = true;
+        inFlight++;
+        ready.append(operation);
+    }
+
+    if(!ready.isEmpty())
+        Changed();
+
+    return ready;
+}
+
+/**
+Method to remove an operation applied by the server. When a playlist is created, its local id is replaced
+by the server id in the operations waiting.
+@param operationId id of the operation.
+@param createdId server id of the playlist created by the operation.
+*/
+void OperationQueue::Finished(quint64 operationId, const QString &createdId)
+{
+    const int index = IndexOf(operationId);
+    if(index < 0)
+        return;
+
+    const QueuedOperation operation = operations.takeAt(index);
+
+    if(operation.type == QueuedOperation::CreatePlaylist && !createdId.isEmpty())
+    {
+        for(QueuedOperation &waiting : operations)
+            if(waiting.playlistId == operation.playlistId)
+                waiting.playlistId = createdId;
+    }
+
+    Changed();
+}
+
+/**
+Method to send an operation again later, e.g. after a network error.
+@param operationId id of the operation.
+*/
+void OperationQueue::Retry(quint64 operationId)
+{
+    const int index = IndexOf(operationId);
+    if(index >= 0)
+        operations[index].inFlight = false;
+}
+
+/**
+Method to replace the uris of an operation the server applied in part, so only the rest is sent again.
+@param operationId id of the operation.
+@param uris uris not applied yet.
+*/
+void OperationQueue::Update(quint64 operationId, const QStringList &uris)
+{
+    const int index = IndexOf(operationId);
+    if(index < 0)
+        return;
+
+    operations[index].uris = uris;
+    Changed();
+}
+
+/**
+Method to remove an operation rejected by the server. If it creates a playlist, the operations of the
+playlist are removed too.
+@param operationId id of the operation.
+*/
+void OperationQueue::Discard(quint64 operationId)
+{
+    const int index = IndexOf(operationId);
+    if(index < 0)
+        return;
+
+    const QueuedOperation operation = operations.takeAt(index);
+
+    if(operation.type == QueuedOperation::CreatePlaylist)
+    {
+        for(int i = operations.size() - 1; i >= 0; i--)
+            if(operations[i].playlistId == operation.playlistId)
+                operations.removeAt(i);
+    }
+
+    Changed();
+}
+
+int OperationQueue::Count() const
+{
+    return operations.size();
+}
+
+int OperationQueue::InFlightCount() const
+{
+    int count = 0;
+    for(const QueuedOperation &operation : operations)
+        if(operation.inFlight)
+            count++;
+    return count;
+}
+
+/**
+Method to create a local id for a playlist not created on the server yet, e.g. to show the playlist before
+its creation is queued in the network thread.
+*/
+QString OperationQueue::NewLocalId()
+{
+    return localIdPrefix + QUuid::createUuid().toString().mid(1, 36);
+}
+
+bool OperationQueue::IsLocalId(const QString &playlistId)
+{
+    return playlistId.startsWith(localIdPrefix);
+}
+
+int OperationQueue::IndexOf(quint64 operationId) const
+{
+    for(int i = 0; i < operations.size(); i++)
+        if(operations[i].id == operationId)
+            return i;
+    return -1;
+}
+
+/**
+Method to find the last operation of a playlist, if it is still waiting to be sent.
+@param playlistId id of the playlist.
+@return position of the operation in the queue, -1 if the playlist has no operations or the last one is in flight.
+*/
+int OperationQueue::LastWaiting(const QString &playlistId) const
+{
+    for(int i = operations.size() - 1; i >= 0; i--)
+    {
+        if(operations[i].playlistId == playlistId)
+            return operations[i].inFlight || operations[i].sent ? -1 : i;
+    }
+    return -1;
+}
+
+/**
+Method to write the queue to the file if it changed since it was last written. The file is replaced at once,
+so a queue written in part is never read.
+@return false if the file couldn't be written.
+*/
+bool OperationQueue::Save()
+{
+    if(file.isEmpty() || !changed)
+        return true;
+
+    QJsonArray operationsArray;
+    for(const QueuedOperation &operation : qAsConst(operations))
+        operationsArray.append(operation.ToJson());
+
+    QSaveFile saveFile(file);
+    if(!saveFile.open(QIODevice::WriteOnly))
+    {
+        LOG_ERROR("queue", "Couldn't open operations file " + file);
+        return false;
+    }
+
+    const QByteArray data = QJsonDocument(QJsonObject({{"operations", operationsArray}})).toJson(QJsonDocument::Compact);
+    if(saveFile.write(data) != data.size() || !saveFile.commit())
+    {
+        LOG_ERROR("queue", "Couldn't write operations file " + file + ": " + saveFile.errorString());
+        return false;
+    }
+
+    changed = false;
+    return true;
+}
+
+void OperationQueue::Changed()
+{
+    changed = true;
+    if(changedHandler)
+        changedHandler();
+    else
+        Save();
+}
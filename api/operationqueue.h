@@ -0,0 +1,92 @@
+#ifndef OPERATIONQUEUE_H
+#define OPERATIONQUEUE_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QVector>
+#include <QJsonObject>
+#include <functional>
+
+/**
+ * Write operation waiting to be sent to spotify server.
+ *   CreatePlaylist: creates the playlist described by details (name, public, description), playlistId is
+ *                   the local id given to the playlist until the server returns its id.
+ *   AddTracks:      appends the uris to the playlist.
+ *   RemoveTracks:   removes one occurrence of each uri from the playlist.
+ *   PushPlaylist:   pushes the uris as the tracks of the playlist (see PlaylistSync).
+ * An operation sent at least once (sent) may have been applied even if no reply was received, e.g. when the
+ * application was closed while it was in flight.
+ */
+struct QueuedOperation
+{
+    enum Type {CreatePlaylist, AddTracks, RemoveTracks, PushPlaylist};
+
+    quint64 id;
+    Type type;
+    QString playlistId;
+    QStringList uris;
+    QJsonObject details;
+    bool inFlight;
+    bool sent;
+
+    QJsonObject ToJson() const;
+    static QueuedOperation FromJson(const QJsonObject &obj);
+};
+
+/**
+ * Implementation of OperationQueue class, the persistent queue of write operations of the user library.
+ *
+ * Operations are kept in the order they are made and coalesced while they wait, so a session of edits sends
+ * few requests:
+ *   - tracks added to a playlist are merged with the previous add to the same playlist.
+ *   - a track removed after it was added cancels the add, the other removals are merged.
+ *   - a push of the tracks of a playlist replaces the adds, removals and pushes of the playlist waiting.
+ * Operations already sent are not changed. The operations of a playlist are sent one at a time, in order,
+ * and operations of a playlist created locally wait for the server id of the playlist.
+ * When a file is set, the queue is written to it after changes (see SetChangedHandler) and read when the
+ * application starts, so operations made offline are sent in the next session.
+ * Operations sent before are sent again, since it is not known if the server applied them: pushes are
+ * computed again from the server tracks and removals only remove tracks still in the playlist, but a
+ * playlist creation may be repeated. Adds are not merged with other changes once sent, and an add is
+ * skipped if the playlist already ends with its tracks (see SpotifyAPI::SendOperation).
+ */
+class OperationQueue
+{
+public:
+    OperationQueue();
+
+    bool SetFile(const QString &fileName);
+    void SetChangedHandler(std::function<void()> handler);
+    bool Save();
+
+    QString CreatePlaylist(const QString &name, bool isPublic, const QString &description,
+                           const QString &playlistId = QString());
+    void AddTracks(const QString &playlistId, const QStringList &uris);
+    void RemoveTracks(const QString &playlistId, const QStringList &uris);
+    void PushPlaylist(const QString &playlistId, const QStringList &uris);
+
+    QVector<QueuedOperation> TakeReady(int maxInFlight, std::function<bool(const QueuedOperation&)> canStart);
+    void Finished(quint64 operationId, const QString &createdId = QString());
+    void Retry(quint64 operationId);
+    void Update(quint64 operationId, const QStringList &uris);
+    void Discard(quint64 operationId);
+
+    int Count() const;
+    int InFlightCount() const;
+    static QString NewLocalId();
+    static bool IsLocalId(const QString &playlistId);
+
+private:
+    int IndexOf(quint64 operationId) const;
+    int LastWaiting(const QString &playlistId) const;
+    void Changed();
+
+    QList<QueuedOperation> operations;
+    quint64 nextOperationId;
+    QString file;
+    bool changed;
+    std::function<void()> changedHandler;
+};
+
+#endif // OPERATIONQUEUE_H
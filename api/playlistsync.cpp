@@ -0,0 +1,438 @@
+#include "playlistsync.h"
+#include "models/musicutils.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <algorithm>
+
+/**
+Method to move a range of elements of a list before other element, as the playlist tracks endpoint does.
+@param list list changed.
+@param position first element moved.
+@param count number of elements moved.
+@param destination position, before the move, of the element the range is moved before.
+*/
+template <class List>
+static void MoveRange(List &list, int position, int count, int destination)
+{
+    const List range = list.mid(position, count);
+    list.erase(list.begin() + position, list.begin() + position + count);
+
+    const int insertAt = destination > position ? destination - count : destination;
+    for(int i = 0; i < range.size(); i++)
+        list.insert(insertAt + i, range[i]);
+}
+
+//Json array of uris of an addition, without the end of the object
+static const JoinFormat urisFormat = {",", "\"", "\"", "{\"uris\":[", "]"};
+
+static const QString &UriText(const QString &uri)
+{
+    return uri;
+}
+
+//Spotify uris are printable ASCII without quotes or backslashes, and are written as they are, one byte per
+//character. Other texts (e.g. an uri edited or imported from a file) are escaped and encoded by QJsonDocument
+static bool IsPlainUri(const QString &text)
+{
+    for(const QChar c : text)
+    {
+        if(c.unicode() < 0x20 || c.unicode() > 0x7e || c == QLatin1Char('"') || c == QLatin1Char('\\'))
+            return false;
+    }
+    return true;
+}
+
+static QByteArray EscapedUri(const QString &text)
+{
+    //The text is written as ["text"], only the characters between the quotes are kept
+    const QByteArray json = QJsonDocument(QJsonArray({text})).toJson(QJsonDocument::Compact);
+    return json.mid(2, json.size() - 4);
+}
+
+static size_t JoinedLength(const QString &text)
+{
+    return size_t(IsPlainUri(text) ? text.size() : EscapedUri(text).size());
+}
+
+static void AppendJoined(QByteArray &out, const QString &text)
+{
+    if(!IsPlainUri(text))
+    {
+        out.append(EscapedUri(text));
+        return;
+    }
+
+    for(const QChar c : text)
+        out.append(char(c.unicode()));
+}
+
+QByteArray PlaylistEdit::Verb() const
+{
+    switch(type)
+    {
+    case Remove:
+        return "DELETE";
+    case Move:
+    case Replace:
+        return "PUT";
+    default:
+        return "POST";
+    }
+}
+
+/**
+Method to get the Json body of the request of the edit.
+@param snapshotId snapshot id of the playlist, sent with removals and moves if it is not empty.
+@return body of the request.
+*/
+QByteArray PlaylistEdit::Body(const QString &snapshotId) const
+{
+    //The uris of additions are written straight into the body, which is allocated once
+    if(type == Replace || type == Add)
+    {
+        const QByteArray close = type == Add ? ",\"position\":" + QByteArray::number(position) + "}" : "}";
+
+        QByteArray body;
+        body.reserve(int(JoinedSize(uris, UriText, urisFormat, 0, uris.size())) + close.size());
+        JoinItems(body, uris, UriText, urisFormat, 0, uris.size());
+        body.append(close);
+        return body;
+    }
+
+    QJsonObject json;
+    if(type == Remove)
+    {
+        QJsonArray tracks;
+        for(int i = 0; i < uris.size(); i++)
+            tracks.append(QJsonObject({{"uri", uris[i]}, {"positions", QJsonArray({positions[i]})}}));
+
+        json.insert("tracks", tracks);
+    }
+    else
+        json = QJsonObject({{"range_start", position}, {"range_length", count}, {"insert_before", destination}});
+
+    if(!snapshotId.isEmpty())
+        json.insert("snapshot_id", snapshotId);
+
+    return QJsonDocument(json).toJson(QJsonDocument::Compact);
+}
+
+/**
+Method to record the tracks of a playlist as they are on spotify server.
+@param playlistId id of the playlist.
+@param uris uris of the tracks in playlist order.
+@param snapshotId snapshot id of the playlist with these tracks, empty if it is not known.
+*/
+void PlaylistSync::SetServerTracks(const QString &playlistId, const QStringList &uris, const QString &snapshotId)
+{
+    serverTracks.insert(playlistId, uris);
+    snapshotIds.insert(playlistId, snapshotId);
+}
+
+bool PlaylistSync::HasServerTracks(const QString &playlistId) const
+{
+    return serverTracks.contains(playlistId);
+}
+
+QStringList PlaylistSync::ServerTracks(const QString &playlistId) const
+{
+    return serverTracks.value(playlistId);
+}
+
+/**
+Method to get the snapshot id of the server tracks of a playlist.
+@return the snapshot id, empty if it is not known.
+*/
+QString PlaylistSync::SnapshotId(const QString &playlistId) const
+{
+    return snapshotIds.value(playlistId);
+}
+
+/**
+Method to discard the server tracks of a playlist, e.g. when a push fails and the server state is unknown.
+@param playlistId id of the playlist.
+*/
+void PlaylistSync::ForgetServerTracks(const QString &playlistId)
+{
+    serverTracks.remove(playlistId);
+    snapshotIds.remove(playlistId);
+}
+
+void PlaylistSync::Clear()
+{
+    serverTracks.clear();
+    snapshotIds.clear();
+}
+
+/**
+Method to compute the edits that turn the server tracks of a playlist into the local tracks.
+@param playlistId id of the playlist, its server tracks must be recorded.
+@param localUris uris of the local tracks in playlist order.
+@return edits in the order they must be applied.
+*/
+QVector<PlaylistEdit> PlaylistSync::Diff(const QString &playlistId, const QStringList &localUris) const
+{
+    return Diff(serverTracks.value(playlistId), localUris);
+}
+
+/**
+Method to compute the edits that turn a list of tracks into other. Tracks are removed first (from the last
+one, so the positions of the next requests don't change), then moved and then added.
+@param serverUris uris of the tracks on the server.
+@param localUris uris of the tracks wanted.
+@return edits in the order they must be applied.
+*/
+QVector<PlaylistEdit> PlaylistSync::Diff(const QStringList &serverUris, const QStringList &localUris)
+{
+    QVector<PlaylistEdit> edits;
+
+    //Match the occurrences of each uri in order
+    QHash<QString, QVector<int>> localPositions;
+    for(int i = 0; i < localUris.size(); i++)
+        localPositions[localUris[i]].append(i);
+
+    QHash<QString, int> usedPositions;
+    QVector<int> kept;
+    QVector<int> removed;
+    for(int i = 0; i < serverUris.size(); i++)
+    {
+        const QVector<int> positions = localPositions.value(serverUris[i]);
+        int &used = usedPositions[serverUris[i]];
+
+        if(used < positions.size())
+            kept.append(positions[used++]);
+        else
+            removed.append(i);
+    }
+
+    AppendRemoves(edits, serverUris, removed);
+
+    //Move the tracks out of the longest ordered subsequence next to their local predecessor, in local order
+    QVector<bool> moving(localUris.size(), false);
+    const QVector<bool> ordered = LongestIncreasing(kept);
+    for(int i = 0; i < kept.size(); i++)
+        moving[kept[i]] = !ordered[i];
+
+    QVector<int> current = kept;
+    QVector<int> target = kept;
+    std::sort(target.begin(), target.end());
+
+    for(int t = 0; t < target.size(); )
+    {
+        if(!moving[target[t]])
+        {
+            t++;
+            continue;
+        }
+
+        //Tracks that are also contiguous on the server are moved together
+        const int from = current.indexOf(target[t]);
+        int count = 1;
+        while(t + count < target.size() && from + count < current.size()
+              && moving[target[t + count]] && current[from + count] == target[t + count])
+            count++;
+
+        const int destination = t > 0 ? current.indexOf(target[t - 1]) + 1 : 0;
+        if(destination < from || destination > from + count)
+        {
+            edits.append({PlaylistEdit::Move, QStringList(), QVector<int>(), from, count, destination});
+            MoveRange(current, from, count, destination);
+        }
+        t += count;
+    }
+
+    //Add the local tracks without match in batches of consecutive tracks, in local order
+    QVector<bool> matched(localUris.size(), false);
+    for(const int position : qAsConst(kept))
+        matched[position] = true;
+
+    for(int i = 0; i < localUris.size(); )
+    {
+        if(matched[i])
+        {
+            i++;
+            continue;
+        }
+
+        const int first = i;
+        while(i < localUris.size() && !matched[i])
+            i++;
+        AppendAdds(edits, localUris.mid(first, i - first), first);
+    }
+
+    if(edits.size() > (localUris.size() + maxTracksPerRequest - 1) / maxTracksPerRequest)
+        return Rewrite(localUris);
+
+    return edits;
+}
+
+/**
+Method to get the edits that write all tracks of a playlist again: the first batch replaces the tracks
+of the server and the next ones are appended.
+@param localUris uris of the tracks wanted.
+@return edits in the order they must be applied.
+*/
+QVector<PlaylistEdit> PlaylistSync::Rewrite(const QStringList &localUris)
+{
+    QVector<PlaylistEdit> edits;
+    edits.append({PlaylistEdit::Replace, localUris.mid(0, maxTracksPerRequest), QVector<int>(), 0, 0, 0});
+    AppendAdds(edits, localUris.mid(maxTracksPerRequest), maxTracksPerRequest);
+
+    return edits;
+}
+
+/**
+Method to compute the edits that append tracks to the server tracks of a playlist.
+@param playlistId id of the playlist, its server tracks must be recorded.
+@param uris uris of the tracks appended.
+@return edits in the order they must be applied.
+*/
+QVector<PlaylistEdit> PlaylistSync::AppendEdits(const QString &playlistId, const QStringList &uris) const
+{
+    QVector<PlaylistEdit> edits;
+    AppendAdds(edits, uris, serverTracks.value(playlistId).size());
+    return edits;
+}
+
+/**
+Method to compute the edits that remove one occurrence of each uri from the server tracks of a playlist,
+the last one. Uris that are not in the playlist are skipped.
+@param playlistId id of the playlist, its server tracks must be recorded.
+@param uris uris of the tracks removed.
+@return edits in the order they must be applied.
+*/
+QVector<PlaylistEdit> PlaylistSync::RemoveEdits(const QString &playlistId, const QStringList &uris) const
+{
+    const QStringList serverUris = serverTracks.value(playlistId);
+
+    QVector<bool> taken(serverUris.size(), false);
+    QVector<int> removed;
+    for(const QString &uri : uris)
+    {
+        int position = serverUris.lastIndexOf(uri);
+        while(position >= 0 && taken[position])
+            position = serverUris.lastIndexOf(uri, position - 1);
+
+        if(position >= 0)
+        {
+            taken[position] = true;
+            removed.append(position);
+        }
+    }
+    std::sort(removed.begin(), removed.end());
+
+    QVector<PlaylistEdit> edits;
+    AppendRemoves(edits, serverUris, removed);
+    return edits;
+}
+
+/**
+Method to append the edits that remove tracks in batches, from the last position to the first, so the
+positions of the next batches don't change.
+@param edits list where the edits are appended.
+@param serverUris uris of the tracks on the server.
+@param positions positions of the tracks removed, in ascending order.
+*/
+void PlaylistSync::AppendRemoves(QVector<PlaylistEdit> &edits, const QStringList &serverUris, const QVector<int> &positions)
+{
+    for(int end = positions.size(); end > 0; end -= maxTracksPerRequest)
+    {
+        PlaylistEdit edit = {PlaylistEdit::Remove, QStringList(), QVector<int>(), 0, 0, 0};
+        for(int i = end - 1; i >= qMax(0, end - maxTracksPerRequest); i--)
+        {
+            edit.uris.append(serverUris[positions[i]]);
+            edit.positions.append(positions[i]);
+        }
+        edits.append(edit);
+    }
+}
+
+/**
+Method to append the edits that insert consecutive tracks in batches.
+@param edits list where the edits are appended.
+@param uris uris of the tracks inserted.
+@param position position of the first track inserted.
+*/
+void PlaylistSync::AppendAdds(QVector<PlaylistEdit> &edits, const QStringList &uris, int position)
+{
+    for(int i = 0; i < uris.size(); i += maxTracksPerRequest)
+        edits.append({PlaylistEdit::Add, uris.mid(i, maxTracksPerRequest), QVector<int>(), position + i, 0, 0});
+}
+
+/**
+Method to apply an edit to a list of tracks, as the server does.
+@param uris uris of the tracks changed.
+@param edit edit applied.
+@return true if the edit was applied or false if its positions don't match the tracks.
+*/
+bool PlaylistSync::Apply(QStringList &uris, const PlaylistEdit &edit)
+{
+    switch(edit.type)
+    {
+    case PlaylistEdit::Remove:
+    {
+        QVector<int> positions = edit.positions;
+        for(int i = 0; i < positions.size(); i++)
+        {
+            if(positions[i] < 0 || positions[i] >= uris.size() || uris[positions[i]] != edit.uris.value(i))
+                return false;
+        }
+
+        std::sort(positions.begin(), positions.end());
+        positions.erase(std::unique(positions.begin(), positions.end()), positions.end());
+        for(int i = positions.size() - 1; i >= 0; i--)
+            uris.removeAt(positions[i]);
+        return true;
+    }
+    case PlaylistEdit::Move:
+        if(edit.position < 0 || edit.count <= 0 || edit.position + edit.count > uris.size()
+                || edit.destination < 0 || edit.destination > uris.size())
+            return false;
+
+        MoveRange(uris, edit.position, edit.count, edit.destination);
+        return true;
+    case PlaylistEdit::Replace:
+        uris = edit.uris;
+        return true;
+    default:
+        if(edit.position < 0 || edit.position > uris.size())
+            return false;
+
+        for(int i = 0; i < edit.uris.size(); i++)
+            uris.insert(edit.position + i, edit.uris[i]);
+        return true;
+    }
+}
+
+/**
+Method to find a longest strictly increasing subsequence of values, in O(n log n) time.
+@param values list of values.
+@return flags of the values that belong to the subsequence.
+*/
+QVector<bool> PlaylistSync::LongestIncreasing(const QVector<int> &values)
+{
+    //Position of the last value of the best subsequence of each length, and previous value of each value
+    QVector<int> tails;
+    QVector<int> previous(values.size(), -1);
+
+    for(int i = 0; i < values.size(); i++)
+    {
+        auto it = std::lower_bound(tails.begin(), tails.end(), values[i],
+                                   [&](int position, int value){ return values[position] < value; });
+        const int length = int(it - tails.begin());
+
+        if(length > 0)
+            previous[i] = tails[length - 1];
+        if(length == tails.size())
+            tails.append(i);
+        else
+            tails[length] = i;
+    }
+
+    QVector<bool> flags(values.size(), false);
+    for(int i = tails.isEmpty() ? -1 : tails.last(); i >= 0; i = previous[i])
+        flags[i] = true;
+
+    return flags;
+}
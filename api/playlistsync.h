@@ -0,0 +1,81 @@
+#ifndef PLAYLISTSYNC_H
+#define PLAYLISTSYNC_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+#include <QByteArray>
+#include <QJsonObject>
+
+/**
+ * Request that changes the tracks of a playlist on spotify server, in the format of the playlist tracks
+ * endpoint (/v1/playlists/{id}/tracks):
+ *   Remove: DELETE with the uris and positions of the tracks removed.
+ *   Move:   PUT moving the range of tracks [position, position + count) before the track at destination.
+ *   Add:    POST inserting the uris at position.
+ *   Replace: PUT replacing all tracks by the uris.
+ * Positions refer to the tracks of the playlist when the request is applied. Removals and moves carry the
+ * snapshot id of the playlist their positions were computed from, if it is known.
+ */
+struct PlaylistEdit
+{
+    enum Type {Remove, Move, Add, Replace};
+
+    Type type;
+    QStringList uris;
+    QVector<int> positions;
+    int position;
+    int count;
+    int destination;
+
+    QByteArray Verb() const;
+    QByteArray Body(const QString &snapshotId = QString()) const;
+};
+
+/**
+ * Implementation of PlaylistSync class, the engine that pushes local changes of playlists to spotify server.
+ *
+ * It keeps the tracks of each playlist as last known on the server (recorded when playlists are synced and
+ * after each push) and computes the edits that turn them into the local tracks:
+ *   - tracks are matched by uri, the n-th occurrence of an uri in the server tracks with its n-th occurrence
+ *     in the local tracks. Server tracks without a match are removed and local tracks without a match are added.
+ *   - the matched tracks that keep their relative order are the longest increasing subsequence of their local
+ *     positions in server order: they don't move, the other ones are moved next to their local predecessor.
+ * Consecutive tracks are removed, moved and added in the same request, up to maxTracksPerRequest tracks,
+ * so a change of one track in a large playlist costs a single small request. When the edits would need more
+ * requests than writing the whole playlist again (e.g. a playlist reversed), the playlist is replaced instead.
+ */
+class PlaylistSync
+{
+public:
+    //Maximum number of tracks accepted by the server in one request
+    static const int maxTracksPerRequest = 100;
+
+    void SetServerTracks(const QString &playlistId, const QStringList &uris, const QString &snapshotId = QString());
+    bool HasServerTracks(const QString &playlistId) const;
+    QStringList ServerTracks(const QString &playlistId) const;
+    QString SnapshotId(const QString &playlistId) const;
+    void ForgetServerTracks(const QString &playlistId);
+    void Clear();
+
+    QVector<PlaylistEdit> Diff(const QString &playlistId, const QStringList &localUris) const;
+    QVector<PlaylistEdit> AppendEdits(const QString &playlistId, const QStringList &uris) const;
+    QVector<PlaylistEdit> RemoveEdits(const QString &playlistId, const QStringList &uris) const;
+
+    static QVector<PlaylistEdit> Diff(const QStringList &serverUris, const QStringList &localUris);
+    static bool Apply(QStringList &uris, const PlaylistEdit &edit);
+
+private:
+    static QVector<PlaylistEdit> Rewrite(const QStringList &localUris);
+    static void AppendRemoves(QVector<PlaylistEdit> &edits, const QStringList &serverUris, const QVector<int> &positions);
+    static void AppendAdds(QVector<PlaylistEdit> &edits, const QStringList &uris, int position);
+    static QVector<bool> LongestIncreasing(const QVector<int> &values);
+
+    QHash<QString, QStringList> serverTracks;
+
+    //Version of the playlists on the server the tracks belong to, sent with the positional edits
+    QHash<QString, QString> snapshotIds;
+};
+
+#endif // PLAYLISTSYNC_H
@@ -1,18 +1,83 @@
 #include "spotifyapi.h"
+#include "utils/tracer.h"
+#include "utils/logger.h"
 
+//Maximum number of artists explored for each name of an artist search
+static const int artistsPerQuery = 5;
+
+//Maximum number of ids accepted by the server in one request of the artists endpoint
+static const int maxArtistsPerRequest = 50;
+
+//Maximum number of ids accepted by the server in one request of the tracks and audio features endpoints, and
+//maximum number of requests of each endpoint in flight while ids are requested in batches
+static const int maxTrackIdsPerRequest = 50;
+static const int maxFeatureIdsPerRequest = 100;
+static const int maxBatchRequests = 4;
+
+//Maximum number of queued write operations sent at the same time
+static const int maxOperationsInFlight = 4;
+
+//Time after which the operations that failed for a network or server error are sent again
+static const int operationsRetryMs = 10000;
+
+//Time the operations queue waits after a change before it is written, so a burst of edits is written once
+static const int operationsSaveMs = 500;
+
+//Time after which a token refresh without answer is given up. In Qt5 a refresh reply with a network error or
+//a rejected refresh token (400 invalid_grant) emits neither granted nor error
+static const int tokenRefreshTimeoutMs = 30000;
 
 SpotifyAPI::SpotifyAPI(const char* fileName)
 {
     replyHandler = new QOAuthHttpServerReplyHandler(8080, this);
     isConnected = false;
+    refreshingToken = false;
+    refreshFailed = false;
+    refreshTimedOut = false;
+    operationsWaitAccess = false;
+    artistSearchId = 0;
+    pendingArtistReplies = 0;
+    hydrationBatches = {"/v1/tracks", maxTrackIdsPerRequest, QStringList(), QSet<QString>(), 0,
+                        [=](QNetworkReply *reply, QStringList ids){ this->HydrateTracksReply(reply, ids);} };
+    featuresBatches = {"/v1/audio-features", maxFeatureIdsPerRequest, QStringList(), QSet<QString>(), 0,
+                       [=](QNetworkReply *reply, QStringList ids){ this->GetAudioFeaturesReply(reply, ids);} };
+    playlistsFileName = "playlistsonline.json";
+    apiBaseUrl = "https://api.spotify.com";
+    accountsBaseUrl = "https://accounts.spotify.com";
+
+    //Single network manager shared by the authorization flow and every api request, so
+    //connections to spotify hosts are kept alive and reused instead of renegotiating TLS
+    networkManager = new QNetworkAccessManager(this);
+
+    //Members are children so they follow the object when it is moved to other thread (see NetworkThread)
+    connectAuth.setParent(this);
+    tokenRefreshTimer.setParent(this);
+    tokenRefreshWatchdog.setParent(this);
+    operationsRetryTimer.setParent(this);
+    operationsSaveTimer.setParent(this);
+    metrics.setParent(this);
+    connectAuth.setNetworkAccessManager(networkManager);
+
+    metrics.DumpFromEnvironment();
+
+    operationsRetryTimer.setSingleShot(true);
+    operationsRetryTimer.setInterval(operationsRetryMs);
+    connect(&operationsRetryTimer, &QTimer::timeout, [=](){ this->RetryQueuedOperations();} );
+
+    operationsSaveTimer.setSingleShot(true);
+    operationsSaveTimer.setInterval(operationsSaveMs);
+    connect(&operationsSaveTimer, &QTimer::timeout, [=](){ this->operationQueue.Save();} );
+    operationQueue.SetChangedHandler([=](){
+        if(!this->operationsSaveTimer.isActive())
+            this->operationsSaveTimer.start();
+    });
 
     //Read file with user keys data
     if(ReadUserKeys(fileName))
     {
         //Setup connection data
         connectAuth.setReplyHandler(replyHandler);
-        connectAuth.setAuthorizationUrl(QUrl("https://accounts.spotify.com/authorize"));
-        connectAuth.setAccessTokenUrl(QUrl("https://accounts.spotify.com/api/token"));
+        SetServerUrls(apiBaseUrl, accountsBaseUrl);
 
 
         connectAuth.setClientIdentifier(clientId);
@@ -20,9 +85,10 @@ SpotifyAPI::SpotifyAPI(const char* fileName)
         connectAuth.setScope("user-read-private user-top-read playlist-read-private playlist-modify-public playlist-modify-private user-modify-playback-state");
 
         //Creates connections to Slots functions called after connection and autorization access
-        //to spotify server is established
+        //to spotify server is established. The authorization url is forwarded to the client
+        //application (browser in the interface, console in headless mode)
         connect(&connectAuth, &QOAuth2AuthorizationCodeFlow::authorizeWithBrowser,
-                &QDesktopServices::openUrl);
+                this, &SpotifyAPI::AuthorizeUrlSignal);
 
         connect(&connectAuth, &QOAuth2AuthorizationCodeFlow::statusChanged,
                 this, &SpotifyAPI::AuthStatusChanged);
@@ -30,12 +96,24 @@ SpotifyAPI::SpotifyAPI(const char* fileName)
         connect(&connectAuth, &QOAuth2AuthorizationCodeFlow::granted,
                 this, &SpotifyAPI::AccessGranted);
 
+        connect(&connectAuth, &QOAuth2AuthorizationCodeFlow::error,
+                this, &SpotifyAPI::RefreshTokenFailed);
+
+        //Token is refreshed ahead of its expiration so requests never wait on an expired token
+        tokenRefreshTimer.setSingleShot(true);
+        connect(&tokenRefreshTimer, &QTimer::timeout, this, &SpotifyAPI::RefreshToken);
+
+        tokenRefreshWatchdog.setSingleShot(true);
+        tokenRefreshWatchdog.setInterval(tokenRefreshTimeoutMs);
+        connect(&tokenRefreshWatchdog, &QTimer::timeout, this, &SpotifyAPI::RefreshTokenTimeout);
+
     }
 
 }
 
 /**
-Method to read a xml file and set user keys: id and secret
+Method to read a xml file and set user keys: id and secret.
+Optional elements api_url and accounts_url replace the spotify servers addresses (e.g. by a local mock server).
 @param: fileName path/name description of then file.
 */
 bool SpotifyAPI::ReadUserKeys(const char* fileName)
@@ -57,11 +135,17 @@ bool SpotifyAPI::ReadUserKeys(const char* fileName)
                         clientId = xml.readElementText();
                     else if(xml.name() == "secret")
                         clientSecret = xml.readElementText();
+                    else if(xml.name() == "api_url")
+                        apiBaseUrl = xml.readElementText();
+                    else if(xml.name() == "accounts_url")
+                        accountsBaseUrl = xml.readElementText();
+                    else
+                        xml.skipCurrentElement();
                 }
             }
             else
             {
-                qDebug()<<"User keys not set: Problem with Xml file";
+                LOG_ERROR("api", "User keys not set: Problem with Xml file");
                 userFile.close();
                 return false;
             }
@@ -73,18 +157,296 @@ bool SpotifyAPI::ReadUserKeys(const char* fileName)
     }
     else
     {
-        qDebug() << "User keys not set: File not open"<<userFile.errorString();
+        LOG_ERROR("api", "User keys not set: File not open " + userFile.errorString());
         return false;
     }
 
 }
 
+/**
+Method to check if the user keys (id and secret) were read from the keys file given to the constructor.
+*/
+bool SpotifyAPI::HasUserKeys() const
+{
+    return !(clientId.isEmpty()||clientSecret.isEmpty());
+}
+
+/**
+Method to set the base addresses of the web api and accounts (authorization) servers.
+An empty address keeps the current one (the default or the one of the user keys file).
+@param apiUrl base address of web api requests, default https://api.spotify.com
+@param accountsUrl base address of authorization requests, default https://accounts.spotify.com
+*/
+void SpotifyAPI::SetServerUrls(QString apiUrl, QString accountsUrl)
+{
+    if(!apiUrl.isEmpty())
+        apiBaseUrl = apiUrl;
+    if(!accountsUrl.isEmpty())
+        accountsBaseUrl = accountsUrl;
+
+    connectAuth.setAuthorizationUrl(QUrl(accountsBaseUrl + "/authorize"));
+    connectAuth.setAccessTokenUrl(QUrl(accountsBaseUrl + "/api/token"));
+}
+
 void SpotifyAPI::ConnectToServer()
 {
+    //Open the api connection while the user is granting access in the browser
+    const QUrl apiUrl(apiBaseUrl);
+    if(apiUrl.scheme() == "https")
+        networkManager->connectToHostEncrypted(apiUrl.host(), quint16(apiUrl.port(443)));
+    else
+        networkManager->connectToHost(apiUrl.host(), quint16(apiUrl.port(80)));
+
+    refreshFailed = false;
+    refreshTimedOut = false;
     connectAuth.grant();
 
 }
 
+/**
+Method to get the address of a web api endpoint.
+@param path endpoint path and query, e.g. "/v1/me".
+@return the endpoint url on the configured api server.
+*/
+QUrl SpotifyAPI::ApiUrl(const QString &path)
+{
+    return QUrl(apiBaseUrl + path);
+}
+
+/**
+Method to create a request to spotify web api with the headers common to all requests:
+bearer token, accepted content and HTTP/2 negotiation.
+@param url address of the api endpoint.
+@return the request ready to be sent by the shared network manager.
+*/
+QNetworkRequest SpotifyAPI::BuildRequest(const QUrl &url)
+{
+    QNetworkRequest request(url);
+
+    request.setRawHeader("Authorization", "Bearer " + connectAuth.token().toUtf8());
+    request.setRawHeader("Accept", "application/json");
+    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+
+    //Allows concurrent requests to be multiplexed over one connection when the server supports it
+    request.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+
+    return request;
+}
+
+/**
+Method to send a request to spotify web api through the shared network manager.
+The reply is released after the handler returns.
+@param verb HTTP method of the request (GET, POST, PUT, DELETE).
+@param url address of the api endpoint.
+@param body data sent with the request, empty for GET requests.
+@param replyHandler method called with the reply when the request is finished.
+*/
+void SpotifyAPI::SendRequest(const QByteArray &verb, const QUrl &url, const QByteArray &body,
+                             std::function<void(QNetworkReply*)> replyHandler)
+{
+    DispatchRequest({verb, url, body, replyHandler, false, 0, CancellationToken()});
+}
+
+/**
+Method to send a request or hold it while the access token is being refreshed.
+A request rejected with 401 (Unauthorized) is queued once more and replayed after the
+token is refreshed, its handler only receives the reply of the replayed request.
+A request rejected with 429 (Too Many Requests) is sent again after the time given by the
+server in the Retry-After header.
+@param request request data and handler of the reply.
+*/
+void SpotifyAPI::DispatchRequest(PendingRequest request)
+{
+    //Requests of a cancelled flow are not sent, nor sent again after a refresh or a rate limit
+    if(request.cancel.IsCancelled())
+        return;
+
+    //After a failed refresh requests are sent with the current token, only a 401 reply tries a new refresh
+    if(!refreshingToken && !refreshFailed && !request.replayed && IsTokenExpired())
+        RefreshToken();
+
+    if(refreshingToken)
+    {
+        pendingRequests.append(request);
+        return;
+    }
+
+    const QString endpoint = NetworkMetrics::EndpointName(request.verb, request.url);
+    metrics.RequestStarted(endpoint, request.body.size());
+
+    auto reply = networkManager->sendCustomRequest(BuildRequest(request.url), request.verb, request.body);
+    const qint64 sendUs = Tracer::IsEnabled() ? Tracer::NowUs() : -1;
+    QElapsedTimer latencyTimer;
+    latencyTimer.start();
+
+    const int abortHandler = request.cancel.OnCancel([=](){ reply->abort();} );
+
+    connect(reply,&QNetworkReply::finished,[=](){
+        request.cancel.RemoveHandler(abortHandler);
+        int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+
+        metrics.RequestFinished(endpoint, latencyTimer.nsecsElapsed() / 1000, reply->bytesAvailable(),
+                                reply->error() != QNetworkReply::NoError || status >= 400);
+
+        if(sendUs >= 0)
+            Tracer::AddSpan("request", "network", sendUs, Tracer::NowUs() - sendUs,
+                            request.verb + " " + request.url.path().toUtf8() + " " + QByteArray::number(status));
+
+        if(status == 401 && !request.replayed)
+        {
+            PendingRequest replay = request;
+            replay.replayed = true;
+            pendingRequests.append(replay);
+            metrics.RequestRetried(endpoint);
+            RefreshToken();
+        }
+        else if(status == 429 && request.rateLimitRetries < 5)
+        {
+            PendingRequest retry = request;
+            retry.rateLimitRetries++;
+            metrics.RequestRetried(endpoint);
+
+            int retryAfter = qMax(1, reply->rawHeader("Retry-After").toInt());
+            QTimer::singleShot(retryAfter * 1000, this, [=](){ this->DispatchRequest(retry);} );
+        }
+        else
+        {
+            TRACE_SCOPE("handle reply", "network");
+            handlingEndpoint = endpoint;
+            request.replyHandler(reply);
+            handlingEndpoint.clear();
+        }
+
+        reply->deleteLater();
+    });
+}
+
+/**
+Method to parse the Json data of a reply. The parse time is recorded in the metrics of the endpoint
+whose reply is being handled and in a trace span.
+@param data reply data.
+@return the Json document, empty if data is not valid Json.
+*/
+QJsonDocument SpotifyAPI::ParseJson(const QByteArray &data)
+{
+    TRACE_SCOPE("parse json", "json");
+
+    QElapsedTimer parseTimer;
+    parseTimer.start();
+    QJsonDocument document = QJsonDocument::fromJson(data);
+
+    if(!handlingEndpoint.isEmpty())
+        metrics.AddParseTime(handlingEndpoint, parseTimer.nsecsElapsed() / 1000);
+
+    return document;
+}
+
+/**
+Method to get the registry of requests metrics (latency, bytes, errors and retries by endpoint).
+*/
+NetworkMetrics &SpotifyAPI::Metrics()
+{
+    return metrics;
+}
+
+/**
+Method to send again all requests held while the token was refreshed. Only the requests rejected
+with 401 are marked as replayed (see DispatchRequest), the others keep their retry after a 401.
+*/
+void SpotifyAPI::ReplayPendingRequests()
+{
+    QList<PendingRequest> requests;
+    requests.swap(pendingRequests);
+
+    for(const auto &request : requests)
+        DispatchRequest(request);
+}
+
+/**
+Method to check if the current access token is expired or about to expire.
+@return true if the token expires within the next few seconds.
+*/
+bool SpotifyAPI::IsTokenExpired()
+{
+    const QDateTime expiration = connectAuth.expirationAt();
+    if(!expiration.isValid())
+        return false;
+
+    return QDateTime::currentDateTime().secsTo(expiration) < 5;
+}
+
+/**
+Method to start the timer that refreshes the access token one minute before it expires.
+*/
+void SpotifyAPI::ScheduleTokenRefresh()
+{
+    const QDateTime expiration = connectAuth.expirationAt();
+    if(!expiration.isValid())
+        return;
+
+    const qint64 refreshMargin = 60 * 1000;
+    qint64 interval = QDateTime::currentDateTime().msecsTo(expiration) - refreshMargin;
+
+    tokenRefreshTimer.start(int(qMax(qint64(0), interval)));
+}
+
+/**
+SLOT Method called to request a new access token to spotify server using the refresh token.
+Requests sent while the refresh is running are queued until the new token is granted.
+*/
+void SpotifyAPI::RefreshToken()
+{
+    if(refreshingToken)
+        return;
+
+    if(connectAuth.refreshToken().isEmpty())
+    {
+        emit UpdateOutputTextSignal("Token refresh not possible: no refresh token",false);
+        refreshFailed = true;
+        ReplayPendingRequests();
+        return;
+    }
+
+    refreshingToken = true;
+    tokenRefreshTimer.stop();
+    tokenRefreshWatchdog.start();
+    connectAuth.refreshAccessToken();
+}
+
+/**
+SLOT Method called when a token refresh gets no answer in tokenRefreshTimeoutMs. The refresh is given up
+and the requests held are released, so their handlers receive the 401 of the server instead of waiting forever.
+*/
+void SpotifyAPI::RefreshTokenTimeout()
+{
+    if(!refreshingToken)
+        return;
+
+    LOG_WARNING("api", "Token refresh failed: no answer from the authorization server");
+    refreshingToken = false;
+    refreshFailed = true;
+    refreshTimedOut = true;
+    ReplayPendingRequests();
+}
+
+/**
+SLOT Method called when the authorization server reports an error. If a token refresh
+was running the queued requests are released, so their handlers receive the failure.
+*/
+void SpotifyAPI::RefreshTokenFailed(const QString &error, const QString &errorDescription)
+{
+    QString text = "Authorization error: " + error + " " + errorDescription;
+    emit UpdateOutputTextSignal(text,false);
+
+    if(refreshingToken)
+    {
+        tokenRefreshWatchdog.stop();
+        refreshingToken = false;
+        refreshFailed = true;
+        ReplayPendingRequests();
+    }
+}
+
 bool SpotifyAPI::IsConnected()
 {
     return isConnected;
@@ -119,146 +481,361 @@ void SpotifyAPI::AuthStatusChanged(QAbstractOAuth::Status status)
 
 /**
 SLOT Method called when signal grant() is called after spotfy server grant access
-to client application. This method calls GetUserName(QNetworkReply*) method to retrieve user data.
+to client application. This method starts the library sync (SyncLibrary) to retrieve user data and playlists.
+It is also called each time the access token is refreshed.
 */
 void SpotifyAPI::AccessGranted()
 {
-    isConnected=true;
+    ScheduleTokenRefresh();
+
+    //Grant after a token refresh, or late grant of a refresh given up by the watchdog: only release
+    //the requests held during the refresh
+    if(refreshingToken || refreshTimedOut)
+    {
+        tokenRefreshWatchdog.stop();
+        refreshingToken = false;
+        refreshFailed = false;
+        refreshTimedOut = false;
+        emit UpdateOutputTextSignal("Access token refreshed",false);
+        ReplayPendingRequests();
+
+        //Operations refused with the previous token are sent with the new one
+        if(operationsWaitAccess)
+        {
+            operationsWaitAccess = false;
+            SendQueuedOperations();
+        }
+        return;
+    }
 
-    token = connectAuth.token();
+    //Operations waiting for the access are sent at the end of the sync
+    operationsWaitAccess = false;
 
-    QUrl u ("https://api.spotify.com/v1/me");
+    isConnected=true;
 
     emit UpdateOutputTextSignal("Client connected to spotfy server",false);
 
-    QString text = "Token = " + token;
+    QString text = "Token = " + connectAuth.token();
     emit UpdateOutputTextSignal(text,false);
 
-    auto reply = connectAuth.get(u);
-    connect(reply,&QNetworkReply::finished,[=](){ this->GetUserName(reply);} );
+    //A sync still running (e.g. a previous grant) is cancelled, the new one runs detached
+    syncCancel.Reset();
+    SyncLibrary(syncCancel.Token());
+}
 
+/**
+Method to cancel the library sync in progress. Its requests in flight are aborted and its data is discarded.
+*/
+void SpotifyAPI::CancelSync()
+{
+    syncCancel.Cancel();
 }
 
 /**
-SLOT Method called after get user name request returns.
-@param: network_reply reply object with spotify user data in Json format.
+Coroutine of the library sync after the access is granted: it gets the user, the list of playlists and the
+tracks of all playlists, then saves the playlists and sends the write operations waiting.
+The steps that depend on each other are awaited in sequence, the independent requests run concurrently:
+the tracks of all playlists are requested at once, each playlist with all its pages at once (see GetPages).
+@param cancel token of the sync, the sync stops without changes when it is cancelled.
 */
-void SpotifyAPI::GetUserName(QNetworkReply* network_reply)
+Task<void> SpotifyAPI::SyncLibrary(CancellationToken cancel)
 {
-    if (network_reply->error() != QNetworkReply::NoError) {
-        qDebug()<<"Not able to get user data"<<endl;
-        return;
+    const ApiReply user_reply = co_await Request("GET", ApiUrl("/v1/me"), QByteArray(), cancel);
+    if(user_reply.cancelled)
+        co_return;
+
+    if(!user_reply.IsOk())
+    {
+        LOG_WARNING("api", "Not able to get user data: " + user_reply.errorString);
+        emit PlaylistsSyncedSignal(false);
+        co_return;
     }
-    const auto data = network_reply->readAll();
 
-    const auto document = QJsonDocument::fromJson(data);
-    const auto root = document.object();
-    userName = root.value("id").toString();
+    userName = ParseJson(user_reply.data).object().value("id").toString();
+    emit UpdateOutputTextSignal("Client username = " + userName,false);
+    emit ConnectedSignal();
 
-    QString text = "Client username = " + userName;
-    emit UpdateOutputTextSignal(text,false);
+    const QJsonObject playlists = co_await GetPages(ApiUrl("/v1/users/" + userName + "/playlists?limit=50"), cancel);
+    if(cancel.IsCancelled())
+        co_return;
 
-    emit ConnectedSignal();
+    if(playlists.isEmpty())
+    {
+        LOG_WARNING("api", "Unable to get list of current playlists");
+        emit PlaylistsSyncedSignal(false);
+        co_return;
+    }
+
+    QVector<Task<QJsonObject>> tracks_requests;
+    for(const auto item : playlists.value("items").toArray())
+    {
+        const QString href = item.toObject().value("tracks").toObject().value("href").toString();
+        tracks_requests.append(GetPages(QUrl(href), cancel));
+    }
 
-    GetCurrentPlaylists();
+    const QVector<QJsonObject> playlists_tracks = co_await WhenAll(tracks_requests);
+    if(cancel.IsCancelled())
+        co_return;
 
-    network_reply->deleteLater(); 
+    userPlaylistsJson = playlists;
+    userPlaylistsFullJson.assign(playlists_tracks.begin(), playlists_tracks.end());
+    FinishPlaylistsSync();
 }
 
+/**
+Coroutine to send a request to spotify web api and await its reply. The request starts when the method is
+called, so several requests started before they are awaited run concurrently (see WhenAll).
+@param verb HTTP method of the request (GET, POST, PUT, DELETE).
+@param url address of the api endpoint.
+@param body data sent with the request, empty for GET requests.
+@param cancel token of the flow of the request, the request is aborted when the flow is cancelled.
+@return the reply of the request.
+*/
+Task<ApiReply> SpotifyAPI::Request(QByteArray verb, QUrl url, QByteArray body, CancellationToken cancel)
+{
+    RequestAwaiter awaiter(this, {verb, url, body, nullptr, false, 0, cancel});
+    co_return co_await awaiter;
+}
 
-void SpotifyAPI::GetCurrentPlaylists()
+/**
+Coroutine to get all pages of a paged endpoint (e.g. playlists or tracks of a playlist). The first page gives
+the total and the page size, then the other pages are requested at once by offset.
+@param url address of the first page.
+@param cancel token of the flow of the requests.
+@return the first page with the items of all pages, empty if a page failed or the flow was cancelled.
+*/
+Task<QJsonObject> SpotifyAPI::GetPages(QUrl url, CancellationToken cancel)
 {
-    QUrl url ("https://api.spotify.com/v1/users/" + userName + "/playlists");
+    const ApiReply first_reply = co_await Request("GET", url, QByteArray(), cancel);
+    if(!first_reply.IsOk())
+    {
+        if(!first_reply.cancelled)
+            LOG_WARNING("api", "Unable to get " + url.path() + ": " + first_reply.errorString);
+        co_return QJsonObject();
+    }
+
+    QJsonObject page = ParseJson(first_reply.data).object();
+    QJsonArray items = page.value("items").toArray();
+
+    const int total = page.value("total").toInt(items.size());
+    const int limit = page.value("limit").toInt(items.size());
+    const int offset = page.value("offset").toInt();
+
+    QVector<Task<ApiReply>> pages_requests;
+    for(int page_offset = offset + limit; limit > 0 && page_offset < total; page_offset += limit)
+    {
+        QUrlQuery query(url);
+        query.removeAllQueryItems("offset");
+        query.removeAllQueryItems("limit");
+        query.addQueryItem("offset", QString::number(page_offset));
+        query.addQueryItem("limit", QString::number(limit));
+
+        QUrl page_url = url;
+        page_url.setQuery(query);
+        pages_requests.append(Request("GET", page_url, QByteArray(), cancel));
+    }
 
-    auto reply = connectAuth.get(url);
+    const QVector<ApiReply> pages_replies = co_await WhenAll(pages_requests);
+    for(const ApiReply &page_reply : pages_replies)
+    {
+        if(!page_reply.IsOk())
+        {
+            if(!page_reply.cancelled)
+                LOG_WARNING("api", "Unable to get " + url.path() + ": " + page_reply.errorString);
+            co_return QJsonObject();
+        }
 
-    connect(reply,&QNetworkReply::finished,[=](){ this->GetCurrentPlaylistsReply(reply);} );
+        for(const auto item : ParseJson(page_reply.data).object().value("items").toArray())
+            items.append(item);
+    }
 
+    page.insert("items", items);
+    page.insert("next", QJsonValue());
+    co_return page;
+}
+
+SpotifyAPI::RequestAwaiter::RequestAwaiter(SpotifyAPI *spotifyApi, PendingRequest pendingRequest)
+    : api(spotifyApi),
+      request(pendingRequest),
+      state(std::make_shared<State>())
+{
+    state->reply = {0, QNetworkReply::NoError, QString(), QByteArray(), false};
+    state->resumed = false;
+    state->cancelHandler = -1;
+}
+
+bool SpotifyAPI::RequestAwaiter::await_ready() const
+{
+    return request.cancel.IsCancelled();
 }
 
 /**
-SLOT Method called after a request to get user current playlists returns.
-This method saves the href of each playlist to perform new requests to get playlists full
-data (tracks and artists).
-@param: network_reply reply object with data in Json format.
+Method to send the request when the coroutine is suspended. The coroutine is resumed once: by the reply
+handler, with the reply data copied, or by the cancellation of the flow.
 */
-void SpotifyAPI::GetCurrentPlaylistsReply(QNetworkReply *network_reply)
+void SpotifyAPI::RequestAwaiter::await_suspend(std::coroutine_handle<> handle)
 {
-    if (network_reply->error() != QNetworkReply::NoError) {
-        cout<<"Unable to get list of current playlists"<<endl;
-        return;
-    }
+    const std::shared_ptr<State> awaiterState = state;
+    const CancellationToken cancel = request.cancel;
 
-    const auto data = network_reply->readAll();
+    awaiterState->cancelHandler = cancel.OnCancel([=](){
+        if(awaiterState->resumed)
+            return;
 
-    const auto document = QJsonDocument::fromJson(data);
-    const auto root_obj = document.object();
+        awaiterState->resumed = true;
+        awaiterState->reply.cancelled = true;
+        awaiterState->reply.error = QNetworkReply::OperationCanceledError;
+        handle.resume();
+    });
 
-    const auto items_array = root_obj.value("items").toArray();
+    request.replyHandler = [=](QNetworkReply *reply){
+        if(awaiterState->resumed)
+            return;
 
-    //copy user playlists reply data in Json format
-    userPlaylistsJson = root_obj;
+        awaiterState->resumed = true;
+        cancel.RemoveHandler(awaiterState->cancelHandler);
 
-    userPlaylistsArray.clear();
-    userPlaylistsFullJson.clear();
+        awaiterState->reply.status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        awaiterState->reply.error = reply->error();
+        awaiterState->reply.errorString = reply->errorString();
+        awaiterState->reply.data = reply->readAll();
+        handle.resume();
+    };
 
-    userPlaylistsArray.resize(ulong(items_array.size()));
-    userPlaylistsFullJson.resize(ulong(items_array.size()));
+    api->DispatchRequest(request);
+}
 
-    for(int i=0; i<items_array.size(); i++)
-    {
-        const auto play_obj = items_array[i].toObject();
-        const auto tracks_obj = play_obj.value("tracks").toObject();
+ApiReply SpotifyAPI::RequestAwaiter::await_resume()
+{
+    if(request.cancel.IsCancelled() && !state->resumed)
+        state->reply.cancelled = true;
 
-        userPlaylistsArray[i].SetHref(tracks_obj.value("href").toString().toStdString());
-    }
+    return state->reply;
+}
 
-    GetPlaylistsTracks();
+bool ApiReply::IsOk() const
+{
+    return !cancelled && error == QNetworkReply::NoError;
+}
 
+/**
+Method called after the tracks of all playlists are received. The tracks are recorded as the server state
+of the playlists, the playlists are saved in file and the write operations waiting are sent.
+*/
+void SpotifyAPI::FinishPlaylistsSync()
+{
+    RecordServerPlaylists();
+    emit PlaylistsSyncedSignal(SavePlaylistsJsonFromWeb(playlistsFileName));
+    SendQueuedOperations();
 }
 
 /**
-Method to request individual playlists data including tracks and artists to spotify server.
-The data received is saved in Json objects.
+Method to record the tracks uris of the playlists received from the server, used as reference to push
+local changes of the playlists.
 */
-void SpotifyAPI::GetPlaylistsTracks()
+void SpotifyAPI::RecordServerPlaylists()
 {
-    for (int i=0; i<userPlaylistsArray.size(); i++)
+    const auto playlistsReplyArray = userPlaylistsJson.value("items").toArray();
+
+    for(int i=0; i < playlistsReplyArray.size() && i < int(userPlaylistsFullJson.size()); i++)
     {
-        SpotifyPlaylist playlist_current = userPlaylistsArray[i];
+        //Playlists whose tracks were not received keep their previous server state
+        if(userPlaylistsFullJson[i].isEmpty())
+            continue;
 
-        QUrl u (playlist_current.GetHref().c_str());
+        const QJsonObject playlist_json = playlistsReplyArray[i].toObject();
+        playlistSync.SetServerTracks(playlist_json.value("id").toString(), TracksUris(userPlaylistsFullJson[i]),
+                                     playlist_json.value("snapshot_id").toString());
+    }
+}
 
-        //Request playlist full data
-        auto reply = connectAuth.get(u);
+/**
+Method to get the uris of the tracks of a playlist from its tracks pages (see GetPages).
+@param tracks_json tracks of the playlist, with all pages.
+@return uris of the tracks in playlist order.
+*/
+QStringList SpotifyAPI::TracksUris(const QJsonObject &tracks_json)
+{
+    QStringList uris;
+    for(const auto item : tracks_json.value("items").toArray())
+        uris.append(item.toObject().value("track").toObject().value("uri").toString());
+    return uris;
+}
 
-        connect(reply,&QNetworkReply::finished,[=](){ this->GetPlaylistsTracksReply(reply, i);} );
+/**
+Coroutine to get again the tracks of a playlist on the server, when the tracks recorded don't match the
+server anymore (e.g. an edit rejected because the playlist was changed elsewhere). The operations of the
+playlist wait until its tracks are recorded again.
+@param playlist_id id of the playlist.
+*/
+Task<void> SpotifyAPI::FetchServerTracks(QString playlist_id)
+{
+    if(fetchingPlaylists.contains(playlist_id))
+        co_return;
 
-        while(!reply->isFinished())
-        {
-            QCoreApplication::processEvents();
-        }
+    fetchingPlaylists.insert(playlist_id);
+    const CancellationToken cancel = syncCancel.Token();
+    const QJsonObject tracks = co_await GetPages(ApiUrl("/v1/playlists/" + playlist_id + "/tracks?limit=100"), cancel);
+    fetchingPlaylists.remove(playlist_id);
+
+    if(cancel.IsCancelled())
+        co_return;
+
+    if(tracks.isEmpty())
+    {
+        LOG_WARNING("api", "Unable to get tracks of playlist " + playlist_id + ", its changes wait for the next sync");
+        co_return;
     }
 
-    SavePlaylistsJsonFromWeb("playlistsonline.json");
+    //The snapshot of the tracks is not known until the next edit returns it
+    playlistSync.SetServerTracks(playlist_id, TracksUris(tracks));
+    SendQueuedOperations();
+}
 
+/**
+Method to forget the tracks recorded of a playlist that don't match the server, and get them again.
+@param playlist_id id of the playlist.
+*/
+void SpotifyAPI::ResyncServerTracks(const QString &playlist_id)
+{
+    LOG_WARNING("api", "Tracks of playlist " + playlist_id + " changed on the server, getting them again");
+    playlistSync.ForgetServerTracks(playlist_id);
+    FetchServerTracks(playlist_id);
 }
 
-void SpotifyAPI::GetPlaylistsTracksReply(QNetworkReply *network_reply, int indice)
+/**
+Method to copy the data of a track received from the server (name, id, href, uri and its artists) to the
+format of tracks sent to the interface.
+@param sourceTrack track object received.
+@param destTrack object where the track data is copied.
+@return false if the track or its artists have incomplete data.
+*/
+bool SpotifyAPI::copyTrackData(const QJsonObject &sourceTrack, QJsonObject &destTrack)
 {
-    if (network_reply->error() != QNetworkReply::NoError) {
-        cout<<"Unable to  tracks data"<<endl;
-        return;
+    const QStringList headers = {"name","id","href","uri"};
+
+    if(!copyJsonData(headers,destTrack,sourceTrack))
+        return false;
+
+    if(!sourceTrack.contains("artists"))
+    {
+        LOG_WARNING("api", "Tracks search error: Incomplete artist data received");
+        return false;
     }
 
-    const auto data = network_reply->readAll();
+    // For each Track item received copy artists data from reply to target json objects
+    QJsonArray targetArtistsArray;
+    for(const auto artist : sourceTrack.value("artists").toArray())
+    {
+        QJsonObject targetArtistItem;
+        if(!copyJsonData(headers,targetArtistItem,artist.toObject()))
+            return false;
 
-    const auto document = QJsonDocument::fromJson(data);
-    const auto root_obj = document.object();
-    if(indice < userPlaylistsFullJson.size())
-        userPlaylistsFullJson[indice] = root_obj;
+        targetArtistsArray.append(targetArtistItem);
+    }
 
-    network_reply->deleteLater();
+    destTrack.insert("artists",targetArtistsArray);
+    return true;
 }
 
 bool SpotifyAPI::copyJsonData(QStringList jsonHeaders, QJsonObject &destData, QJsonObject sourceData)
@@ -268,7 +845,7 @@ bool SpotifyAPI::copyJsonData(QStringList jsonHeaders, QJsonObject &destData, QJ
     {
         if(!sourceData.contains(jsonHeaders[i]))
         {
-            qDebug()<<"header not found in source json object"<<endl;
+            LOG_DEBUG("api", "Header " + jsonHeaders[i] + " not found in source json object");
             return 0;
         }
         destData.insert(jsonHeaders[i],sourceData.value(jsonHeaders[i]).toString());
@@ -277,6 +854,38 @@ bool SpotifyAPI::copyJsonData(QStringList jsonHeaders, QJsonObject &destData, QJ
 
 }
 
+/**
+Method to set playlists data in the format of spotify web api replies without requesting it to
+the server, e.g. data received previously or synthetic data for benchmarks.
+@param playlistsJson reply of current user playlists request.
+@param playlistsTracksJson replies of tracks requests, in the same order of playlists items.
+*/
+void SpotifyAPI::SetPlaylistsFromWeb(QJsonObject playlistsJson, vector<QJsonObject> playlistsTracksJson)
+{
+    userPlaylistsJson = playlistsJson;
+    userPlaylistsFullJson = playlistsTracksJson;
+}
+
+/**
+Method to set the file where playlists data is saved after the playlists are synchronized
+with spotify server.
+@param fileName path and name of file.
+*/
+void SpotifyAPI::SetPlaylistsFileName(QString fileName)
+{
+    playlistsFileName = fileName;
+}
+
+/**
+Method to set the file where the write operations waiting to be sent are kept, so operations made offline
+are sent in the next session.
+@param fileName path and name of file.
+*/
+void SpotifyAPI::SetOperationsFileName(QString fileName)
+{
+    operationQueue.SetFile(fileName);
+}
+
 /**
 Method to get the JsonObjects received from a client request to server of current playlists data and
 save data in file (.json format).
@@ -284,6 +893,8 @@ save data in file (.json format).
 */
 bool SpotifyAPI::SavePlaylistsJsonFromWeb(QString fileName)
 {
+    TRACE_SCOPE("save web playlists", "save");
+
     QJsonDocument playlistsJsonDoc;
     QJsonObject root_obj;
     root_obj.insert("info", QJsonValue::fromVariant("Document of Spotify playlists in JSOn format"));
@@ -338,7 +949,7 @@ bool SpotifyAPI::SavePlaylistsJsonFromWeb(QString fileName)
     QFile saveFile(fileName);
 
     if (!saveFile.open(QIODevice::WriteOnly)) {
-        qWarning("Couldn't open save file.");
+        LOG_ERROR("api", "Couldn't open save file " + fileName);
         return 0;
     }
 
@@ -347,6 +958,113 @@ bool SpotifyAPI::SavePlaylistsJsonFromWeb(QString fileName)
 }
 
 
+/**
+Method for requesting the data of tracks known only by id, e.g. tracks imported without data. The ids are
+requested in batches of maxTrackIdsPerRequest through the tracks endpoint (/v1/tracks?ids=), with up to
+maxBatchRequests requests in flight. Ids already queued or in flight are not requested again.
+The tracks received are sent in TracksHydratedSignal, one signal for each batch.
+@param track_ids spotify ids of the tracks.
+*/
+void SpotifyAPI::HydrateTracks(QStringList track_ids)
+{
+    QueueIds(hydrationBatches, track_ids);
+}
+
+void SpotifyAPI::HydrateTracksReply(QNetworkReply *network_reply, QStringList track_ids)
+{
+    if (network_reply->error() != QNetworkReply::NoError) {
+        LOG_WARNING("api", "Unable to get tracks data: " + network_reply->errorString());
+        return;
+    }
+
+    const auto data = network_reply->readAll();
+    const auto document = ParseJson(data);
+
+    //Ids not found are returned as null
+    QJsonArray tracks_array;
+    for(const auto track : document.object().value("tracks").toArray())
+    {
+        QJsonObject track_item;
+        if(!track.toObject().isEmpty() && copyTrackData(track.toObject(), track_item))
+            tracks_array.append(track_item);
+    }
+
+    LOG_DEBUG("api", QString("Tracks hydrated = %1 of %2").arg(tracks_array.size()).arg(track_ids.size()));
+    emit TracksHydratedSignal(tracks_array);
+}
+
+/**
+Method for requesting the audio features (danceability, energy, tempo, etc.) of tracks. The ids are requested
+in batches of maxFeatureIdsPerRequest through the audio features endpoint (/v1/audio-features?ids=), with up
+to maxBatchRequests requests in flight. Ids already queued or in flight are not requested again.
+The features received are sent in AudioFeaturesSignal, one signal for each batch.
+@param track_ids spotify ids of the tracks.
+*/
+void SpotifyAPI::GetAudioFeatures(QStringList track_ids)
+{
+    QueueIds(featuresBatches, track_ids);
+}
+
+void SpotifyAPI::GetAudioFeaturesReply(QNetworkReply *network_reply, QStringList track_ids)
+{
+    if (network_reply->error() != QNetworkReply::NoError) {
+        LOG_WARNING("api", "Unable to get audio features: " + network_reply->errorString());
+        return;
+    }
+
+    const auto data = network_reply->readAll();
+    const auto document = ParseJson(data);
+    const auto features_array = document.object().value("audio_features").toArray();
+
+    LOG_DEBUG("api", QString("Audio features received = %1").arg(track_ids.size()));
+    emit AudioFeaturesSignal(features_array);
+}
+
+/**
+Method to queue ids to be requested in batches. Ids already queued or in flight are skipped.
+@param batches queue of the endpoint of the ids.
+@param ids ids requested.
+*/
+void SpotifyAPI::QueueIds(IdBatchQueue &batches, const QStringList &ids)
+{
+    for(const QString &id : ids)
+    {
+        if(id.isEmpty() || batches.ids.contains(id))
+            continue;
+
+        batches.ids.insert(id);
+        batches.queue.append(id);
+    }
+
+    SendIdBatches(batches);
+}
+
+/**
+Method to send the next batches of a queue while it has less than maxBatchRequests requests in flight.
+After each reply the ids of the batch can be requested again (e.g. if the request failed) and the next
+batches are sent.
+@param batches queue of the endpoint of the ids.
+*/
+void SpotifyAPI::SendIdBatches(IdBatchQueue &batches)
+{
+    while(batches.requests < maxBatchRequests && !batches.queue.isEmpty())
+    {
+        const QStringList batch = batches.queue.mid(0, batches.batchSize);
+        batches.queue.erase(batches.queue.begin(), batches.queue.begin() + batch.size());
+
+        IdBatchQueue *queue = &batches;
+        queue->requests++;
+        SendRequest("GET", ApiUrl(batches.path + "?ids=" + batch.join(',')), QByteArray(), [=](QNetworkReply *reply){
+            queue->requests--;
+            for(const QString &id : batch)
+                queue->ids.remove(id);
+
+            queue->replyHandler(reply, batch);
+            this->SendIdBatches(*queue);
+        });
+    }
+}
+
 /**
 Method to for searching a track on spotify server by name. After the request is executed
 the reply data is processed in SearchTrackReply(QNetworkReply) method.
@@ -354,7 +1072,7 @@ the reply data is processed in SearchTrackReply(QNetworkReply) method.
 */
 void SpotifyAPI::SearchTrack(QString trackName)
 {
-    QString url_search = "https://api.spotify.com/v1/search?";
+    QString url_search = apiBaseUrl + "/v1/search?";
 
     QString query = "q=";
 
@@ -365,28 +1083,26 @@ void SpotifyAPI::SearchTrack(QString trackName)
 
     QString  result = url_search + query;
 
-    cout<<"URL search = "<<result.toStdString()<<endl;
+    LOG_DEBUG("api", "URL search = " + result);
     QUrl query_url(result);
 
-    QNetworkReply * reply = connectAuth.get(query_url);
-
-    connect(reply,&QNetworkReply::finished,[=](){ this->SearchTrackReply(reply);} );
+    SendRequest("GET", query_url, QByteArray(), [=](QNetworkReply *reply){ this->SearchTrackReply(reply);} );
 }
 
 void SpotifyAPI::SearchTrackReply(QNetworkReply* network_reply)
 {
     if (network_reply->error() != QNetworkReply::NoError) {
-        cout<<"Unable to get tracks information"<<endl;
+        LOG_WARNING("api", "Unable to get tracks information: " + network_reply->errorString());
         return;
     }
 
     const auto data = network_reply->readAll();
-    const auto document = QJsonDocument::fromJson(data);
+    const auto document = ParseJson(data);
     const auto root_obj = document.object();
 
     if(!root_obj.contains("tracks"))
     {
-        qDebug()<<"Tracks not found"<<endl;
+        LOG_INFO("api", "Tracks not found");
         return;
     }
 
@@ -397,45 +1113,19 @@ void SpotifyAPI::SearchTrackReply(QNetworkReply* network_reply)
     const auto tracksReplyFull = root_obj.value("tracks").toObject();
     if(!tracksReplyFull.contains("items"))
     {
-        qDebug()<<"Tracks not found"<<endl;
+        LOG_INFO("api", "Tracks not found");
         return;
     }
 
-    QStringList headers = {"name","id","href","uri"};
-
     const auto tracksReplyArray = tracksReplyFull.value("items").toArray();
 
     //Copy tracks data from reply to target json objects
     for(int i=0; i<tracksReplyArray.size();i++)
     {
-        const auto trackReplyItem = tracksReplyArray[i].toObject();
         QJsonObject targetTrackItem;
-
-        if(!copyJsonData(headers,targetTrackItem,trackReplyItem))
+        if(!copyTrackData(tracksReplyArray[i].toObject(),targetTrackItem))
             return;
 
-        if(!trackReplyItem.contains("artists"))
-        {
-            qDebug()<<"Tracks search error: Incomplete artist data received"<<endl;
-            return;
-        }
-
-        const auto artistsReplyArray =  trackReplyItem.value("artists").toArray();
-        QJsonArray targetArtistsArray;
-
-        // For each Track item received copy artists data from reply to target json objects
-        for(int j=0;j<artistsReplyArray.size();j++)
-        {
-            QJsonObject targetArtistItem;
-            const auto artistReplyItem = artistsReplyArray[j].toObject();
-
-            if(!copyJsonData(headers,targetArtistItem,artistReplyItem))
-                return;
-
-            targetArtistsArray.append(targetArtistItem);
-        }
-
-        targetTrackItem.insert("artists",targetArtistsArray);
         targetTracksArray.append(targetTrackItem);
     }
     targeRoot.insert("tracks",targetTracksArray);
@@ -447,8 +1137,6 @@ void SpotifyAPI::SearchTrackReply(QNetworkReply* network_reply)
 
     emit UpdateOutputTextSignal(text,false);
 
-    network_reply->deleteLater();
-
 }
 
 /**
@@ -458,35 +1146,22 @@ Request performed through PUT method.
 */
 void SpotifyAPI::PlayTracks(QString uri)
 {
-    QString url_play = "https://api.spotify.com/v1/me/player/play";
-
-    QString query = "q=";
-
-    QJsonObject json_obj;
-    QJsonDocument json_doc(json_obj);
+    QUrl url_play = ApiUrl("/v1/me/player/play");
 
     //Create a Json object of the playlist or track uri to be played to send in the PUT request
+    QJsonObject json_obj;
     json_obj.insert("context_uri",uri);
 
-    auto network_manager = connectAuth.networkAccessManager();
-
-    QNetworkRequest request(url_play);
-
-    QByteArray code;
-
-    //Setting request headers
-    QString auth_header("Bearer ");
-    code.append(auth_header + connectAuth.token());
-    request.setRawHeader("Authorization", code);
+    QJsonDocument json_doc(json_obj);
 
-    auto reply = network_manager->put(request,json_doc.toBinaryData());
-    connect(reply,&QNetworkReply::finished,[=](){ this->PlayTracksReply(reply);} );
+    SendRequest("PUT", url_play, json_doc.toJson(QJsonDocument::Compact),
+                [=](QNetworkReply *reply){ this->PlayTracksReply(reply);} );
 }
 
 void SpotifyAPI::PlayTracksReply(QNetworkReply *network_reply)
 {
     const auto data = network_reply->readAll();
-    const auto document = QJsonDocument::fromJson(data);
+    const auto document = ParseJson(data);
     const auto root_obj = document.object();
 
     if (network_reply->error() != QNetworkReply::NoError) {
@@ -496,187 +1171,268 @@ void SpotifyAPI::PlayTracksReply(QNetworkReply *network_reply)
         emit UpdateOutputTextSignal(text,false);
         return;
     }
-
-    network_reply->deleteLater();
 }
 
+/**
+Method for requesting a search of artists and of their top tracks. Several artists can be searched at once,
+with their names separated by commas, and up to artistsPerQuery artists are explored for each name.
+The requests fan out instead of running in sequence: the searches of all names are sent together, then the
+data of the artists found is requested in batches through the multi-id endpoint (/v1/artists?ids=) together
+with the top tracks of each artist. The top tracks of all artists are merged, without repeated tracks, and
+sent in TracksFoundSignal after the last reply. The data of the artists (name and genres) is only written to
+the output, the tracks model has no columns for it.
+@param artistName names of the artists, separated by commas.
+*/
 void SpotifyAPI::SearchArtist(QString artistName)
 {
-    QString url = "https://api.spotify.com/v1/search?";
-
-    QString query = "q=";
-
-    artistName.replace(" ", "%20");
+    //Replies of a previous search still in flight are ignored
+    artistSearchId++;
+    pendingArtistReplies = 0;
+    artistsExplored.clear();
+    artistTracksIds.clear();
+    artistTracksArray = QJsonArray();
+    playlist.ClearPlaylist();
 
-    query +="&type=artist&limit=5";
+    const QStringList names = artistName.split(',', Qt::SkipEmptyParts);
+    for(const QString &name : names)
+    {
+        if(name.trimmed().isEmpty())
+            continue;
 
-    QString result = url + query;
+        QUrlQuery query;
+        query.addQueryItem("q", name.trimmed());
+        query.addQueryItem("type", "artist");
+        query.addQueryItem("limit", QString::number(artistsPerQuery));
 
-    QUrl queryUrl(result);
+        QUrl query_url = ApiUrl("/v1/search");
+        query_url.setQuery(query);
 
-    QNetworkReply * reply = connectAuth.get(queryUrl);
+        const int search_id = artistSearchId;
+        pendingArtistReplies++;
+        SendRequest("GET", query_url, QByteArray(), [=](QNetworkReply *reply){ this->SearchArtistReply(reply, search_id);} );
+    }
 
-    connect(reply,&QNetworkReply::finished,[=](){ this->SearchArtistReply(reply);} );
+    if(pendingArtistReplies == 0)
+        emit UpdateOutputTextSignal("Error: Artist NOT found",false);
 }
 
-void SpotifyAPI::SearchArtistReply(QNetworkReply* network_reply)
+void SpotifyAPI::SearchArtistReply(QNetworkReply* network_reply, int search_id)
 {
+    if(search_id != artistSearchId)
+        return;
+
     if (network_reply->error() != QNetworkReply::NoError) {
-        cout<<"Unable to get artist data"<<endl;
+        LOG_WARNING("api", "Unable to get artist data: " + network_reply->errorString());
+        ArtistSearchReplyFinished();
         return;
     }
 
     const auto data = network_reply->readAll();
 
-    const auto document = QJsonDocument::fromJson(data);
+    const auto document = ParseJson(data);
     const auto root_obj = document.object();
 
     const auto artists_obj = root_obj["artists"].toObject();
     const auto items_array = artists_obj["items"].toArray();
 
-    QJsonObject artist_chosen_obj;
-    if(items_array.size()>0)
+    //Artists found by other names of the search are explored once
+    QStringList artist_ids;
+    for(const auto item : items_array)
     {
-        for (int item_index = 0; item_index < items_array.size(); ++item_index)
-            QJsonObject item_obj = items_array[item_index].toObject();
+        const QString artist_id = item.toObject().value("id").toString();
+        if(artist_id.isEmpty() || artistsExplored.contains(artist_id))
+            continue;
 
-        artist_chosen_obj = items_array[0].toObject();
+        artistsExplored.insert(artist_id);
+        artist_ids.append(artist_id);
+    }
 
-        QString artistId = artist_chosen_obj.value("id").toString();
-        QString artistName = artist_chosen_obj.value("name").toString();
+    for(int first = 0; first < artist_ids.size(); first += maxArtistsPerRequest)
+        GetArtists(artist_ids.mid(first, maxArtistsPerRequest), search_id);
 
-        network_reply->deleteLater();
+    for(const QString &artist_id : qAsConst(artist_ids))
+        SearchTopTracks(artist_id, search_id);
 
-        QString text = "Artist found = " + artistName;
-        emit UpdateOutputTextSignal(text,false);
+    ArtistSearchReplyFinished();
+}
+
+/**
+Method for requesting the data of several artists in one request.
+@param artist_ids spotify ID identifiers of the artists, up to maxArtistsPerRequest.
+@param search_id artist search of the request.
+*/
+void SpotifyAPI::GetArtists(QStringList artist_ids, int search_id)
+{
+    QUrl query_url = ApiUrl("/v1/artists?ids=" + artist_ids.join(','));
 
-        QString text2 = "Artist ID = " + artistId;
-        emit UpdateOutputTextSignal(text2,false);
+    pendingArtistReplies++;
+    SendRequest("GET", query_url, QByteArray(), [=](QNetworkReply *reply){ this->GetArtistsReply(reply, search_id);} );
+}
 
-        SearchTopTracks(artistId);
+void SpotifyAPI::GetArtistsReply(QNetworkReply* network_reply, int search_id)
+{
+    if(search_id != artistSearchId)
+        return;
+
+    if (network_reply->error() != QNetworkReply::NoError) {
+        LOG_WARNING("api", "Unable to get artists data: " + network_reply->errorString());
+        ArtistSearchReplyFinished();
+        return;
     }
-    else
+
+    const auto data = network_reply->readAll();
+
+    const auto document = ParseJson(data);
+    const auto artists_array = document.object().value("artists").toArray();
+
+    for(const auto artist : artists_array)
     {
-        emit UpdateOutputTextSignal("Error: Artist NOT found",false);
-        return;
+        //Ids not found are returned as null
+        const QJsonObject artist_obj = artist.toObject();
+        if(artist_obj.isEmpty())
+            continue;
+
+        QStringList genres;
+        for(const auto genre : artist_obj.value("genres").toArray())
+            genres.append(genre.toString());
+
+        QString text = "Artist found = " + artist_obj.value("name").toString();
+        text += " (ID = " + artist_obj.value("id").toString();
+        if(!genres.isEmpty())
+            text += ", genres = " + genres.join(", ");
+        text += ")";
+
+        emit UpdateOutputTextSignal(text,false);
     }
-    network_reply->deleteLater();
 
+    ArtistSearchReplyFinished();
 }
 
 /**
 Method for requesting a search of top tracks of a given artist through its ID identifier.
 @param artist_id spotify ID identifier.
+@param search_id artist search of the request.
 */
-void SpotifyAPI::SearchTopTracks(QString artist_id)
+void SpotifyAPI::SearchTopTracks(QString artist_id, int search_id)
 {
-    playlist.ClearPlaylist();
-
-    string url_tracks1 = "https://api.spotify.com/v1/artists/";
-    string url_tracks2 = "/top-tracks?market=BR";
-
-    string artist_id_str = artist_id.toStdString();
-
-    string result =  url_tracks1 + artist_id_str + url_tracks2;
-    cout<<"query trancks of artist = "<<result<<endl<<endl;
+    QUrl query_url = ApiUrl("/v1/artists/" + artist_id + "/top-tracks?market=BR");
+    LOG_DEBUG("api", "Query tracks of artist = " + query_url.toString());
 
-    QUrl query_url(result.c_str());
-
-    auto reply = connectAuth.get(query_url);
-
-    connect(reply,&QNetworkReply::finished,[=](){ this->SearchTopTracksReply(reply);} );
+    pendingArtistReplies++;
+    SendRequest("GET", query_url, QByteArray(), [=](QNetworkReply *reply){ this->SearchTopTracksReply(reply, search_id);} );
 
 }
 
-void SpotifyAPI::SearchTopTracksReply(QNetworkReply* network_reply)
+void SpotifyAPI::SearchTopTracksReply(QNetworkReply* network_reply, int search_id)
 {
+    if(search_id != artistSearchId)
+        return;
+
     if (network_reply->error() != QNetworkReply::NoError) {
-        cout<<"Unable to retrieve top tracks data"<<endl;
+        LOG_WARNING("api", "Unable to retrieve top tracks data: " + network_reply->errorString());
+        ArtistSearchReplyFinished();
         return;
     }
 
     const auto data = network_reply->readAll();
-    cout<<"Top tracks found data = "<<data.toStdString()<<endl;
 
-    const auto document = QJsonDocument::fromJson(data);
+    const auto document = ParseJson(data);
     const auto root_obj = document.object();
     const auto tracks_array_obj = root_obj["tracks"].toArray();
 
-    if(tracks_array_obj.size()>0)
-    {
-        for (int track_index = 0; track_index < tracks_array_obj.size(); ++track_index) {
+    playlist.Reserve(playlist.TracksCount() + size_t(tracks_array_obj.size()));
 
-            QJsonObject track_obj = tracks_array_obj[track_index].toObject();
+    for (int track_index = 0; track_index < tracks_array_obj.size(); ++track_index) {
 
-            QString trackname = track_obj.value("name").toString();
-            QString trackid = track_obj.value("id").toString();
-            QString trackuri = track_obj.value("uri").toString();
+        const QJsonObject track_obj = tracks_array_obj[track_index].toObject();
 
-            SpotifyTrack track(trackname.toStdString(),trackid.toStdString(),trackuri.toStdString());
-            playlist.AddTrack(track);
-        }
+        //Tracks of several artists of the search are added once
+        const QString track_id = track_obj.value("id").toString();
+        if(artistTracksIds.contains(track_id))
+            continue;
 
-        emit ArtistTracksFoundSignal();
+        QJsonObject target_track;
+        if(!copyTrackData(track_obj, target_track))
+            continue;
+
+        artistTracksIds.insert(track_id);
+        artistTracksArray.append(target_track);
+
+        //Track is constructed in place from the converted strings, without intermediate copies
+        playlist.EmplaceTrack(track_obj.value("name").toString().toStdString(),
+                              track_id.toStdString(),
+                              track_obj.value("uri").toString().toStdString());
     }
-    network_reply->deleteLater();
-}
 
+    ArtistSearchReplyFinished();
+}
 
 /**
-*Method for requesting to create a playlist on spotify server.
-*The request is performed through POST method.
-*@param playlist_name name of spotify playlist to be created
-*@param is_public param to set if the playlist will be public or private
-*@param description Description of playlist
+Method called after each reply of an artist search. After the last reply the merged top tracks are sent
+to the interface.
 */
-void SpotifyAPI::CreatePlaylistWeb(QString playlist_name, bool is_public, QString description)
+void SpotifyAPI::ArtistSearchReplyFinished()
 {
+    if(--pendingArtistReplies > 0)
+        return;
 
-    string query = "https://api.spotify.com/v1/users/" + userName.toStdString() + "/playlists";
-    cout<<"query create playlist= "<<query<<endl<<endl;
-
-    QUrl query_url(query.c_str());
-
-    //Set playlist data to send in request
-    QJsonObject playlist_obj;
-    playlist_obj.insert("name", QJsonValue::fromVariant(playlist_name));
-    playlist_obj.insert("description", QJsonValue::fromVariant(description));
-    playlist_obj.insert("public", QJsonValue::fromVariant(is_public));
+    if(artistsExplored.isEmpty())
+    {
+        emit UpdateOutputTextSignal("Error: Artist NOT found",false);
+        return;
+    }
 
-    QJsonDocument playlist_doc(playlist_obj);
+    emit UpdateOutputTextSignal(QString("Tracks found for %1 artists : %2")
+                                .arg(artistsExplored.size()).arg(artistTracksArray.size()),false);
 
-    auto network_manager = connectAuth.networkAccessManager();
+    emit TracksFoundSignal(QJsonObject({{"tracks", artistTracksArray}}));
 
-    //Set headers of request
-    QNetworkRequest request(query_url);
-    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    if(playlist.TracksCount() > 0)
+        emit ArtistTracksFoundSignal();
+}
 
-    QByteArray code;
-    code.append("application/json");
-    request.setRawHeader("Accept",code);
+/**
+*Method to get the playlist of tracks found by the last top tracks search, or created on spotify server.
+*@return reference to the playlist, valid until the next search or playlist creation.
+*/
+const SpotifyPlaylist &SpotifyAPI::GetPlaylist() const
+{
+    return playlist;
+}
 
-    QString auth_header("Bearer ");
+/**
+*Method to queue the creation of a playlist on spotify server. The playlist is created when the application is
+*connected, meanwhile tracks can be added to it with the local id returned.
+*@param playlist_name name of spotify playlist to be created
+*@param is_public param to set if the playlist will be public or private
+*@param description Description of playlist
+*@param local_id local id given to the playlist (see OperationQueue::NewLocalId), empty to create a new one
+*@return local id of the playlist, replaced by the server id when PlaylistCreatedSignal is emitted
+*/
+QString SpotifyAPI::CreatePlaylistWeb(QString playlist_name, bool is_public, QString description, QString local_id)
+{
+    local_id = operationQueue.CreatePlaylist(playlist_name, is_public, description, local_id);
+    LOG_DEBUG("api", "Create playlist queued, local id = " + local_id);
 
-    code.clear();
-    code.append(auth_header + connectAuth.token());
-    request.setRawHeader("Authorization", code);
+    playlist.SetId(local_id.toStdString());
+    playlist.SetName(playlist_name.toStdString());
 
-    // Send request
-    auto reply = network_manager->post(request, playlist_doc.toJson());
-    connect(reply,&QNetworkReply::finished,[=](){ this->CreatePlaylistReply(reply);} );
+    SendQueuedOperations();
 
+    return local_id;
 }
 
-void SpotifyAPI::CreatePlaylistReply(QNetworkReply* network_reply)
+void SpotifyAPI::CreatePlaylistReply(QNetworkReply* network_reply, QueuedOperation operation)
 {
     if (network_reply->error() != QNetworkReply::NoError) {
-        qDebug()<<"Unable criate playlist"<<endl;
+        LOG_WARNING("api", "Unable to create playlist: " + network_reply->errorString());
+        OperationFinished(operation, network_reply);
         return;
     }
 
     const auto data = network_reply->readAll();
 
-    const auto document = QJsonDocument::fromJson(data);
+    const auto document = ParseJson(data);
     const auto root_obj = document.object();
     QString name = root_obj.value("name").toString();
     QString id = root_obj.value("id").toString();
@@ -688,78 +1444,323 @@ void SpotifyAPI::CreatePlaylistReply(QNetworkReply* network_reply)
     text+= "id: " + id + "\n";
     text+= "uri: " + uri + "\n";
 
-    playlist.SetId(id.toStdString());
-    playlist.SetName(name.toStdString());
-    playlist.SetURI(uri.toStdString());
+    if(playlist.GetId() == operation.playlistId.toStdString())
+    {
+        playlist.SetId(id.toStdString());
+        playlist.SetURI(uri.toStdString());
+    }
 
     emit UpdateOutputTextSignal(text,false);
 
-    network_reply->deleteLater();
+    //The operations of the playlist waiting for its creation are sent with the server id
+    operationQueue.Finished(operation.id, id);
+    playlistSync.SetServerTracks(id, QStringList());
+    emit PlaylistCreatedSignal(operation.playlistId, root_obj);
 
+    SendQueuedOperations();
 }
 
 /**
 Method for requesting to add tracks to a given playlist on spotify server.
 This method requires that a class of SpotifyPlaylist be set.
+The tracks are queued as one operation, appended in batches of PlaylistSync::maxTracksPerRequest tracks
+(the limit of the server), whose bodies are written straight from the uris (see PlaylistEdit::Body).
 */
 void SpotifyAPI::AddTracksPlaylistWeb()
 {
     if(!playlist.GetId().empty())
     {
-        string query = "https://api.spotify.com/v1/playlists/" + playlist.GetId() + "/tracks?";
-
-        //Set tracks uri's chosen to be inserted in playlist
-        string tracks_query = "uris=" + playlist.GetTracksUrisListStr(",");
-        query += tracks_query;
+        QStringList uris;
+        uris.reserve(int(playlist.TracksCount()));
+        for(const SpotifyTrack &track : playlist.GetTracks())
+            uris.append(QString::fromStdString(track.GetURI()));
 
-        QUrl query_url(query.c_str());
+        AddTracksWeb(QString::fromStdString(playlist.GetId()), uris);
+    }
+}
 
-        auto network_manager = connectAuth.networkAccessManager();
+/**
+Method to queue tracks appended to a playlist on spotify server.
+@param playlist_id id of the playlist, server id or local id returned by CreatePlaylistWeb().
+@param uris uris of the tracks.
+*/
+void SpotifyAPI::AddTracksWeb(QString playlist_id, QStringList uris)
+{
+    operationQueue.AddTracks(playlist_id, uris);
+    SendQueuedOperations();
+}
 
-        //Set request data header
-        QNetworkRequest request(query_url);
-        request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+/**
+Method to queue tracks removed from a playlist on spotify server. Tracks added by operations still
+waiting are removed from those operations instead.
+@param playlist_id id of the playlist, server id or local id returned by CreatePlaylistWeb().
+@param uris uris of the tracks, one occurrence of each uri is removed.
+*/
+void SpotifyAPI::RemoveTracksWeb(QString playlist_id, QStringList uris)
+{
+    operationQueue.RemoveTracks(playlist_id, uris);
+    SendQueuedOperations();
+}
 
-        QByteArray code;
-        code.append("application/json");
-        request.setRawHeader("Accept",code);
+/**
+Method to push the local tracks of a playlist to spotify server. Only the differences to the tracks last known
+on the server are sent (see PlaylistSync), when the operation is sent. The push replaces the adds, removals and
+pushes of the playlist still waiting.
+@param playlist_id id of the playlist.
+@param local_uris uris of the local tracks in playlist order.
+*/
+void SpotifyAPI::PushPlaylist(QString playlist_id, QStringList local_uris)
+{
+    operationQueue.PushPlaylist(playlist_id, local_uris);
+    SendQueuedOperations();
+}
 
-        QString auth_header("Bearer ");
+int SpotifyAPI::QueuedOperationsCount() const
+{
+    return operationQueue.Count();
+}
 
-        code.clear();
-        code.append(auth_header + connectAuth.token());
-        request.setRawHeader("Authorization", code);
+/**
+Method called by the retry timer of the operations. While the operations wait for the access and the refresh
+of the token failed (e.g. the network was lost during the refresh), the refresh is tried again instead.
+*/
+void SpotifyAPI::RetryQueuedOperations()
+{
+    if(operationsWaitAccess)
+    {
+        //Without refresh token only a new connection grants the access
+        if(connectAuth.refreshToken().isEmpty())
+            return;
 
-        // Send request
-        auto reply = network_manager->post(request, QByteArray());
-        connect(reply,&QNetworkReply::finished,[=](){ this->AddTracksPlaylistReply(reply);} );
+        if(refreshFailed && !refreshingToken)
+            RefreshToken();
+        if(refreshFailed || refreshingToken)
+            operationsRetryTimer.start();
+        return;
     }
+
+    SendQueuedOperations();
 }
 
-void SpotifyAPI::AddTracksPlaylistReply(QNetworkReply* network_reply)
+/**
+Method to send the queued operations that are ready, up to maxOperationsInFlight at the same time. Nothing is
+sent while the application is not connected or the access was refused, until the access is granted again.
+Operations on tracks wait for the server tracks of their playlist, recorded by the playlists sync or when the
+playlist is created.
+*/
+void SpotifyAPI::SendQueuedOperations()
 {
-    if (network_reply->error() != QNetworkReply::NoError) {
-        qDebug()<<"Unable add tracks to playlist"<<endl;
-        const auto data = network_reply->readAll();
-        qDebug()<<"Error body data ="<<data<<endl;
+    if(!isConnected || operationsWaitAccess)
+        return;
 
+    const auto ready = operationQueue.TakeReady(maxOperationsInFlight, [=](const QueuedOperation &operation){
+        if(operation.type == QueuedOperation::CreatePlaylist)
+            return !userName.isEmpty();
+        return playlistSync.HasServerTracks(operation.playlistId);
+    });
+
+    for(const QueuedOperation &operation : ready)
+        SendOperation(operation);
+}
+
+/**
+Method to send a queued operation. Operations on tracks are converted to edits of the tracks endpoint when
+they are sent, from the server tracks known at that time, and the edits are sent in sequence.
+@param operation operation sent.
+*/
+void SpotifyAPI::SendOperation(const QueuedOperation &operation)
+{
+    if(operation.type == QueuedOperation::CreatePlaylist)
+    {
+        SendRequest("POST", ApiUrl("/v1/users/" + userName + "/playlists"),
+                    QJsonDocument(operation.details).toJson(QJsonDocument::Compact),
+                    [=](QNetworkReply *reply){ this->CreatePlaylistReply(reply, operation);} );
         return;
     }
 
-    const auto data = network_reply->readAll();
+    //An add sent before may have been applied without its reply being received (see OperationQueue)
+    if(operation.type == QueuedOperation::AddTracks && operation.sent && EndsWithTracks(operation))
+    {
+        LOG_INFO("api", "Tracks added to playlist " + operation.playlistId + " before, not sent again");
+        OperationFinished(operation, nullptr);
+        return;
+    }
 
-    const auto document = QJsonDocument::fromJson(data);
-    const auto root_obj = document.object();
+    QVector<PlaylistEdit> edits;
+    if(operation.type == QueuedOperation::AddTracks)
+        edits = playlistSync.AppendEdits(operation.playlistId, operation.uris);
+    else if(operation.type == QueuedOperation::RemoveTracks)
+        edits = playlistSync.RemoveEdits(operation.playlistId, operation.uris);
+    else
+        edits = playlistSync.Diff(operation.playlistId, operation.uris);
 
-    QString text = "Tracks added succesfully";
-    text += "snapshot_id = " + root_obj.value("snapshot_id").toString();
-    emit UpdateOutputTextSignal(text,false);
+    if(edits.isEmpty())
+    {
+        OperationFinished(operation, nullptr);
+        return;
+    }
 
-    network_reply->deleteLater();
+    LOG_INFO("api", QString("Sending %1 changes of playlist %2").arg(edits.size()).arg(operation.playlistId));
+    SendPlaylistEdit(operation, edits, 0);
+}
+
+/**
+Method to check if the tracks of a playlist on the server end with the tracks of an add.
+@param operation add of tracks.
+@return true if the last tracks of the playlist are the tracks of the add.
+*/
+bool SpotifyAPI::EndsWithTracks(const QueuedOperation &operation) const
+{
+    const QStringList server_uris = playlistSync.ServerTracks(operation.playlistId);
+    const int first = server_uris.size() - operation.uris.size();
+
+    return first >= 0 && server_uris.mid(first) == operation.uris;
+}
+
+/**
+Method to send an edit of an operation, the next edit is sent after the server applies it. The server
+tracks recorded are updated after each edit, so they stay known if a request fails.
+@param operation operation of the edit.
+@param edits edits of the operation.
+@param edit_index position of the edit sent.
+*/
+void SpotifyAPI::SendPlaylistEdit(QueuedOperation operation, QVector<PlaylistEdit> edits, int edit_index)
+{
+    const PlaylistEdit &edit = edits[edit_index];
+    const QString playlist_id = operation.playlistId;
+    const QByteArray body = edit.Body(playlistSync.SnapshotId(playlist_id));
+
+    SendRequest(edit.Verb(), ApiUrl("/v1/playlists/" + playlist_id + "/tracks"), body, [=](QNetworkReply *reply){
+        if(reply->error() != QNetworkReply::NoError)
+        {
+            LOG_WARNING("api", "Unable to send changes of playlist " + playlist_id + ": " + reply->errorString());
+            LOG_DEBUG("api", "Error body data = " + QString::fromUtf8(reply->readAll()));
+
+            //Adds and removals applied in part are sent again without the tracks already applied
+            if(edit_index > 0)
+                this->KeepUnsentEdits(operation, edits, edit_index);
+
+            this->OperationFinished(operation, reply);
+            return;
+        }
+
+        //The edit doesn't apply to the tracks recorded: the server has other tracks, which are fetched
+        //again, and the rest of the operation is sent from them
+        QStringList server_uris = playlistSync.ServerTracks(playlist_id);
+        if(!PlaylistSync::Apply(server_uris, edits[edit_index]))
+        {
+            this->ResyncServerTracks(playlist_id);
+
+            if(operation.type != QueuedOperation::PushPlaylist && edit_index + 1 == edits.size())
+            {
+                this->OperationFinished(operation, nullptr);
+                return;
+            }
+
+            this->KeepUnsentEdits(operation, edits, edit_index + 1);
+            operationQueue.Retry(operation.id);
+            return;
+        }
+
+        const QString snapshot_id = ParseJson(reply->readAll()).object().value("snapshot_id").toString();
+        playlistSync.SetServerTracks(playlist_id, server_uris, snapshot_id);
+
+        if(edit_index + 1 < edits.size())
+            this->SendPlaylistEdit(operation, edits, edit_index + 1);
+        else
+            this->OperationFinished(operation, nullptr);
+    });
+}
+
+/**
+Method to keep in the queue only the tracks of an add or removal not sent yet, so the tracks already applied
+are not sent again. Pushes are computed again from the server tracks when they are sent.
+@param operation operation applied in part.
+@param edits edits of the operation.
+@param first_edit first edit not applied.
+*/
+void SpotifyAPI::KeepUnsentEdits(const QueuedOperation &operation, const QVector<PlaylistEdit> &edits, int first_edit)
+{
+    if(operation.type == QueuedOperation::PushPlaylist)
+        return;
 
+    QStringList remaining;
+    for(int i = first_edit; i < edits.size(); i++)
+        remaining.append(edits[i].uris);
+    operationQueue.Update(operation.id, remaining);
+}
+
+/**
+Method called when a queued operation finishes. Operations that failed for a network or server error (or
+too many requests, or a timeout) are sent again after operationsRetryMs. Operations refused for the access
+(401 with a stale token after a failed refresh, 403 for an expired or missing scope) are kept and the queue
+waits until the access is granted again (see AccessGranted). For a 401 the refresh of the token is started,
+and tried again after operationsRetryMs while it fails.
+Only the other client errors (e.g. 400, 404) are final and the operation is discarded: a rejected edit means
+the playlist changed on the server, so its tracks are fetched again before the next operations of the playlist
+are sent. The next operations ready are sent.
+@param operation operation finished.
+@param network_reply reply of the failed request, nullptr if the operation was applied.
+*/
+void SpotifyAPI::OperationFinished(const QueuedOperation &operation, QNetworkReply *network_reply)
+{
+    bool applied = true;
+
+    if(network_reply && network_reply->error() != QNetworkReply::NoError)
+    {
+        const int status = network_reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        applied = false;
+
+        if(status == 401 || status == 403)
+        {
+            LOG_WARNING("api", QString("Operation on playlist %1 refused (%2), waiting for access")
+                        .arg(operation.playlistId).arg(status));
+            operationQueue.Retry(operation.id);
+            operationsWaitAccess = true;
+
+            if(status == 401)
+            {
+                RefreshToken();
+                if(!operationsRetryTimer.isActive())
+                    operationsRetryTimer.start();
+            }
+            return;
+        }
+
+        if(status >= 400 && status < 500 && status != 408 && status != 429)
+        {
+            LOG_ERROR("api", QString("Operation on playlist %1 rejected by server (%2), discarded")
+                      .arg(operation.playlistId).arg(status));
+            operationQueue.Discard(operation.id);
+
+            if(operation.type != QueuedOperation::CreatePlaylist)
+                ResyncServerTracks(operation.playlistId);
+        }
+        else
+        {
+            operationQueue.Retry(operation.id);
+            if(!operationsRetryTimer.isActive())
+                operationsRetryTimer.start();
+            return;
+        }
+    }
+    else
+    {
+        operationQueue.Finished(operation.id);
+    }
+
+    if(operation.type == QueuedOperation::PushPlaylist)
+        emit PlaylistPushedSignal(operation.playlistId, applied);
+
+    SendQueuedOperations();
 }
 
 SpotifyAPI::~SpotifyAPI()
 {
+    //The coroutines of the sync are resumed and return before the object is released
+    syncCancel.Cancel();
+
+    //Changes of the operations queue waiting to be written
+    operationQueue.Save();
     delete replyHandler;
 }
@@ -6,17 +6,43 @@
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QNetworkAccessManager>
+#include <QNetworkReply>
 #include <QOAuth2AuthorizationCodeFlow>
-#include <QDesktopServices>
 #include <QXmlStreamReader>
 #include <QFile>
+#include <QTimer>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QUrlQuery>
+#include <QJsonArray>
+#include <QSet>
 #include <iostream>
 #include <sstream>
+#include <functional>
 #include "models/spotifyutils.h"
 #include "models/treemodel.h"
+#include "utils/networkmetrics.h"
+#include "api/playlistsync.h"
+#include "api/operationqueue.h"
+#include "api/asynctask.h"
 
 using namespace std;
 
+/**
+ * Reply of a request awaited with co_await (see SpotifyAPI::Request). The data of the reply is copied, so it
+ * can be used after the QNetworkReply is released. Requests of a cancelled flow return a reply cancelled.
+ */
+struct ApiReply
+{
+    int status;
+    QNetworkReply::NetworkError error;
+    QString errorString;
+    QByteArray data;
+    bool cancelled;
+
+    bool IsOk() const;
+};
+
 class SpotifyAPI: public QObject
 {
     Q_OBJECT
@@ -26,31 +52,47 @@ public:
     ~SpotifyAPI();
 
     bool ReadUserKeys(const char* fileName);
+    bool HasUserKeys() const;
+    void SetServerUrls(QString apiUrl, QString accountsUrl);
     void ConnectToServer();
     bool IsConnected();
     bool IsProcessingRequest();
 
-    void GetUserName(QNetworkReply* network_reply);
-
-    void GetCurrentPlaylists();
-    void GetCurrentPlaylistsReply(QNetworkReply *network_reply);
-
-    void GetPlaylistsTracks();
-    void GetPlaylistsTracksReply(QNetworkReply *network_reply, int indice);
+    Task<ApiReply> Request(QByteArray verb, QUrl url, QByteArray body = QByteArray(),
+                           CancellationToken cancel = CancellationToken());
+    Task<QJsonObject> GetPages(QUrl url, CancellationToken cancel = CancellationToken());
+    Task<void> SyncLibrary(CancellationToken cancel);
+    void CancelSync();
 
     bool SavePlaylistsJsonFromWeb(QString fileName);
+    void SetPlaylistsFromWeb(QJsonObject playlistsJson, vector<QJsonObject> playlistsTracksJson);
+    void SetPlaylistsFileName(QString fileName);
+    void SetOperationsFileName(QString fileName);
 
     void SearchArtist(QString artistName);
-    void SearchArtistReply(QNetworkReply* network_reply);
+    void SearchArtistReply(QNetworkReply* network_reply, int search_id);
 
-    void SearchTopTracks(QString artist_id);
-    void SearchTopTracksReply(QNetworkReply* network_reply);
+    void GetArtists(QStringList artist_ids, int search_id);
+    void GetArtistsReply(QNetworkReply* network_reply, int search_id);
 
-    void CreatePlaylistWeb(QString playlist_name, bool is_public, QString description);
-    void CreatePlaylistReply(QNetworkReply* network_reply);
+    void SearchTopTracks(QString artist_id, int search_id);
+    void SearchTopTracksReply(QNetworkReply* network_reply, int search_id);
+
+    QString CreatePlaylistWeb(QString playlist_name, bool is_public, QString description, QString local_id = QString());
+    void CreatePlaylistReply(QNetworkReply* network_reply, QueuedOperation operation);
 
     void AddTracksPlaylistWeb();
-    void AddTracksPlaylistReply(QNetworkReply* network_reply);
+    void AddTracksWeb(QString playlist_id, QStringList uris);
+    void RemoveTracksWeb(QString playlist_id, QStringList uris);
+
+    void PushPlaylist(QString playlist_id, QStringList local_uris);
+    int QueuedOperationsCount() const;
+
+    void HydrateTracks(QStringList track_ids);
+    void HydrateTracksReply(QNetworkReply *network_reply, QStringList track_ids);
+
+    void GetAudioFeatures(QStringList track_ids);
+    void GetAudioFeaturesReply(QNetworkReply *network_reply, QStringList track_ids);
 
     void SearchTrack(QString name);
     void SearchTrackReply(QNetworkReply *network_reply);
@@ -58,41 +100,170 @@ public:
     void PlayTracks(QString uri);
     void PlayTracksReply(QNetworkReply *network_reply);
 
-    SpotifyPlaylist GetPlaylist();
+    const SpotifyPlaylist &GetPlaylist() const;
+
+    NetworkMetrics &Metrics();
 
 
 private slots:
     void AccessGranted();
     void AuthStatusChanged(QAbstractOAuth::Status status);
+    void RefreshToken();
+    void RefreshTokenFailed(const QString &error, const QString &errorDescription);
+    void RefreshTokenTimeout();
 
 signals:
     void UpdateOutputTextSignal(QString text, bool clear);
+    void AuthorizeUrlSignal(const QUrl &url);
     void ConnectedSignal();
+    void PlaylistsSyncedSignal(bool saved);
     void ArtistTracksFoundSignal();
     void TracksFoundSignal(QJsonObject data);
+    void TracksHydratedSignal(QJsonArray tracks);
+    void AudioFeaturesSignal(QJsonArray features);
+    void PlaylistPushedSignal(QString playlist_id, bool pushed);
+    void PlaylistCreatedSignal(QString local_id, QJsonObject playlist);
 
 
 private:
 
     bool copyJsonData(QStringList jsonHeaders, QJsonObject &destData, QJsonObject sourceData);
+    bool copyTrackData(const QJsonObject &sourceTrack, QJsonObject &destTrack);
+
+    /**
+     * Request waiting to be sent, kept so it can be queued while the token is refreshed
+     * and replayed if the server rejects the token.
+     */
+    struct PendingRequest
+    {
+        QByteArray verb;
+        QUrl url;
+        QByteArray body;
+        std::function<void(QNetworkReply*)> replyHandler;
+        bool replayed;
+        int rateLimitRetries;
+        CancellationToken cancel;
+    };
+
+    /**
+     * Awaiter of a request: the coroutine awaiting it is suspended until the reply of the request, or
+     * until the flow of the request is cancelled (the request in flight is aborted).
+     */
+    class RequestAwaiter
+    {
+    public:
+        RequestAwaiter(SpotifyAPI *spotifyApi, PendingRequest pendingRequest);
+
+        bool await_ready() const;
+        void await_suspend(std::coroutine_handle<> handle);
+        ApiReply await_resume();
+
+    private:
+        struct State
+        {
+            ApiReply reply;
+            bool resumed;
+            int cancelHandler;
+        };
+
+        SpotifyAPI *api;
+        PendingRequest request;
+        std::shared_ptr<State> state;
+    };
+
+    QUrl ApiUrl(const QString &path);
+    QNetworkRequest BuildRequest(const QUrl &url);
+    void SendRequest(const QByteArray &verb, const QUrl &url, const QByteArray &body,
+                     std::function<void(QNetworkReply*)> replyHandler);
+    void DispatchRequest(PendingRequest request);
+    QJsonDocument ParseJson(const QByteArray &data);
+    void ReplayPendingRequests();
+    void FinishPlaylistsSync();
+    void ArtistSearchReplyFinished();
+    struct IdBatchQueue;
+    void QueueIds(IdBatchQueue &batches, const QStringList &ids);
+    void SendIdBatches(IdBatchQueue &batches);
+    void RecordServerPlaylists();
+    static QStringList TracksUris(const QJsonObject &tracks_json);
+    Task<void> FetchServerTracks(QString playlist_id);
+    void ResyncServerTracks(const QString &playlist_id);
+    void SendQueuedOperations();
+    void RetryQueuedOperations();
+    void SendOperation(const QueuedOperation &operation);
+    bool EndsWithTracks(const QueuedOperation &operation) const;
+    void SendPlaylistEdit(QueuedOperation operation, QVector<PlaylistEdit> edits, int edit_index);
+    void KeepUnsentEdits(const QueuedOperation &operation, const QVector<PlaylistEdit> &edits, int first_edit);
+    void OperationFinished(const QueuedOperation &operation, QNetworkReply *network_reply);
+    void ScheduleTokenRefresh();
+    bool IsTokenExpired();
 
     bool isConnected;
+    QNetworkAccessManager* networkManager;
     QOAuthHttpServerReplyHandler* replyHandler;
     QOAuth2AuthorizationCodeFlow connectAuth;
     bool processingRequest;
     QString clientId;
     QString clientSecret;
+    QString apiBaseUrl;
+    QString accountsBaseUrl;
     QString userName;
 
-    QString token;
+    QTimer tokenRefreshTimer;
+    bool refreshingToken;
+
+    //Refresh without answer is given up by the watchdog. After a failed refresh expired tokens are not
+    //refreshed before sending, until a refresh or connection succeeds
+    QTimer tokenRefreshWatchdog;
+    bool refreshFailed;
+    bool refreshTimedOut;
+    QList<PendingRequest> pendingRequests;
 
-    vector<QString> artistTracksUri;
+    //Queued operations refused for the access wait until the access is granted again
+    bool operationsWaitAccess;
+
+    //Metrics of requests by endpoint, and endpoint of the reply being handled (parse time is added to it)
+    NetworkMetrics metrics;
+    QString handlingEndpoint;
+
+    //Artist search in progress: replies of previous searches are ignored, the top tracks of the artists found
+    //are merged while their replies arrive
+    int artistSearchId;
+    int pendingArtistReplies;
+    QSet<QString> artistsExplored;
+    QSet<QString> artistTracksIds;
+    QJsonArray artistTracksArray;
+
+    /**
+     * Ids waiting to be requested in batches from a multi-id endpoint (path?ids=), ids queued or in flight
+     * (requested once) and requests in flight. The handler receives the reply of each batch with its ids.
+     */
+    struct IdBatchQueue
+    {
+        QString path;
+        int batchSize;
+        QStringList queue;
+        QSet<QString> ids;
+        int requests;
+        std::function<void(QNetworkReply*, QStringList)> replyHandler;
+    };
+
+    IdBatchQueue hydrationBatches;
+    IdBatchQueue featuresBatches;
     SpotifyPlaylist playlist;
     vector<SpotifyPlaylist> playlistsUserArray;
-    vector<SpotifyPlaylist> userPlaylistsArray;
 
+    //Library sync in progress (user, playlists and their tracks), cancelled when a new sync starts
+    CancellationSource syncCancel;
     QJsonObject userPlaylistsJson;
     vector<QJsonObject> userPlaylistsFullJson;
+    QString playlistsFileName;
+
+    //Tracks of the playlists as last known on the server, and write operations waiting to be sent
+    PlaylistSync playlistSync;
+    QSet<QString> fetchingPlaylists;
+    OperationQueue operationQueue;
+    QTimer operationsRetryTimer;
+    QTimer operationsSaveTimer;
 
 
 };
@@ -0,0 +1,102 @@
+#include "allocationcounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <sys/resource.h>
+
+static std::atomic<unsigned long long> allocationsCount(0);
+static std::atomic<unsigned long long> allocatedBytes(0);
+
+static inline void CountAllocation(std::size_t size)
+{
+    allocationsCount.fetch_add(1, std::memory_order_relaxed);
+    allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+#ifdef __GLIBC__
+//Qt containers allocate through malloc, so the C allocation functions are also replaced.
+extern "C" {
+void *__libc_malloc(std::size_t size);
+void *__libc_calloc(std::size_t count, std::size_t size);
+void *__libc_realloc(void *ptr, std::size_t size);
+void __libc_free(void *ptr);
+
+void *malloc(std::size_t size)
+{
+    CountAllocation(size);
+    return __libc_malloc(size);
+}
+
+void *calloc(std::size_t count, std::size_t size)
+{
+    CountAllocation(count * size);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, std::size_t size)
+{
+    CountAllocation(size);
+    return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr)
+{
+    __libc_free(ptr);
+}
+}
+#endif
+
+void *operator new(std::size_t size)
+{
+#ifndef __GLIBC__
+    CountAllocation(size);
+#endif
+    void *ptr = std::malloc(size ? size : 1);
+    if(!ptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void *operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void AllocationCounter::Reset()
+{
+    allocationsCount.store(0);
+    allocatedBytes.store(0);
+}
+
+unsigned long long AllocationCounter::Allocations()
+{
+    return allocationsCount.load();
+}
+
+unsigned long long AllocationCounter::Bytes()
+{
+    return allocatedBytes.load();
+}
+
+/**
+Method to get the peak resident memory of the process.
+@return peak resident set size in kilobytes.
+*/
+long AllocationCounter::PeakRssKb()
+{
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) != 0)
+        return -1;
+    return usage.ru_maxrss;
+}
@@ -0,0 +1,20 @@
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+/**
+ * Implementation of AllocationCounter to measure heap usage of benchmarked code.
+ *
+ * The global allocation functions (operator new/delete and, on glibc, malloc/calloc/realloc used by Qt
+ * containers) are replaced in the benchmark executable to count the number of allocations and bytes
+ * requested since the last Reset(). Peak resident memory of the process is read from the system.
+ */
+class AllocationCounter
+{
+public:
+    static void Reset();
+    static unsigned long long Allocations();
+    static unsigned long long Bytes();
+    static long PeakRssKb();
+};
+
+#endif // ALLOCATIONCOUNTER_H
@@ -0,0 +1,183 @@
+#include "librarygenerator.h"
+
+#include <QtGlobal>
+
+static quint32 Mix(quint32 a, quint32 b)
+{
+    quint32 h = (a * 0x9E3779B1u) ^ (b + 0x7F4A7C15u + (a << 6) + (a >> 2));
+    h ^= h >> 16;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35u;
+    h ^= h >> 16;
+    return h;
+}
+
+/**
+Constructor of the generator. The pools of distinct tracks and artists are proportional to the library
+size: about half of the tracks of the library are distinct and each artist has about ten tracks.
+@param playlistsCount number of playlists.
+@param tracksCount number of tracks of each playlist.
+@param artistsCount number of artists of each track.
+@param seedValue seed of the generated data.
+*/
+LibraryGenerator::LibraryGenerator(int playlistsCount, int tracksCount, int artistsCount, unsigned int seedValue)
+    : playlists(playlistsCount),
+      tracksPerPlaylist(tracksCount),
+      artistsPerTrack(artistsCount),
+      seed(seedValue)
+{
+    trackPool = qMax(1, playlists * tracksPerPlaylist / 2);
+    artistPool = qMax(1, trackPool / 10);
+}
+
+LibraryGenerator LibraryGenerator::FromEnvironment()
+{
+    int playlists = qEnvironmentVariableIsSet("BENCH_PLAYLISTS") ? qEnvironmentVariableIntValue("BENCH_PLAYLISTS") : 20;
+    int tracks = qEnvironmentVariableIsSet("BENCH_TRACKS") ? qEnvironmentVariableIntValue("BENCH_TRACKS") : 500;
+    int artists = qEnvironmentVariableIsSet("BENCH_ARTISTS") ? qEnvironmentVariableIntValue("BENCH_ARTISTS") : 2;
+
+    return LibraryGenerator(qMax(1, playlists), qMax(1, tracks), qMax(1, artists));
+}
+
+int LibraryGenerator::PlaylistsCount() const
+{
+    return playlists;
+}
+
+int LibraryGenerator::TracksPerPlaylist() const
+{
+    return tracksPerPlaylist;
+}
+
+int LibraryGenerator::ArtistsPerTrack() const
+{
+    return artistsPerTrack;
+}
+
+QString LibraryGenerator::Id(char kind, int index) const
+{
+    return QChar(kind) + QString("%1").arg(index, 21, 10, QChar('0'));
+}
+
+int LibraryGenerator::PlaylistTrack(int playlist, int position) const
+{
+    return int(Mix(seed ^ quint32(playlist), quint32(position)) % quint32(trackPool));
+}
+
+int LibraryGenerator::TrackArtist(int track, int position) const
+{
+    return int(Mix(seed + quint32(track), quint32(position) + 7919u) % quint32(artistPool));
+}
+
+QJsonObject LibraryGenerator::ArtistJson(int artist) const
+{
+    const QString id = Id('a', artist);
+
+    return QJsonObject({{"name", QString("Artist %1").arg(artist)},
+                        {"id", id},
+                        {"href", "https://api.spotify.com/v1/artists/" + id},
+                        {"uri", "spotify:artist:" + id}});
+}
+
+QJsonObject LibraryGenerator::TrackJson(int track) const
+{
+    const QString id = Id('t', track);
+
+    QJsonArray artists;
+    for(int k = 0; k < artistsPerTrack; k++)
+        artists.append(ArtistJson(TrackArtist(track, k)));
+
+    return QJsonObject({{"name", QString("Track %1").arg(track)},
+                        {"id", id},
+                        {"href", "https://api.spotify.com/v1/tracks/" + id},
+                        {"uri", "spotify:track:" + id},
+                        {"artists", artists}});
+}
+
+QJsonObject LibraryGenerator::PlaylistJson(int playlist) const
+{
+    const QString id = Id('p', playlist);
+
+    return QJsonObject({{"name", QString("Playlist %1").arg(playlist)},
+                        {"id", id},
+                        {"href", "https://api.spotify.com/v1/playlists/" + id},
+                        {"uri", "spotify:playlist:" + id}});
+}
+
+/**
+Method to create the library in the format of playlists file loaded by TreeModel::loadModelData().
+*/
+QJsonObject LibraryGenerator::ModelJson() const
+{
+    QJsonArray playlistsArray;
+    for(int i = 0; i < playlists; i++)
+    {
+        QJsonArray tracks;
+        for(int j = 0; j < tracksPerPlaylist; j++)
+            tracks.append(TrackJson(PlaylistTrack(i, j)));
+
+        QJsonObject playlist = PlaylistJson(i);
+        playlist.insert("tracks", tracks);
+        playlistsArray.append(playlist);
+    }
+
+    return QJsonObject({{"info", "Synthetic library"}, {"playlists", playlistsArray}});
+}
+
+/**
+Method to create the reply of current user playlists request received by SpotifyAPI.
+*/
+QJsonObject LibraryGenerator::PlaylistsReplyJson() const
+{
+    QJsonArray items;
+    for(int i = 0; i < playlists; i++)
+    {
+        QJsonObject playlist = PlaylistJson(i);
+        playlist.insert("tracks", QJsonObject({{"href", playlist.value("href").toString() + "/tracks"},
+                                               {"total", tracksPerPlaylist}}));
+        items.append(playlist);
+    }
+
+    return QJsonObject({{"items", items}, {"total", playlists}});
+}
+
+/**
+Method to create the replies of playlists tracks requests received by SpotifyAPI, one per playlist.
+*/
+std::vector<QJsonObject> LibraryGenerator::PlaylistsTracksReplyJson() const
+{
+    std::vector<QJsonObject> replies;
+    for(int i = 0; i < playlists; i++)
+    {
+        QJsonArray items;
+        for(int j = 0; j < tracksPerPlaylist; j++)
+            items.append(QJsonObject({{"track", TrackJson(PlaylistTrack(i, j))}}));
+
+        replies.push_back(QJsonObject({{"items", items}, {"total", tracksPerPlaylist}}));
+    }
+
+    return replies;
+}
+
+/**
+Method to create a SpotifyPlaylist object with the tracks of a playlist of the library.
+@param playlist index of the playlist.
+*/
+SpotifyPlaylist LibraryGenerator::Playlist(int playlist) const
+{
+    SpotifyPlaylist result;
+    result.SetId(Id('p', playlist).toStdString());
+    result.SetName(QString("Playlist %1").arg(playlist).toStdString());
+
+    result.Reserve(size_t(tracksPerPlaylist));
+    for(int j = 0; j < tracksPerPlaylist; j++)
+    {
+        const int track = PlaylistTrack(playlist, j);
+        std::string id = Id('t', track).toStdString();
+        std::string uri = "spotify:track:" + id;
+        result.EmplaceTrack(QString("Track %1").arg(track).toStdString(), std::move(id), std::move(uri));
+    }
+
+    return result;
+}
@@ -0,0 +1,52 @@
+#ifndef LIBRARYGENERATOR_H
+#define LIBRARYGENERATOR_H
+
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QString>
+#include <vector>
+#include "models/spotifyutils.h"
+
+/**
+ * Implementation of LibraryGenerator to create synthetic spotify libraries for benchmarks.
+ *
+ * Libraries are generated deterministically from a seed, tracks are drawn from a pool so the same track
+ * appears in several playlists, and artists are drawn from a pool so the same artist appears in several
+ * tracks, as in real user libraries. The data is available in the formats used by the application: playlists
+ * file of TreeModel, web api replies of SpotifyAPI and SpotifyPlaylist objects.
+ * The size of the library can be set by the environment variables BENCH_PLAYLISTS, BENCH_TRACKS
+ * (tracks per playlist) and BENCH_ARTISTS (artists per track).
+ */
+class LibraryGenerator
+{
+public:
+    LibraryGenerator(int playlistsCount, int tracksCount, int artistsCount, unsigned int seedValue = 1);
+
+    static LibraryGenerator FromEnvironment();
+
+    int PlaylistsCount() const;
+    int TracksPerPlaylist() const;
+    int ArtistsPerTrack() const;
+
+    QJsonObject ModelJson() const;
+    QJsonObject PlaylistsReplyJson() const;
+    std::vector<QJsonObject> PlaylistsTracksReplyJson() const;
+    SpotifyPlaylist Playlist(int playlist) const;
+
+private:
+    QString Id(char kind, int index) const;
+    int PlaylistTrack(int playlist, int position) const;
+    int TrackArtist(int track, int position) const;
+    QJsonObject ArtistJson(int artist) const;
+    QJsonObject TrackJson(int track) const;
+    QJsonObject PlaylistJson(int playlist) const;
+
+    int playlists;
+    int tracksPerPlaylist;
+    int artistsPerTrack;
+    int trackPool;
+    int artistPool;
+    unsigned int seed;
+};
+
+#endif // LIBRARYGENERATOR_H
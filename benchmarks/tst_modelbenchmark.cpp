@@ -0,0 +1,757 @@
+#include <QtTest>
+#include <QTemporaryDir>
+#include <QJsonDocument>
+#include <algorithm>
+#include <limits>
+#include "allocationcounter.h"
+#include "librarygenerator.h"
+#include "api/spotifyapi.h"
+#include "api/playlistsync.h"
+#include "api/operationqueue.h"
+#include "models/treemodel.h"
+#include "models/modelloader.h"
+#include "models/stringpool.h"
+#include "models/treeitem.h"
+#include "models/treeitemarena.h"
+#include "models/featurekernels.h"
+#include "models/audiofeaturestore.h"
+#include "models/similarityindex.h"
+
+/**
+ * Benchmarks of the model and serialization hot paths of the application, fed by a synthetic library
+ * (see LibraryGenerator for the size parameters).
+ *
+ * Time is measured by QBENCHMARK (wall time by default, -callgrind or -perf options of QtTest for other
+ * metrics). Each benchmark also reports the number of allocations and bytes allocated in one run and the
+ * peak resident memory of the process.
+ */
+class ModelBenchmark : public QObject
+{
+    Q_OBJECT
+
+public:
+    ModelBenchmark();
+
+private slots:
+    void initTestCase();
+    void loadModelDataFile();
+    void addChildrenFromJson();
+    void progressiveLoad();
+    void saveModelDataOffline();
+    void savePlaylistsJsonFromWeb();
+    void modelParentIndex();
+    void treeItemsBuildTeardown_data();
+    void treeItemsBuildTeardown();
+    void midPlaylistEdits_data();
+    void midPlaylistEdits();
+    void tracksByArtist();
+    void playlistsContaining();
+    void hydrateTracks();
+    void featureKernels_data();
+    void featureKernels();
+    void audioFeaturesDistances();
+    void similarTracks_data();
+    void similarTracks();
+    void tracksUrisListStr();
+    void tracksUrisJsonBodies();
+    void playlistSyncDiff_data();
+    void playlistSyncDiff();
+    void operationQueueCoalescing();
+    void playlistBuildAllocations_data();
+    void playlistBuildAllocations();
+    void cleanupTestCase();
+
+private:
+    template <class Function>
+    bool ReportAllocations(const char *name, Function function);
+
+    LibraryGenerator generator;
+    QJsonObject libraryJson;
+    QTemporaryDir tempDir;
+    QString libraryFile;
+    QStringList headers;
+};
+
+ModelBenchmark::ModelBenchmark()
+    : generator(LibraryGenerator::FromEnvironment()),
+      headers({"name","id","uri","href","artist"})
+{
+}
+
+/**
+Method to run the benchmarked code once and report the allocations performed by it.
+@param name name of the benchmark in the report.
+@param function code benchmarked, returning false if its result is not the expected one.
+@return the result of function, checked by the benchmark (checks inside function only leave function).
+*/
+template <class Function>
+bool ModelBenchmark::ReportAllocations(const char *name, Function function)
+{
+    AllocationCounter::Reset();
+    const bool result = function();
+    const unsigned long long allocations = AllocationCounter::Allocations();
+    const unsigned long long bytes = AllocationCounter::Bytes();
+
+    qInfo("%s: %llu allocations, %llu bytes allocated, peak RSS %ld kB",
+          name, allocations, bytes, AllocationCounter::PeakRssKb());
+
+    return result;
+}
+
+void ModelBenchmark::initTestCase()
+{
+    QVERIFY(tempDir.isValid());
+
+    qInfo("Library: %d playlists, %d tracks per playlist, %d artists per track",
+          generator.PlaylistsCount(), generator.TracksPerPlaylist(), generator.ArtistsPerTrack());
+
+    libraryJson = generator.ModelJson();
+
+    libraryFile = tempDir.filePath("library.json");
+    QFile file(libraryFile);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(QJsonDocument(libraryJson).toJson());
+}
+
+void ModelBenchmark::loadModelDataFile()
+{
+    QVERIFY(ReportAllocations("loadModelData(file)", [&](){
+        TreeModel model(headers);
+        return model.loadModelData(libraryFile);
+    }));
+
+    QBENCHMARK {
+        TreeModel model(headers);
+        model.loadModelData(libraryFile);
+    }
+}
+
+void ModelBenchmark::addChildrenFromJson()
+{
+    QVERIFY(ReportAllocations("AddChildrenFromJson", [&](){
+        TreeModel model(headers);
+        return model.loadModelData(libraryJson, MODEL_TYPE_PLAYLIST);
+    }));
+
+    QBENCHMARK {
+        TreeModel model(headers);
+        model.loadModelData(libraryJson, MODEL_TYPE_PLAYLIST);
+    }
+}
+
+/**
+Load of the library by ModelLoader in an event loop: time until the first rows are in the model, longest time
+between two chunks (the longest the interface would wait to paint) and total time of the load.
+*/
+void ModelBenchmark::progressiveLoad()
+{
+    TreeModel model(headers);
+    ModelLoader loader(&model);
+    QEventLoop loop;
+    QElapsedTimer loadTimer;
+    QElapsedTimer chunkTimer;
+    qint64 firstRowsMs = -1;
+    qint64 longestChunkMs = 0;
+    int chunks = 0;
+
+    QObject::connect(&loader, &ModelLoader::progressSignal, [&](int loadedRows, int totalRows){
+        Q_UNUSED(totalRows);
+        if(loadedRows == 0)
+            return;
+        if(firstRowsMs < 0)
+            firstRowsMs = loadTimer.elapsed();
+        longestChunkMs = std::max(longestChunkMs, chunkTimer.restart());
+        chunks++;
+    });
+    QObject::connect(&loader, &ModelLoader::finishedSignal, &loop, &QEventLoop::quit);
+
+    loadTimer.start();
+    chunkTimer.start();
+    loader.load(libraryJson);
+    loop.exec();
+    const qint64 totalMs = loadTimer.elapsed();
+
+    QCOMPARE(loader.loadedRows(), loader.totalRows());
+    QCOMPARE(model.rowCount(), generator.PlaylistsCount());
+
+    qInfo("ModelLoader: %d rows in %d chunks, first rows after %lld ms, longest chunk %lld ms, total %lld ms",
+          loader.totalRows(), chunks, firstRowsMs, longestChunkMs, totalMs);
+}
+
+void ModelBenchmark::saveModelDataOffline()
+{
+    TreeModel model(headers);
+    QVERIFY(model.loadModelData(libraryJson, MODEL_TYPE_PLAYLIST));
+
+    const QString fileName = tempDir.filePath("offline.json");
+
+    QVERIFY(ReportAllocations("saveModelDataOffline", [&](){
+        return model.saveModelDataOffline(fileName);
+    }));
+
+    QBENCHMARK {
+        model.saveModelDataOffline(fileName);
+    }
+}
+
+void ModelBenchmark::savePlaylistsJsonFromWeb()
+{
+    SpotifyAPI spotify("");
+    spotify.SetPlaylistsFromWeb(generator.PlaylistsReplyJson(), generator.PlaylistsTracksReplyJson());
+
+    const QString fileName = tempDir.filePath("online.json");
+
+    QVERIFY(ReportAllocations("SavePlaylistsJsonFromWeb", [&](){
+        return spotify.SavePlaylistsJsonFromWeb(fileName);
+    }));
+
+    QBENCHMARK {
+        spotify.SavePlaylistsJsonFromWeb(fileName);
+    }
+}
+
+void ModelBenchmark::modelParentIndex()
+{
+    TreeModel model(headers);
+    QVERIFY(model.loadModelData(libraryJson, MODEL_TYPE_PLAYLIST));
+
+    //Visits every track index and its parent, as views do while painting and selecting
+    auto traverse = [&model](){
+        int found = 0;
+        for(int i = 0; i < model.rowCount(); i++)
+        {
+            const QModelIndex playlistIndex = model.index(i,0);
+            for(int j = 0; j < model.rowCount(playlistIndex); j++)
+            {
+                const QModelIndex trackIndex = model.index(j,0,playlistIndex);
+                if(model.parent(trackIndex) == playlistIndex)
+                    found++;
+            }
+        }
+        return found;
+    };
+
+    const int tracksCount = generator.PlaylistsCount() * generator.TracksPerPlaylist();
+
+    QVERIFY(ReportAllocations("TreeModel::parent/index", [&](){
+        return traverse() == tracksCount;
+    }));
+
+    QBENCHMARK {
+        traverse();
+    }
+}
+
+void ModelBenchmark::treeItemsBuildTeardown_data()
+{
+    QTest::addColumn<bool>("arena");
+
+    QTest::newRow("heap") << false;
+    QTest::newRow("arena") << true;
+}
+
+/**
+Builds a tree with the library shape (playlists with track children) and destroys it, with items allocated
+one by one (heap) or in a TreeItemArena released in one pass (arena).
+*/
+void ModelBenchmark::treeItemsBuildTeardown()
+{
+    QFETCH(bool, arena);
+
+    const int columns = headers.size();
+    const QVector<QVariant> rootData(columns);
+    const QVector<QString> rootHeadData(columns);
+
+    auto buildAndTeardown = [&](){
+        TreeItemArena itemsArena;
+        TreeItem *root = arena ? itemsArena.create(rootData, rootHeadData, nullptr)
+                               : new TreeItem(rootData, rootHeadData);
+
+        root->insertChildren(0, generator.PlaylistsCount(), columns);
+        for(int i = 0; i < root->childCount(); i++)
+            root->child(i)->insertChildren(0, generator.TracksPerPlaylist(), columns);
+
+        if(arena)
+            itemsArena.releaseAll();
+        else
+            delete root;
+    };
+
+    QVERIFY(ReportAllocations(arena ? "TreeItem build/teardown (arena)" : "TreeItem build/teardown (heap)", [&](){
+        buildAndTeardown();
+        return true;
+    }));
+
+    QBENCHMARK {
+        buildAndTeardown();
+    }
+}
+
+void ModelBenchmark::midPlaylistEdits_data()
+{
+    QTest::addColumn<int>("tracksCount");
+
+    QTest::newRow("10000 tracks") << 10000;
+    QTest::newRow("100000 tracks") << 100000;
+}
+
+/**
+Inserts a track in the middle of a large playlist, moves it to the end and removes it, and looks up a
+track by row, which are O(log n) operations on the children of a TreeItem.
+*/
+void ModelBenchmark::midPlaylistEdits()
+{
+    QFETCH(int, tracksCount);
+
+    TreeModel model(headers);
+    QVERIFY(model.loadModelData(LibraryGenerator(1, tracksCount, 1).ModelJson(), MODEL_TYPE_PLAYLIST));
+
+    const QModelIndex playlistIndex = model.index(0,0);
+    const QJsonObject trackJson = model.trackJson(model.index(0,0,playlistIndex));
+    const int middle = tracksCount / 2;
+
+    auto edit = [&](){
+        model.insertTrack(middle, playlistIndex, trackJson);
+        model.moveRows(playlistIndex, middle, 1, playlistIndex, tracksCount + 1);
+        model.index(middle, 0, playlistIndex);
+        model.removeRows(tracksCount, 1, playlistIndex);
+    };
+
+    QVERIFY(ReportAllocations("TreeModel mid playlist insert/move/remove", [&](){
+        edit();
+        return model.rowCount(playlistIndex) == tracksCount;
+    }));
+
+    QVERIFY(model.moveTracks(playlistIndex, {0, middle}, tracksCount));
+    QCOMPARE(model.trackJson(model.index(tracksCount - 2, 0, playlistIndex)), trackJson);
+
+    QBENCHMARK {
+        edit();
+    }
+}
+
+void ModelBenchmark::tracksByArtist()
+{
+    TreeModel model(headers);
+    QVERIFY(model.loadModelData(libraryJson, MODEL_TYPE_PLAYLIST));
+
+    const QModelIndex trackIndex = model.index(0,0,model.index(0,0));
+    const QString artistId = model.trackArtists(trackIndex).first().toObject().value("id").toString();
+
+    qInfo("Artists registry: %d distinct artists", model.artistRegistry().count());
+
+    QVERIFY(ReportAllocations("TreeModel::tracksByArtist", [&](){
+        return model.tracksByArtist(artistId).contains(trackIndex);
+    }));
+
+    QBENCHMARK {
+        model.tracksByArtist(artistId);
+    }
+}
+
+void ModelBenchmark::playlistsContaining()
+{
+    TreeModel model(headers);
+    QVERIFY(model.loadModelData(libraryJson, MODEL_TYPE_PLAYLIST));
+
+    const QModelIndex playlistIndex = model.index(0,0);
+    const QString trackId = model.trackJson(model.index(0,0,playlistIndex)).value("id").toString();
+
+    qInfo("Tracks registry: %d distinct tracks", model.trackRegistry().count());
+
+    QVERIFY(ReportAllocations("TreeModel::playlistsContaining", [&](){
+        return model.playlistsContaining(trackId).contains(playlistIndex);
+    }));
+
+    QBENCHMARK {
+        model.playlistsContaining(trackId);
+    }
+}
+
+/**
+Measures the load of a library imported with only the id (or the uri) of each track and its hydration with the
+data of the tracks endpoint replies, updating all rows of each track in place.
+*/
+void ModelBenchmark::hydrateTracks()
+{
+    QJsonArray stubPlaylists;
+    QJsonArray tracksReply;
+    QSet<QString> replied;
+
+    for(const auto playlistValue : libraryJson.value("playlists").toArray())
+    {
+        QJsonObject playlist = playlistValue.toObject();
+        QJsonArray stubTracks;
+
+        for(const auto trackValue : playlist.value("tracks").toArray())
+        {
+            const QJsonObject track = trackValue.toObject();
+            const QString id = track.value("id").toString();
+
+            if(stubTracks.size() % 2)
+                stubTracks.append(QJsonObject({{"uri", track.value("uri")}}));
+            else
+                stubTracks.append(QJsonObject({{"id", id}}));
+
+            if(!replied.contains(id))
+            {
+                replied.insert(id);
+                tracksReply.append(track);
+            }
+        }
+
+        playlist.insert("tracks", stubTracks);
+        stubPlaylists.append(playlist);
+    }
+
+    const QJsonObject stubJson({{"playlists", stubPlaylists}});
+
+    {
+        TreeModel model(headers);
+        QVERIFY(model.loadModelData(stubJson, MODEL_TYPE_PLAYLIST));
+        QVERIFY(!model.missingTrackIds().isEmpty());
+
+        QVERIFY(ReportAllocations("TreeModel::hydrateTracks", [&](){
+            return model.hydrateTracks(tracksReply) > 0;
+        }));
+        QVERIFY(model.missingTrackIds().isEmpty());
+        QVERIFY(!model.trackJson(model.index(0,0,model.index(0,0))).value("name").toString().isEmpty());
+    }
+
+    QBENCHMARK {
+        TreeModel model(headers);
+        model.loadModelData(stubJson, MODEL_TYPE_PLAYLIST);
+        model.hydrateTracks(tracksReply);
+    }
+}
+
+void ModelBenchmark::featureKernels_data()
+{
+    QTest::addColumn<QString>("kernel");
+
+    QTest::newRow("addSquaredDistance") << "addSquaredDistance";
+    QTest::newRow("normalize") << "normalize";
+    QTest::newRow("summarize") << "summarize";
+}
+
+/**
+Checks the kernels (the version chosen for this processor) against scalar loops on a column of 100k values,
+with a length that is not a multiple of the vector width.
+*/
+void ModelBenchmark::featureKernels()
+{
+    QFETCH(QString, kernel);
+
+    const int count = 100003;
+    QVector<float> column(count);
+    for(int i = 0; i < count; i++)
+        column[i] = float((i * 7919) % 1000) / 10.0f - 50.0f;
+
+    QVector<float> result(count, 1.0f);
+    QVector<float> expected(count, 1.0f);
+    qInfo("Kernels instruction set: %s", FeatureKernels::instructionSet());
+
+    if(kernel == "addSquaredDistance")
+    {
+        FeatureKernels::addSquaredDistance(column.constData(), 3.5f, result.data(), count);
+        for(int i = 0; i < count; i++)
+            expected[i] += (column[i] - 3.5f) * (column[i] - 3.5f);
+        for(int i = 0; i < count; i++)
+            QVERIFY(qAbs(result[i] - expected[i]) <= 1e-3f * expected[i]);
+
+        QBENCHMARK {
+            FeatureKernels::addSquaredDistance(column.constData(), 3.5f, result.data(), count);
+        }
+    }
+    else if(kernel == "normalize")
+    {
+        FeatureKernels::normalize(column.constData(), 2.0f, 0.25f, result.data(), count);
+        for(int i = 0; i < count; i++)
+            QVERIFY(qAbs(result[i] - (column[i] - 2.0f) * 0.25f) <= 1e-5f);
+
+        QBENCHMARK {
+            FeatureKernels::normalize(column.constData(), 2.0f, 0.25f, result.data(), count);
+        }
+    }
+    else
+    {
+        const FeatureSummary summary = FeatureKernels::summarize(column.constData(), count);
+        double sum = 0.0, sumSquares = 0.0;
+        for(int i = 0; i < count; i++)
+        {
+            sum += column[i];
+            sumSquares += double(column[i]) * column[i];
+        }
+        QCOMPARE(summary.count, count);
+        QCOMPARE(summary.minimum, *std::min_element(column.constBegin(), column.constEnd()));
+        QCOMPARE(summary.maximum, *std::max_element(column.constBegin(), column.constEnd()));
+        QVERIFY(qAbs(summary.sum - sum) <= 1e-6 * sumSquares);
+        QVERIFY(qAbs(summary.sumSquares - sumSquares) <= 1e-6 * sumSquares);
+
+        QBENCHMARK {
+            FeatureKernels::summarize(column.constData(), count);
+        }
+    }
+}
+
+/**
+Distances of the normalized features of 100k tracks to the features of one of them, as used to find similar
+tracks. The normalization is computed once and cached by the store.
+*/
+void ModelBenchmark::audioFeaturesDistances()
+{
+    const int count = 100000;
+    QJsonArray featuresReply;
+    for(int track = 0; track < count; track++)
+    {
+        QJsonObject features({{"id", QString("t%1").arg(track)}});
+        for(int feature = 0; feature < AudioFeatureStore::FeaturesCount; feature++)
+            features.insert(AudioFeatureStore::featureName(feature), double((track * (feature + 3) * 31) % 997));
+        featuresReply.append(features);
+    }
+
+    AudioFeatureStore store;
+    QCOMPARE(store.set(featuresReply), count);
+
+    const QVector<float> query = store.normalizedRow(42);
+    QVector<float> distances;
+    store.squaredDistances(query, distances);
+    QCOMPARE(distances.size(), count);
+    QCOMPARE(distances[42], 0.0f);
+
+    QBENCHMARK {
+        store.squaredDistances(query, distances);
+    }
+}
+
+void ModelBenchmark::similarTracks_data()
+{
+    QTest::addColumn<int>("tracksCount");
+
+    QTest::newRow("10k tracks") << 10000;
+    QTest::newRow("100k tracks") << 100000;
+    QTest::newRow("1M tracks") << 1000000;
+}
+
+/**
+Latency of a "more like this" query (20 nearest tracks to a track) over the whole store, checked against a
+full sort of the distances.
+*/
+void ModelBenchmark::similarTracks()
+{
+    QFETCH(int, tracksCount);
+    const int k = 20;
+
+    AudioFeatureStore store;
+    for(int track = 0; track < tracksCount; track++)
+    {
+        QJsonObject features({{"id", QString("t%1").arg(track)}});
+        for(int feature = 0; feature < AudioFeatureStore::FeaturesCount; feature++)
+            features.insert(AudioFeatureStore::featureName(feature), double((track * (feature + 3) * 7919) % 10007));
+        store.set(features);
+    }
+
+    SimilarityIndex index(store);
+    const QVector<SimilarTrack> found = index.nearestToTrack("t42", k);
+    QCOMPARE(found.size(), k);
+
+    QVector<float> distances;
+    store.squaredDistances(store.normalizedRow(42), distances);
+    distances[42] = std::numeric_limits<float>::max();
+    std::partial_sort(distances.begin(), distances.begin() + k, distances.end());
+    for(int i = 0; i < k; i++)
+        QCOMPARE(found[i].distance, distances[i]);
+
+    QBENCHMARK {
+        index.nearestToTrack("t42", k);
+    }
+}
+
+void ModelBenchmark::tracksUrisListStr()
+{
+    //Whole library in a single playlist
+    const int tracksCount = generator.PlaylistsCount() * generator.TracksPerPlaylist();
+    SpotifyPlaylist playlist = LibraryGenerator(1, tracksCount, 1).Playlist(0);
+
+    QVERIFY(ReportAllocations("GetTracksUrisListStr", [&](){
+        return !playlist.GetTracksUrisListStr(",").empty();
+    }));
+
+    QBENCHMARK {
+        playlist.GetTracksUrisListStr(",");
+    }
+}
+
+/**
+Checks that the Json bodies of the requests adding the playlist tracks (batches of 100 uris) are written
+with one allocation each, straight into the QByteArray.
+*/
+void ModelBenchmark::tracksUrisJsonBodies()
+{
+    const int tracksCount = generator.PlaylistsCount() * generator.TracksPerPlaylist();
+    SpotifyPlaylist playlist = LibraryGenerator(1, tracksCount, 1).Playlist(0);
+    const JoinFormat format = {",", "\"", "\"", "{\"uris\":[", "]}"};
+    const size_t batchSize = 100;
+    const size_t batchesCount = (playlist.TracksCount() + batchSize - 1) / batchSize;
+
+    AllocationCounter::Reset();
+    for(size_t first = 0; first < playlist.TracksCount(); first += batchSize)
+    {
+        QByteArray body;
+        playlist.JoinTracks(body, &SpotifyTrack::GetURI, format, first, batchSize);
+        QCOMPARE(size_t(body.size()), playlist.JoinedSize(&SpotifyTrack::GetURI, format, first, batchSize));
+    }
+    QVERIFY(AllocationCounter::Allocations() <= batchesCount);
+
+    QBENCHMARK {
+        for(size_t first = 0; first < playlist.TracksCount(); first += batchSize)
+        {
+            QByteArray body;
+            playlist.JoinTracks(body, &SpotifyTrack::GetURI, format, first, batchSize);
+        }
+    }
+}
+
+void ModelBenchmark::playlistSyncDiff_data()
+{
+    QTest::addColumn<QString>("change");
+    QTest::addColumn<int>("requests");
+
+    QTest::newRow("add one track") << "add" << 1;
+    QTest::newRow("remove one track") << "remove" << 1;
+    QTest::newRow("move one track") << "move" << 1;
+    QTest::newRow("reverse playlist") << "reverse" << 50;
+}
+
+/**
+Computes the requests that push a change of a 5000 tracks playlist to the server and checks that applying
+them to the server tracks gives the local tracks.
+*/
+void ModelBenchmark::playlistSyncDiff()
+{
+    QFETCH(QString, change);
+    QFETCH(int, requests);
+
+    QStringList serverUris;
+    for(int i = 0; i < 5000; i++)
+        serverUris.append(QString("spotify:track:%1").arg(i, 22, 10, QChar('0')));
+
+    QStringList localUris = serverUris;
+    if(change == "add")
+        localUris.insert(2500, "spotify:track:new");
+    else if(change == "remove")
+        localUris.removeAt(100);
+    else if(change == "move")
+        localUris.move(10, 4000);
+    else
+        std::reverse(localUris.begin(), localUris.end());
+
+    const QVector<PlaylistEdit> edits = PlaylistSync::Diff(serverUris, localUris);
+    QCOMPARE(edits.size(), requests);
+
+    QStringList pushedUris = serverUris;
+    for(const PlaylistEdit &edit : edits)
+        QVERIFY(PlaylistSync::Apply(pushedUris, edit));
+    QCOMPARE(pushedUris, localUris);
+
+    QBENCHMARK {
+        PlaylistSync::Diff(serverUris, localUris);
+    }
+}
+
+/**
+Checks the coalescing of an offline editing session: 1000 tracks added one at a time to a playlist and half of
+them removed again are a single add of 500 tracks, and the playlists created are sent before their tracks.
+*/
+void ModelBenchmark::operationQueueCoalescing()
+{
+    QStringList uris;
+    for(int i = 0; i < 1000; i++)
+        uris.append(QString("spotify:track:%1").arg(i, 22, 10, QChar('0')));
+
+    auto edit = [&](OperationQueue &queue){
+        for(const QString &uri : qAsConst(uris))
+            queue.AddTracks("playlist", {uri});
+        for(int i = 0; i < uris.size(); i += 2)
+            queue.RemoveTracks("playlist", {uris[i]});
+
+        for(int i = 0; i < 3; i++)
+        {
+            const QString local_id = queue.CreatePlaylist(QString("created %1").arg(i), false, QString());
+            for(int j = 0; j < 10; j++)
+                queue.AddTracks(local_id, {uris[j]});
+        }
+    };
+
+    OperationQueue queue;
+    edit(queue);
+    QCOMPARE(queue.Count(), 7);
+
+    const QVector<QueuedOperation> ready = queue.TakeReady(4, nullptr);
+    QCOMPARE(ready.size(), 4);
+    QCOMPARE(ready[0].type, QueuedOperation::AddTracks);
+    QCOMPARE(ready[0].uris.size(), 500);
+    for(int i = 1; i < ready.size(); i++)
+        QCOMPARE(ready[i].type, QueuedOperation::CreatePlaylist);
+
+    QBENCHMARK {
+        OperationQueue session;
+        edit(session);
+    }
+}
+
+void ModelBenchmark::playlistBuildAllocations_data()
+{
+    QTest::addColumn<int>("tracksCount");
+
+    QTest::newRow("1000 tracks") << 1000;
+    QTest::newRow("10000 tracks") << 10000;
+}
+
+/**
+Checks that building a playlist of N tracks allocates O(N) times: one allocation for each string copied
+into a track (name, id and uri longer than the small string buffer) and one for the reserved tracks storage.
+*/
+void ModelBenchmark::playlistBuildAllocations()
+{
+    QFETCH(int, tracksCount);
+
+    const std::string name = "Track name longer than the small string buffer";
+    const std::string id = "t000000000000000000000000001";
+    const std::string uri = "spotify:track:t000000000000000000000000001";
+
+    auto build = [&](){
+        SpotifyPlaylist playlist;
+        playlist.SetName(name);
+        playlist.Reserve(size_t(tracksCount));
+        for(int i = 0; i < tracksCount; i++)
+            playlist.EmplaceTrack(name, id, uri);
+        return playlist.TracksCount();
+    };
+
+    AllocationCounter::Reset();
+    QCOMPARE(build(), size_t(tracksCount));
+    const unsigned long long allocations = AllocationCounter::Allocations();
+
+    qInfo("SpotifyPlaylist build: %d tracks, %llu allocations", tracksCount, allocations);
+    QVERIFY(allocations <= 3ull * tracksCount + 2);
+
+    QBENCHMARK {
+        build();
+    }
+}
+
+void ModelBenchmark::cleanupTestCase()
+{
+    TreeModel model(headers);
+    QVERIFY(model.loadModelData(libraryJson, MODEL_TYPE_PLAYLIST));
+
+    const QJsonObject poolStatistics = StringPool::global().statistics();
+    qInfo("String pool: %s", QJsonDocument(poolStatistics).toJson(QJsonDocument::Compact).constData());
+
+    qInfo("Peak RSS: %ld kB", AllocationCounter::PeakRssKb());
+}
+
+QTEST_GUILESS_MAIN(ModelBenchmark)
+
+#include "tst_modelbenchmark.moc"
@@ -0,0 +1,30 @@
+#include "spotifycli.h"
+#include "utils/tracer.h"
+#include "utils/logger.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTimer>
+
+
+int main(int argc, char *argv[])
+{
+    QElapsedTimer startTimer;
+    startTimer.start();
+
+    Tracer::EnableFromEnvironment();
+    Logger::Start();
+
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("spotifyapp-cli");
+
+    SpotifyCli cli(startTimer);
+    QTimer::singleShot(0, &cli, [&](){ cli.Run(a.arguments()); });
+
+    const int result = a.exec();
+    Logger::Stop();
+
+    if(Tracer::IsEnabled())
+        Tracer::WriteChromeTrace(Tracer::TraceFile());
+
+    return result;
+}
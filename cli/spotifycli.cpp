@@ -0,0 +1,363 @@
+#include "spotifycli.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QJsonDocument>
+#include <QTextStream>
+#include <QSet>
+#include "utils/tracer.h"
+#include "models/stringpool.h"
+
+SpotifyCli::SpotifyCli(const QElapsedTimer &startTimer, QObject *parent)
+    : QObject(parent),
+      processTimer(startTimer),
+      phaseTimer(startTimer),
+      spotify(nullptr),
+      autoAuthorize(false)
+{
+    timeoutTimer.setSingleShot(true);
+    connect(&timeoutTimer, &QTimer::timeout, this, &SpotifyCli::SyncTimeout);
+}
+
+SpotifyCli::~SpotifyCli()
+{
+    delete spotify;
+}
+
+/**
+Method to parse the command line arguments and execute the command requested.
+Commands that don't access spotify server (export, diff) finish before returning,
+the sync command finishes when the playlists are received.
+@param arguments list of command line arguments.
+*/
+void SpotifyCli::Run(const QStringList &arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Sync, export and diff spotify playlists without user interface");
+    parser.addHelpOption();
+    parser.addPositionalArgument("command", "sync | export <input.json> <output.json> | diff <old.json> <new.json>");
+
+    QCommandLineOption keysOption("keys", "Xml file with the user keys.", "file", "userkeys.xml");
+    QCommandLineOption outOption("out", "File where synced playlists are saved.", "file", "playlistsonline.json");
+    QCommandLineOption timeoutOption("timeout", "Maximum time of sync in seconds.", "seconds", "300");
+    //Server addresses given here replace the ones of the keys file, which replace the spotify servers
+    QCommandLineOption apiUrlOption("api-url", "Base address of web api server (default api_url of the keys file, or https://api.spotify.com).", "url");
+    QCommandLineOption accountsUrlOption("accounts-url", "Base address of accounts server (default accounts_url of the keys file, or https://accounts.spotify.com).", "url");
+    QCommandLineOption autoAuthorizeOption("auto-authorize", "Request the authorization url directly instead of waiting for a browser.");
+    parser.addOption(keysOption);
+    parser.addOption(outOption);
+    parser.addOption(timeoutOption);
+    parser.addOption(apiUrlOption);
+    parser.addOption(accountsUrlOption);
+    QCommandLineOption metricsOption("metrics", "File where requests metrics by endpoint are written.", "file");
+    QCommandLineOption traceOption("trace", "File where a Chrome trace of the command is written.", "file");
+    parser.addOption(autoAuthorizeOption);
+    parser.addOption(metricsOption);
+    parser.addOption(traceOption);
+
+    parser.process(arguments);
+
+    if(parser.isSet(traceOption))
+    {
+        Tracer::SetTraceFile(parser.value(traceOption));
+        Tracer::SetEnabled(true);
+    }
+
+    const QStringList args = parser.positionalArguments();
+    const QString command = args.value(0);
+
+    summary.insert("command", command);
+    MarkPhase("startup");
+
+    if(command == "sync" && args.size() == 1)
+    {
+        outputFile = parser.value(outOption);
+        apiUrl = parser.value(apiUrlOption);
+        accountsUrl = parser.value(accountsUrlOption);
+        autoAuthorize = parser.isSet(autoAuthorizeOption);
+        metricsFile = parser.value(metricsOption);
+        Sync(parser.value(keysOption), parser.value(timeoutOption).toInt());
+    }
+    else if(command == "export" && args.size() == 3)
+        Finish(Export(args[1], args[2]));
+    else if(command == "diff" && args.size() == 3)
+        Finish(Diff(args[1], args[2]));
+    else
+    {
+        QTextStream(stderr) << parser.helpText();
+        summary.insert("error", "invalid command");
+        Finish(1);
+    }
+}
+
+/**
+Method to connect to spotify server and download the user playlists. The authorization url
+is printed in the error output so the user can grant access in a browser.
+@param keysFile xml file with user keys.
+@param timeoutSeconds maximum time to wait for the playlists.
+*/
+void SpotifyCli::Sync(const QString &keysFile, int timeoutSeconds)
+{
+    const QByteArray keys = keysFile.toLocal8Bit();
+
+    spotify = new SpotifyAPI(keys.constData());
+    if(!spotify->HasUserKeys())
+    {
+        summary.insert("error", "user keys not set");
+        Finish(1);
+        return;
+    }
+
+    spotify->SetPlaylistsFileName(outputFile);
+    if(!apiUrl.isEmpty() || !accountsUrl.isEmpty())
+        spotify->SetServerUrls(apiUrl, accountsUrl);
+    if(!metricsFile.isEmpty())
+        spotify->Metrics().SetDumpFile(metricsFile);
+
+    connect(spotify, &SpotifyAPI::AuthorizeUrlSignal, [=](const QUrl &url){
+        if(autoAuthorize)
+            this->AutoAuthorize(url);
+        else
+            QTextStream(stderr) << "Open the url to authorize access: " << url.toString() << endl;
+    });
+    connect(spotify, &SpotifyAPI::UpdateOutputTextSignal, [](QString text, bool clear){
+        Q_UNUSED(clear);
+        QTextStream(stderr) << text << endl;
+    });
+    connect(spotify, &SpotifyAPI::ConnectedSignal, [=](){ this->MarkPhase("authorization"); });
+    connect(spotify, &SpotifyAPI::PlaylistsSyncedSignal, this, &SpotifyCli::SyncFinished);
+
+    timeoutTimer.start(timeoutSeconds * 1000);
+    spotify->ConnectToServer();
+}
+
+/**
+SLOT Method called after all user playlists are received and saved in file.
+It loads the file in a TreeModel to check the data and finishes the command.
+@param saved true if the playlists file was written.
+*/
+void SpotifyCli::SyncFinished(bool saved)
+{
+    timeoutTimer.stop();
+    MarkPhase("fetch");
+
+    if(!saved)
+    {
+        summary.insert("error", "playlists not synced");
+        Finish(1);
+        return;
+    }
+
+    TreeModel model(QStringList({"name","id","uri","href","artist"}));
+    if(!LoadModel(model, outputFile))
+    {
+        Finish(1);
+        return;
+    }
+    MarkPhase("model_load");
+
+    AddModelSummary(model);
+    summary.insert("output", outputFile);
+    Finish(0);
+}
+
+/**
+Method to request the authorization url without a browser. The server redirects the request to the
+local reply handler of SpotifyAPI, which completes the grant. Meant for servers that grant access
+without user interaction, such as tools/mockserver.
+@param url authorization url.
+*/
+void SpotifyCli::AutoAuthorize(const QUrl &url)
+{
+    QNetworkRequest request(url);
+    request.setAttribute(QNetworkRequest::FollowRedirectsAttribute, true);
+
+    auto reply = authorizeManager.get(request);
+    connect(reply, &QNetworkReply::finished, reply, &QNetworkReply::deleteLater);
+}
+
+void SpotifyCli::SyncTimeout()
+{
+    //Requests of the sync still in flight are aborted
+    if(spotify)
+        spotify->CancelSync();
+
+    summary.insert("error", "sync timeout");
+    Finish(2);
+}
+
+/**
+Method to load a playlists file in a TreeModel and save the model data in other file.
+@param inputFile playlists file in (.json) format.
+@param outputFile file where model data is saved.
+@return process exit code, 0 if the export succeeded.
+*/
+int SpotifyCli::Export(const QString &inputFile, const QString &outputFile)
+{
+    TreeModel model(QStringList({"name","id","uri","href","artist"}));
+    if(!LoadModel(model, inputFile))
+        return 1;
+    MarkPhase("model_load");
+
+    if(!model.saveModelDataOffline(outputFile))
+    {
+        summary.insert("error", "model not saved");
+        return 1;
+    }
+    MarkPhase("save");
+
+    AddModelSummary(model);
+    summary.insert("output", outputFile);
+    return 0;
+}
+
+/**
+Method to compare two playlists files. Playlists are matched by id (or by name if they don't have one)
+and tracks by id. The differences are added to the summary.
+@param oldFile playlists file taken as reference.
+@param newFile playlists file compared to the reference.
+@return process exit code, 0 if both files were compared.
+*/
+int SpotifyCli::Diff(const QString &oldFile, const QString &newFile)
+{
+    TreeModel oldModel(QStringList({"name","id","uri","href","artist"}));
+    TreeModel newModel(QStringList({"name","id","uri","href","artist"}));
+
+    if(!LoadModel(oldModel, oldFile) || !LoadModel(newModel, newFile))
+        return 1;
+    MarkPhase("model_load");
+
+    const QJsonObject oldPlaylists = PlaylistsTracks(oldModel);
+    const QJsonObject newPlaylists = PlaylistsTracks(newModel);
+
+    QJsonArray playlistsAdded;
+    QJsonArray playlistsRemoved;
+    QJsonArray playlistsChanged;
+
+    for(auto it = newPlaylists.begin(); it != newPlaylists.end(); ++it)
+    {
+        const QJsonObject newPlaylist = it.value().toObject();
+
+        if(!oldPlaylists.contains(it.key()))
+        {
+            playlistsAdded.append(QJsonObject({{"key", it.key()}, {"name", newPlaylist.value("name")}}));
+            continue;
+        }
+
+        const QJsonObject oldPlaylist = oldPlaylists.value(it.key()).toObject();
+
+        QSet<QString> oldTracks;
+        for(const auto track : oldPlaylist.value("tracks").toArray())
+            oldTracks.insert(track.toString());
+
+        QSet<QString> newTracks;
+        for(const auto track : newPlaylist.value("tracks").toArray())
+            newTracks.insert(track.toString());
+
+        QJsonArray tracksAdded;
+        for(const QString &track : newTracks)
+            if(!oldTracks.contains(track))
+                tracksAdded.append(track);
+
+        QJsonArray tracksRemoved;
+        for(const QString &track : oldTracks)
+            if(!newTracks.contains(track))
+                tracksRemoved.append(track);
+
+        if(!tracksAdded.isEmpty() || !tracksRemoved.isEmpty())
+        {
+            playlistsChanged.append(QJsonObject({{"key", it.key()},
+                                                 {"name", newPlaylist.value("name")},
+                                                 {"tracks_added", tracksAdded},
+                                                 {"tracks_removed", tracksRemoved}}));
+        }
+    }
+
+    for(auto it = oldPlaylists.begin(); it != oldPlaylists.end(); ++it)
+    {
+        if(!newPlaylists.contains(it.key()))
+            playlistsRemoved.append(QJsonObject({{"key", it.key()}, {"name", it.value().toObject().value("name")}}));
+    }
+
+    MarkPhase("diff");
+
+    summary.insert("diff", QJsonObject({{"playlists_added", playlistsAdded},
+                                        {"playlists_removed", playlistsRemoved},
+                                        {"playlists_changed", playlistsChanged}}));
+    return 0;
+}
+
+bool SpotifyCli::LoadModel(TreeModel &model, const QString &fileName)
+{
+    if(!model.loadModelData(fileName))
+    {
+        summary.insert("error", "model not loaded: " + fileName);
+        return false;
+    }
+    return true;
+}
+
+/**
+Method to get the tracks ids of each playlist in the model.
+@param model TreeModel with playlists data.
+@return Json object with playlists keyed by id (or "name:" + name) with the playlist name and tracks ids array.
+*/
+QJsonObject SpotifyCli::PlaylistsTracks(TreeModel &model)
+{
+    QJsonObject playlists;
+
+    for(int i = 0; i < model.rowCount(); i++)
+    {
+        QModelIndex playlistIndex = model.index(i,0);
+        const QString id = model.findDataByHead("id", playlistIndex).toString();
+        const QString name = model.findDataByHead("name", playlistIndex).toString();
+
+        QJsonArray tracks;
+        for(int j = 0; j < model.rowCount(playlistIndex); j++)
+        {
+            QModelIndex trackIndex = model.index(j,0,playlistIndex);
+            tracks.append(model.findDataByHead("id", trackIndex).toString());
+        }
+
+        playlists.insert(id.isEmpty() ? "name:" + name : id, QJsonObject({{"name", name}, {"tracks", tracks}}));
+    }
+
+    return playlists;
+}
+
+void SpotifyCli::AddModelSummary(TreeModel &model)
+{
+    int tracksCount = 0;
+    for(int i = 0; i < model.rowCount(); i++)
+        tracksCount += model.rowCount(model.index(i,0));
+
+    summary.insert("playlists", model.rowCount());
+    summary.insert("tracks", tracksCount);
+    summary.insert("distinct_tracks", model.trackRegistry().count());
+    summary.insert("artists", model.artistRegistry().count());
+    summary.insert("string_pool", StringPool::global().statistics());
+}
+
+/**
+Method to record the time spent in a phase of the command, since the previous phase finished.
+@param phase name of the phase in the timings summary.
+*/
+void SpotifyCli::MarkPhase(const QString &phase)
+{
+    timings.insert(phase, double(phaseTimer.restart()));
+}
+
+/**
+Method to print the command summary in a single Json line and leave the event loop.
+@param exitCode process exit code.
+*/
+void SpotifyCli::Finish(int exitCode)
+{
+    timings.insert("total", double(processTimer.elapsed()));
+    summary.insert("ok", exitCode == 0);
+    summary.insert("timings_ms", timings);
+
+    QTextStream(stdout) << QJsonDocument(summary).toJson(QJsonDocument::Compact) << endl;
+
+    QCoreApplication::exit(exitCode);
+}
@@ -0,0 +1,74 @@
+#ifndef SPOTIFYCLI_H
+#define SPOTIFYCLI_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QStringList>
+#include <QTimer>
+#include <QNetworkAccessManager>
+#include "api/spotifyapi.h"
+#include "models/treemodel.h"
+
+/**
+ * Implementation of class SpotifyCli to run the application without user interface (headless mode).
+ * It drives SpotifyAPI and TreeModel objects to sync, export and diff playlists libraries from the
+ * command line. At the end of each command a summary with the result and the time spent in each phase
+ * is printed in Json format to the standard output.
+ *
+ * Commands:
+ *   sync [--keys file] [--out file] [--timeout seconds]  download user playlists from spotify server
+ *        [--api-url url] [--accounts-url url]           use other servers (e.g. tools/mockserver)
+ *        [--auto-authorize]                             open the authorization url without browser
+ *        [--metrics file]                               write requests metrics by endpoint to a file
+ *   [--trace file]                                        record spans of the command in Chrome trace format
+ *   export <input.json> <output.json>                     load a playlists file in the model and save it again
+ *   diff <old.json> <new.json>                            compare playlists and tracks of two files
+ */
+class SpotifyCli : public QObject
+{
+    Q_OBJECT
+
+public:
+    SpotifyCli(const QElapsedTimer &startTimer, QObject *parent = nullptr);
+    ~SpotifyCli();
+
+    void Run(const QStringList &arguments);
+
+private slots:
+    void SyncFinished(bool saved);
+    void SyncTimeout();
+
+private:
+    void Sync(const QString &keysFile, int timeoutSeconds);
+    void AutoAuthorize(const QUrl &url);
+    int Export(const QString &inputFile, const QString &outputFile);
+    int Diff(const QString &oldFile, const QString &newFile);
+
+    bool LoadModel(TreeModel &model, const QString &fileName);
+    QJsonObject PlaylistsTracks(TreeModel &model);
+    void AddModelSummary(TreeModel &model);
+    void MarkPhase(const QString &phase);
+    void Finish(int exitCode);
+
+    //Timers of the whole process and of the current phase of the command
+    QElapsedTimer processTimer;
+    QElapsedTimer phaseTimer;
+
+    QJsonObject summary;
+    QJsonObject timings;
+    QString outputFile;
+
+    SpotifyAPI *spotify;
+    QTimer timeoutTimer;
+
+    //Options of sync command
+    QString apiUrl;
+    QString accountsUrl;
+    bool autoAuthorize;
+    QString metricsFile;
+    QNetworkAccessManager authorizeManager;
+};
+
+#endif // SPOTIFYCLI_H
@@ -0,0 +1,61 @@
+QT       += core network networkauth
+QT       -= gui
+
+CONFIG += c++2a console
+# GCC 10 enables the coroutines of the request layer (api/asynctask.h) only with this flag
+*-g++*: QMAKE_CXXFLAGS += -fcoroutines
+CONFIG += qt debug
+CONFIG -= app_bundle
+
+TARGET = spotifyapp-cli
+
+#Sources are shared with the interface application and included relative to the project root
+INCLUDEPATH += ..
+
+SOURCES += \
+    main.cpp \
+    spotifycli.cpp \
+    ../api/spotifyapi.cpp \
+    ../api/playlistsync.cpp \
+    ../api/asynctask.cpp \
+    ../api/operationqueue.cpp \
+    ../models/treeitem.cpp \
+    ../models/treeitemarena.cpp \
+    ../models/treemodel.cpp \
+    ../models/artistregistry.cpp \
+    ../models/trackregistry.cpp \
+    ../models/audiofeaturestore.cpp \
+    ../models/featurekernels.cpp \
+    ../models/similarityindex.cpp \
+    ../models/stringpool.cpp \
+    ../utils/tracer.cpp \
+    ../utils/networkmetrics.cpp \
+    ../utils/logger.cpp
+
+HEADERS += \
+    spotifycli.h \
+    ../models/musicutils.h \
+    ../api/spotifyapi.h \
+    ../api/playlistsync.h \
+    ../api/asynctask.h \
+    ../api/operationqueue.h \
+    ../models/spotifyutils.h \
+    ../models/treeitem.h \
+    ../models/ranksequence.h \
+    ../models/treeitemarena.h \
+    ../models/treemodel.h \
+    ../models/artistregistry.h \
+    ../models/trackregistry.h \
+    ../models/audiofeaturestore.h \
+    ../models/featurekernels.h \
+    ../models/similarityindex.h \
+    ../models/stringpool.h \
+    ../utils/tracer.h \
+    ../utils/networkmetrics.h \
+    ../utils/logger.h \
+    ../utils/mpscqueue.h
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
@@ -1,5 +1,16 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
+#include "utils/tracer.h"
+#include "utils/logger.h"
+
+//Maximum number of lines kept in the log box
+static const int maxOutputLines = 2000;
+
+//Time without changes of the playlists after which the changes are pushed to the server
+static const int pushDelayMs = 2000;
+
+//Number of tracks shown by the more like this button
+static const int similarTracksCount = 20;
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -12,16 +23,35 @@ MainWindow::MainWindow(QWidget *parent)
     ui->playBt->setEnabled(false);
     ui->createPlaylistBt->setEnabled(true);
 
+    //Old lines of the log box are discarded, so its document doesn't grow without limit
+    ui->logPTxEdit->setMaximumBlockCount(maxOutputLines);
+    clearOutputText = false;
+    outputFlushTimer.setSingleShot(true);
+    outputFlushTimer.setInterval(50);
+    connect(&outputFlushTimer, &QTimer::timeout, this, &MainWindow::FlushOutputTextSlot);
+
     const QStringList headers({tr("name"),tr("id"),tr("uri"),tr("href"),tr("artist")});
 
+    //The library is loaded in chunks after the window is shown, see LoadProgressSlot
     playlistModel = new TreeModel(headers);
-    playlistModel->loadModelData("playlistsdata.json");
+    modelLoader = new ModelLoader(playlistModel, this);
+    connected = false;
+    connect(modelLoader, &ModelLoader::progressSignal, this, &MainWindow::LoadProgressSlot);
+    connect(modelLoader, &ModelLoader::finishedSignal, this, &MainWindow::LoadFinishedSlot);
+    connect(playlistModel, &QAbstractItemModel::rowsInserted, [=](const QModelIndex &parent, int first, int last){ this->PlaylistsInserted(parent, first, last);} );
 
     playlistsView = new QTreeView();
     playlistsView->setModel(playlistModel);
     tracksView = new QTreeView();
     tracksView->setModel(playlistModel);
 
+    //Tracks are reordered by dragging them inside their playlist
+    tracksView->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    tracksView->setDragEnabled(true);
+    tracksView->setAcceptDrops(true);
+    tracksView->setDropIndicatorShown(true);
+    tracksView->setDragDropMode(QAbstractItemView::InternalMove);
+
     searchResultView = new QTreeView();
     ui->resultVLayout->addWidget(searchResultView);
 
@@ -35,13 +65,30 @@ MainWindow::MainWindow(QWidget *parent)
     SetTracksView();
 
     //Create SpotfyAPI object to handle connections, queries, replies
-    spotify = new SpotifyAPI("userkeys.xml");
+    //Requests, replies and Json parsing run in the network thread, the results are delivered in this thread
+    network = new NetworkThread("userkeys.xml", this);
+    network->Post([](SpotifyAPI *api){ api->SetOperationsFileName("pendingoperations.json");} );
 
     //Create connections of SIGNALS (actions) in SpotifyAPI to SLOTS (actions) in interface
-    connect(spotify,&SpotifyAPI::UpdateOutputTextSignal,this, &MainWindow::UpdateOutputTextSlot);
-    connect(spotify,&SpotifyAPI::ConnectedSignal,[=](){ this->ConnectGrantedSlot();} );
-    connect(spotify,&SpotifyAPI::ArtistTracksFoundSignal,[=](){ this->ArtistTracksFoundSlot();} );
-    connect(spotify,&SpotifyAPI::TracksFoundSignal,this, &MainWindow::TracksFoundSlot);
+    network->Deliver(&SpotifyAPI::UpdateOutputTextSignal,[=](QString text, bool clear){ this->UpdateOutputTextSlot(text, clear);} );
+    network->Deliver(&SpotifyAPI::AuthorizeUrlSignal,[](const QUrl &url){ QDesktopServices::openUrl(url);} );
+    network->Deliver(&SpotifyAPI::ConnectedSignal,[=](){ this->ConnectGrantedSlot();} );
+    network->Deliver(&SpotifyAPI::ArtistTracksFoundSignal,[=](){ this->ArtistTracksFoundSlot();} );
+    network->Deliver(&SpotifyAPI::TracksFoundSignal,[=](QJsonObject data){ this->TracksFoundSlot(data);} );
+    network->Deliver(&SpotifyAPI::PlaylistCreatedSignal,[=](QString local_id, QJsonObject playlist){ this->PlaylistCreatedSlot(local_id, playlist);} );
+    network->Deliver(&SpotifyAPI::TracksHydratedSignal,[=](QJsonArray tracks){ this->playlistModel->hydrateTracks(tracks);} );
+    network->Deliver(&SpotifyAPI::AudioFeaturesSignal,[=](QJsonArray features){ this->playlistModel->setAudioFeatures(features);} );
+
+    logSink = new LogUiSink(100, 50, this);
+    Logger::SetUiSink(logSink);
+    connect(logSink,&LogUiSink::LinesReadySignal,this, &MainWindow::UpdateOutputTextSlot);
+
+    //Tracks added and removed are queued as they change (see AddTrack and RemoveTrack), tracks moved are
+    //pushed to the server once the user stops moving them
+    pushTimer.setSingleShot(true);
+    pushTimer.setInterval(pushDelayMs);
+    connect(&pushTimer, &QTimer::timeout, this, &MainWindow::PushPlaylistsSlot);
+    connect(playlistModel, &QAbstractItemModel::rowsMoved, [=](const QModelIndex &parent){ this->PlaylistChanged(parent);} );
 
 
     //Create connections between user interface actions and internal computations
@@ -52,12 +99,15 @@ MainWindow::MainWindow(QWidget *parent)
     connect(playlistsView, SIGNAL(pressed(const QModelIndex &)), this, SLOT(PlaylistSelected(const QModelIndex &)));
     connect(ui->addTrackBt, SIGNAL(clicked()), this, SLOT(AddTrack()));
     connect(ui->playBt, SIGNAL(clicked()), this, SLOT(PlayTracks()));
+    connect(ui->similarTracksBt, SIGNAL(clicked()), this, SLOT(SimilarTracksSlot()));
 
+    modelLoader->loadFile("playlistsdata.json");
 }
 
 MainWindow::~MainWindow()
 {
-    delete spotify;
+    //The network thread is stopped before the interface it delivers to is released
+    delete network;
     delete ui;
 }
 
@@ -68,13 +118,32 @@ MainWindow::~MainWindow()
 void MainWindow::ConnectSpotifyClicked()
 {
     ui->logPTxEdit->appendPlainText("Application requesting connection to spotfy");
-    spotify->ConnectToServer();
+    network->Post([](SpotifyAPI *api){ api->ConnectToServer();} );
 }
 
 void MainWindow::ConnectGrantedSlot()
 {
     ui->searchBt->setEnabled(true);
     ui->playBt->setEnabled(true);
+    connected = true;
+
+    //The data missing in the library is requested when the library is loaded
+    if(!modelLoader->isLoading())
+        RequestMissingData();
+}
+
+/**
+*Method to request to the server the data missing in the library: tracks imported with only an id or uri get
+*their data and the audio features of the tracks are requested.
+*/
+void MainWindow::RequestMissingData()
+{
+    const QStringList missing_tracks = playlistModel->missingTrackIds();
+    const QStringList missing_features = playlistModel->missingFeatureIds();
+    network->Post([=](SpotifyAPI *api){
+        api->HydrateTracks(missing_tracks);
+        api->GetAudioFeatures(missing_features);
+    });
 }
 
 void MainWindow::ArtistTracksFoundSlot()
@@ -84,18 +153,17 @@ void MainWindow::ArtistTracksFoundSlot()
 
 /**
 *SLOT method called after search artist button clicked.
-*It calls spotify API for requesting artist information and correspondent tracks.
+*It calls spotify API for requesting artist information and correspondent tracks. Several artists can be
+*searched at once, separated by commas: their top tracks are shown together in the search results view.
 */
 void MainWindow::GetArtistTracksSlot()
 {
-
-    spotify->GetCurrentPlaylists();
     //Get artist name from interface
     QString artist_name = ui->searchTxEdit->toPlainText();
 
     if(!artist_name.isEmpty())
     {
-        spotify->SearchArtist(artist_name);
+        network->Post([=](SpotifyAPI *api){ api->SearchArtist(artist_name);} );
     }
     else
         QMessageBox::warning(this, tr(""),tr("Invalid artist name"));
@@ -104,6 +172,7 @@ void MainWindow::GetArtistTracksSlot()
 
 /**
 *SLOT method called by SpotfyAPI in order to show a message text in the interface.
+*Messages are buffered and shown together in the next flush of the log box.
 *@param text message text to be displayed on interface.
 *@param clear param to clear edit box
 */
@@ -112,13 +181,41 @@ void MainWindow::UpdateOutputTextSlot(QString text, bool clear)
      if(!text.isEmpty())
      {
          if(clear)
-             ui->logPTxEdit->setPlainText(text);
-         else
-             ui->logPTxEdit->appendPlainText(text);
+         {
+             pendingOutputText.clear();
+             clearOutputText = true;
+         }
+         pendingOutputText.append(text);
+
+         //Lines over the log box limit would be discarded after the append
+         if(pendingOutputText.size() > maxOutputLines)
+             pendingOutputText.erase(pendingOutputText.begin(), pendingOutputText.end() - maxOutputLines);
+
+         if(!outputFlushTimer.isActive())
+             outputFlushTimer.start();
      }
 
 }
 
+/**
+*SLOT method called by the flush timer to show the buffered messages with a single update of the log box.
+*/
+void MainWindow::FlushOutputTextSlot()
+{
+    if(pendingOutputText.isEmpty())
+        return;
+
+    const QString text = pendingOutputText.join('\n');
+    pendingOutputText.clear();
+
+    if(clearOutputText)
+        ui->logPTxEdit->setPlainText(text);
+    else
+        ui->logPTxEdit->appendPlainText(text);
+
+    clearOutputText = false;
+}
+
 /**
 *SLOT method called after create playlist button clicked.
 *It creates a empty playlist in the TreeModel with name data set by the user on
@@ -158,19 +255,48 @@ void MainWindow::CreatePlaylistSlot()
         playlistModel->setHeadData(dataIndex,childrenHeader[k]);
     }
 
-    //Added code to create playlist online also.
-    spotify->CreatePlaylistWeb(playlist_name,false,"Playlist created by application in C++");
+    //Added code to create playlist online also. The playlist is kept with a local id until the server creates it
+    const QString local_id = OperationQueue::NewLocalId();
+    playlistModel->setData(playlistModel->index(i,1),local_id);
+    network->Post([=](SpotifyAPI *api){ api->CreatePlaylistWeb(playlist_name,false,"Playlist created by application in C++",local_id);} );
+}
+
+/**
+*SLOT method called after a playlist queued by CreatePlaylistSlot() is created on the server.
+*The local id of the playlist in the model is replaced by the server data.
+*@param local_id id given to the playlist when it was queued.
+*@param playlist playlist object received from the server.
+*/
+void MainWindow::PlaylistCreatedSlot(QString local_id, QJsonObject playlist)
+{
+    for(int i = 0; i < playlistModel->rowCount(); i++)
+    {
+        QModelIndex playlist_index = playlistModel->index(i,0);
+        if(playlistModel->findDataByHead("id", playlist_index).toString() != local_id)
+            continue;
+
+        for(int k = 0; k < playlistModel->columnCount(); k++)
+        {
+            const auto dataIndex = playlistModel->index(i,k);
+            const QString head = playlistModel->headData(dataIndex).toString();
+            if(head == "id" || head == "href" || head == "uri")
+                playlistModel->setData(dataIndex, playlist.value(head).toString());
+        }
+        return;
+    }
 }
 
 /**
 *Method to define which rows and colums of the TreeModel data will be displayed in the interface.
 *The visualization of data is based on QTreeView class. In this view only the playlist selected and
 *respective tracks will be displayed.
-*Obs: The TreeModel have a artist column in the tracks children to display the main artist and also
-*artist TreeItem childs of each track to store all the artists of a track.
+*Obs: The TreeModel have a artist column in the tracks children to display the main artist, computed from
+*the artists of each track shared in the model artists registry.
 */
 void  MainWindow::SetTracksView()
 {
+    TRACE_SCOPE("update tracks view", "view");
+
     int playlist_data_count =  tracksView->model()->columnCount();
 
     for(int i = 0;  i < playlist_data_count ; i++)
@@ -181,19 +307,6 @@ void  MainWindow::SetTracksView()
         tracksView->setColumnHidden(i,hide);
     }
 
-    for(int i=0; i< tracksView->model()->rowCount();i++)
-    {
-        const auto playlistIndex = tracksView->model()->index(i,0);
-        for(int j = 0; j < tracksView->model()->rowCount(playlistIndex); j++)
-        {
-            const auto trackIndex = tracksView->model()->index(j,0,playlistIndex);
-
-            //Hide artist rows (childs)
-            for(int k = 0; k<tracksView->model()->rowCount(trackIndex); k++)
-                tracksView->setRowHidden(k,trackIndex,true);
-        }
-    }
-
 }
 
 /**
@@ -203,20 +316,59 @@ void  MainWindow::SetTracksView()
 */
 void MainWindow::SetPlayListView()
 {
-    int playlists_count = playlistsView->model()->rowCount();
+    TRACE_SCOPE("update playlists view", "view");
+
     int playlist_data_count =  playlistsView->model()->columnCount();
 
     for(int i = 1;  i < playlist_data_count ; i++)
         playlistsView->setColumnHidden(i,true);
 
-    for(int i = 0;  i < playlists_count ; i++)
-    {
-        const auto index = playlistsView->model()->index(i,0);
-        int tracks_count = playlistsView->model()->rowCount(index);
+    //Tracks are not expanded in this view, so the tracks inserted while the library is loaded stay hidden
+    playlistsView->setRootIsDecorated(false);
+    playlistsView->setItemsExpandable(false);
+}
 
-        for(int j = 0;  j < tracks_count ; j++)
-            playlistsView->setRowHidden(j,index,true);
-    }
+/**
+*Method called after rows are inserted in the model, e.g. while the library is loaded. Playlists inserted while
+*a playlist is selected are hidden in the tracks view, which shows only the playlist selected.
+*@param parent index of the parent of the rows inserted.
+*@param first first row inserted.
+*@param last last row inserted.
+*/
+void MainWindow::PlaylistsInserted(const QModelIndex &parent, int first, int last)
+{
+    if(parent.isValid() || !playlistsView->currentIndex().isValid())
+        return;
+
+    for(int i = first; i <= last; i++)
+        tracksView->setRowHidden(i, QModelIndex(), true);
+}
+
+/**
+*SLOT method called after each chunk of the library is loaded, to show the progress of the load.
+*@param loaded_rows number of playlists and tracks loaded.
+*@param total_rows number of playlists and tracks of the library.
+*/
+void MainWindow::LoadProgressSlot(int loaded_rows, int total_rows)
+{
+    const int percent = total_rows > 0 ? int(100.0 * loaded_rows / total_rows) : 100;
+    statusBar()->showMessage(QString("Loading library: %1 of %2 rows (%3%)").arg(loaded_rows).arg(total_rows).arg(percent));
+}
+
+/**
+*SLOT method called when the library is loaded.
+*@param loaded false if the library data is incomplete and the model was not set.
+*/
+void MainWindow::LoadFinishedSlot(bool loaded)
+{
+    statusBar()->clearMessage();
+    if(!loaded)
+        return;
+
+    LOG_INFO("ui", QString("Library loaded: %1 rows").arg(modelLoader->loadedRows()));
+
+    if(connected)
+        RequestMissingData();
 }
 
 /**
@@ -227,6 +379,8 @@ void MainWindow::SetPlayListView()
 */
 void MainWindow::PlaylistSelected(const QModelIndex & index)
 {
+    TRACE_SCOPE("select playlist", "view");
+
     int playlists_count = tracksView->model()->rowCount();
     if(index.isValid())
     {
@@ -236,6 +390,17 @@ void MainWindow::PlaylistSelected(const QModelIndex & index)
             bool hide_row = !(tracksView->model()->index(i,0)==index);
             tracksView->setRowHidden(i,tracksView->model()->parent(QModelIndex()),hide_row);
         }
+
+        //Profile of the playlist from the audio features of its tracks
+        const FeatureSummary energy = playlistModel->playlistFeatureSummary(index, AudioFeatureStore::Energy);
+        if(energy.count > 0)
+        {
+            const FeatureSummary danceability = playlistModel->playlistFeatureSummary(index, AudioFeatureStore::Danceability);
+            const FeatureSummary tempo = playlistModel->playlistFeatureSummary(index, AudioFeatureStore::Tempo);
+            LOG_INFO("ui", QString("Playlist features (%1 tracks): danceability = %2, energy = %3, tempo = %4")
+                     .arg(energy.count).arg(danceability.mean(), 0, 'f', 2).arg(energy.mean(), 0, 'f', 2)
+                     .arg(tempo.mean(), 0, 'f', 1));
+        }
     }
 }
 
@@ -256,7 +421,15 @@ void MainWindow::RemoveTrack()
     const auto track_index = tracksView->currentIndex();
 
     if(model->hasIndex(track_index.row(),0,track_index.parent()))
-        model->removeRow(track_index.row(),track_index.parent());
+    {
+        QModelIndex playlist_index = track_index.parent();
+        QModelIndex uri_index = track_index;
+        const QString playlist_id = playlistModel->findDataByHead("id", playlist_index).toString();
+        const QString uri = playlistModel->findDataByHead("uri", uri_index).toString();
+
+        if(model->removeRow(track_index.row(),track_index.parent()) && !playlist_id.isEmpty() && !uri.isEmpty())
+            network->Post([=](SpotifyAPI *api){ api->RemoveTracksWeb(playlist_id, {uri});} );
+    }
 
 }
 
@@ -269,14 +442,14 @@ void MainWindow::SearchClickedSlot()
     ui->addTrackBt->setEnabled(false);
     if(ui->artistRBt->isChecked())
     {
-        //To be implemented
+        GetArtistTracksSlot();
     }
     else if(ui->musicRBt->isChecked())
     {
         QString track_name = ui->searchTxEdit->toPlainText();
 
         //Execute a query to spotify server with the given track name
-        spotify->SearchTrack(track_name);
+        network->Post([=](SpotifyAPI *api){ api->SearchTrack(track_name);} );
     }
 
 }
@@ -289,6 +462,8 @@ void MainWindow::SearchClickedSlot()
 */
 void MainWindow::TracksFoundSlot(QJsonObject data)
 {
+    TRACE_SCOPE("show search results", "view");
+
     const QStringList headers({tr("name"),tr("id"),tr("uri"),tr("href"),tr("artist")});
 
     //Creates the model to store search results from QJson object
@@ -315,8 +490,8 @@ void MainWindow::TracksFoundSlot(QJsonObject data)
 
 /**
 *Method SLOT called after add track button is clicked on the interface.
-*It gets the index of a track selected in the search results view and copy the data to a track child row
-*that is inserted on the playlist TreeItem correspondent to the playlist index selected in the playlist tree view.
+*It gets the index of a track selected in the search results view and inserts the track as a child row
+*of the playlist TreeItem correspondent to the playlist index selected in the playlist tree view.
 *The criation of child row and insertion of data is performed in the playlist TreeModel.
 */
 void MainWindow::AddTrack()
@@ -337,7 +512,7 @@ void MainWindow::AddTrack()
     const auto selTrackIndex = searchResultView->currentIndex();
     if(trackSearchModel->index(selTrackIndex.row(),0) != selTrackIndex)
     {
-        qDebug()<<"Choose a track add to playlist"<<endl;
+        LOG_INFO("ui", "Choose a track add to playlist");
         return;
     }
 
@@ -350,48 +525,20 @@ void MainWindow::AddTrack()
 
     int N_tracks = playlistModel->rowCount(playlist_index);
 
-    //Insert a new child row (a track) to the current playlist
-    if(!playlistModel->insertRow(N_tracks,playlist_index))
+    //Insert the track selected in the search results in the current playlist. The track data and its artists
+    //are shared with the other playlists of the model that contain the same track
+    if(!playlistModel->insertTrack(N_tracks,playlist_index,trackSearchModel->trackJson(selTrackIndex)))
     {
         ui->logPTxEdit->appendPlainText("It was not possible to add track to playlist Tree Model ");
         return;
     }
 
-    const auto newTrackindex = playlistModel->index(playlistModel->rowCount(playlist_index)-1,0,playlist_index);
-
-    playlistsView->setRowHidden(playlistModel->rowCount(playlist_index)-1,playlist_index,true);
-
-    int N_data = playlistModel->columnCount(playlistModel->index(N_tracks,0,playlist_index));
-
-    //Copy data from track item selected in the search result view to the new track created in playlist model
-    for(int i = 0; i< N_data; i++)
-    {
-        const auto indexData = playlistModel->index(N_tracks,i,playlist_index);
-        playlistModel->setData(indexData,trackSearchModel->data(trackSearchModel->index(selTrackIndex.row(),i),Qt::EditRole));
-        playlistModel->setHeadData(indexData,trackSearchModel->headData(trackSearchModel->index(selTrackIndex.row(),i)));
-    }
-
-    int N_artists = trackSearchModel->rowCount(selTrackIndex);
-    N_data = trackSearchModel->columnCount(trackSearchModel->index(0,0,selTrackIndex));
-    for (int j=0; j<N_artists; j++)
-    {
-        //Insert a new child row (a artist) to each track created in the playlist modol
-        if(!playlistModel->insertRow(playlistModel->rowCount(newTrackindex),newTrackindex))
-        {
-            playlistModel->removeRows(playlistModel->rowCount()-1,1);
-            return;
-        }
-
-        //Copy artists data from track item selected in the search result view to the new track created in playlist model
-        for (int k=0; k<N_data; k++)
-        {
-            const auto indexData = playlistModel->index(j,k,newTrackindex);
-            playlistModel->setData(indexData,trackSearchModel->data(trackSearchModel->index(j,k,selTrackIndex),Qt::EditRole));
-            playlistModel->setHeadData(indexData,trackSearchModel->headData(trackSearchModel->index(j,k,selTrackIndex)));
-        }
-        tracksView->setRowHidden(j,newTrackindex,true);
-
-    }
+    QModelIndex playlist_id_index = playlist_index;
+    QModelIndex track_uri_index = selTrackIndex;
+    const QString playlist_id = playlistModel->findDataByHead("id", playlist_id_index).toString();
+    const QString uri = trackSearchModel->findDataByHead("uri", track_uri_index).toString();
+    if(!playlist_id.isEmpty() && !uri.isEmpty())
+        network->Post([=](SpotifyAPI *api){ api->AddTracksWeb(playlist_id, {uri});} );
 }
 
 /**
@@ -410,12 +557,85 @@ void MainWindow::PlayTracks()
     if(data.isNull())
         return;
 
-    spotify->PlayTracks(data.toString());
+    const QString uri = data.toString();
+    network->Post([=](SpotifyAPI *api){ api->PlayTracks(uri);} );
+}
+
+/**
+*Method called after the tracks of a playlist are moved in the model. The playlist is pushed to the server
+*after pushDelayMs without other changes, so a sequence of moves is sent together.
+*@param parent index of the parent of the rows changed.
+*/
+void MainWindow::PlaylistChanged(const QModelIndex &parent)
+{
+    //Only tracks rows of playlists that exist on the server are pushed
+    if(!parent.isValid() || parent.parent().isValid())
+        return;
+
+    QModelIndex playlist_index = parent;
+    const QString playlist_id = playlistModel->findDataByHead("id", playlist_index).toString();
+    if(playlist_id.isEmpty())
+        return;
+
+    changedPlaylists.insert(playlist_id);
+    pushTimer.start();
+}
+
+/**
+*SLOT method called by the push timer to queue a push of the changed playlists. If the application is not
+*connected the playlists are pushed after the connection.
+*/
+void MainWindow::PushPlaylistsSlot()
+{
+    for(int i = 0; i < playlistModel->rowCount(); i++)
+    {
+        QModelIndex playlist_index = playlistModel->index(i,0);
+        const QString playlist_id = playlistModel->findDataByHead("id", playlist_index).toString();
+
+        if(changedPlaylists.contains(playlist_id))
+        {
+            const QStringList uris = playlistModel->trackUris(playlist_index);
+            network->Post([=](SpotifyAPI *api){ api->PushPlaylist(playlist_id, uris);} );
+        }
+    }
+
+    changedPlaylists.clear();
 }
 
 void MainWindow::closeEvent(QCloseEvent *event)
 {
-    //Save user playlists data in Json format
+    //Save user playlists data in Json format, with the rows not loaded yet
+    modelLoader->finish();
     playlistModel->saveModelDataOffline("playlistsdata.json");
     QMainWindow::closeEvent(event);
 }
+
+/**
+*Method SLOT called when the more like this button is clicked.
+*It shows in the search results view the tracks of the playlists most similar to the track selected in the
+*tracks view, or to the playlist selected if no track is selected. Tracks are compared by their audio
+*features, without requests to the server.
+*/
+void MainWindow::SimilarTracksSlot()
+{
+    TRACE_SCOPE("similar tracks", "view");
+
+    QModelIndex index = tracksView->currentIndex();
+    if(!index.isValid() || !index.parent().isValid())
+        index = playlistsView->currentIndex();
+
+    if(!index.isValid())
+    {
+        LOG_INFO("ui", "Choose a track or playlist to find similar tracks");
+        return;
+    }
+
+    const QJsonArray tracks = playlistModel->similarTracks(playlistModel->index(index.row(), 0, index.parent()), similarTracksCount);
+    if(tracks.isEmpty())
+    {
+        LOG_INFO("ui", "No similar tracks found: audio features not received yet");
+        return;
+    }
+
+    TracksFoundSlot(QJsonObject({{"tracks", tracks}}));
+}
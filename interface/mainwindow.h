@@ -3,8 +3,11 @@
 
 #include <QMainWindow>
 #include <QtUiTools>
-#include "api/spotifyapi.h"
+#include <QDesktopServices>
+#include "api/networkthread.h"
 #include "models/treemodel.h"
+#include "models/modelloader.h"
+#include "utils/logger.h"
 
 
 QT_BEGIN_NAMESPACE
@@ -39,17 +42,29 @@ private slots:
 
     //Slot methods called after a SpotifyAPI object sigal is emitted
     void UpdateOutputTextSlot(QString text, bool clear);
+    void FlushOutputTextSlot();
+    void PushPlaylistsSlot();
     void ConnectGrantedSlot();
     void ArtistTracksFoundSlot();
     void TracksFoundSlot(QJsonObject data);
+    void PlaylistCreatedSlot(QString local_id, QJsonObject playlist);
 
     //Slot methos called after user interaction with interface
     void PlaylistSelected(const QModelIndex & index);
     void RemoveTrack();
     void AddTrack();
     void PlayTracks();
+    void SimilarTracksSlot();
+
+    //Slot methods called while the library is loaded
+    void LoadProgressSlot(int loaded_rows, int total_rows);
+    void LoadFinishedSlot(bool loaded);
 
 private:
+    void PlaylistChanged(const QModelIndex &parent);
+    void PlaylistsInserted(const QModelIndex &parent, int first, int last);
+    void RequestMissingData();
+
     Ui::MainWindow *ui;
 
     //Visualization objects to display data
@@ -60,8 +75,24 @@ private:
     //Model to handle data (playlists/tracks/artists)
     TreeModel *playlistModel;
 
-    //Spotfy handle to perform server requests and queries
-    SpotifyAPI *spotify;
+    //Loads the library in the model in chunks, without blocking the interface
+    ModelLoader *modelLoader;
+    bool connected;
+
+    //Spotfy handle running in the network thread to perform server requests and queries
+    NetworkThread *network;
+
+    //Receives warnings and errors of the logger, shown in batches in the log box
+    LogUiSink *logSink;
+
+    //Messages waiting to be appended to the log box in the next flush
+    QStringList pendingOutputText;
+    bool clearOutputText;
+    QTimer outputFlushTimer;
+
+    //Ids of the playlists with tracks moved since the last push, and timer of the next push
+    QSet<QString> changedPlaylists;
+    QTimer pushTimer;
 
 
 };
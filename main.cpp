@@ -1,11 +1,22 @@
 #include "interface/mainwindow.h"
+#include "utils/tracer.h"
+#include "utils/logger.h"
 #include <QApplication>
 
 
 int main(int argc, char *argv[])
 {
+    Tracer::EnableFromEnvironment();
+    Logger::Start();
+
     QApplication a(argc, argv);
     MainWindow w;
     w.show();
-    return a.exec();
+    const int result = a.exec();
+    Logger::Stop();
+
+    if(Tracer::IsEnabled())
+        Tracer::WriteChromeTrace(Tracer::TraceFile());
+
+    return result;
 }
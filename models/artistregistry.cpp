@@ -0,0 +1,90 @@
+#include "artistregistry.h"
+#include "stringpool.h"
+
+ArtistRegistry::ArtistRegistry()
+{}
+
+ArtistRegistry::~ArtistRegistry()
+{
+    clear();
+}
+
+QString ArtistRegistry::key(const QString &name, const QString &id)
+{
+    return id.isEmpty() ? "name:" + name : id;
+}
+
+/**
+Method to get the shared entry of an artist, creating it if the artist is not in the registry yet.
+The data of an existing entry is kept.
+@param name name of the artist.
+@param id spotify id of the artist, empty for artists of local files.
+@param href web api address of the artist.
+@param uri spotify uri of the artist.
+@return the artist entry owned by the registry.
+*/
+ArtistEntry *ArtistRegistry::intern(const QString &name, const QString &id, const QString &href, const QString &uri)
+{
+    const QString artistKey = key(name, id);
+
+    auto it = artists.constFind(artistKey);
+    if(it != artists.constEnd())
+        return it.value();
+
+    StringPool &pool = StringPool::global();
+
+    ArtistEntry *artist = new ArtistEntry;
+    artist->name = pool.intern(name);
+    artist->id = pool.intern(id);
+    artist->href = pool.intern(href);
+    artist->uri = pool.intern(uri);
+
+    artists.insert(artistKey, artist);
+    return artist;
+}
+
+/**
+Method to get the shared entry of an artist from its Json object (keys name, id, href and uri).
+*/
+ArtistEntry *ArtistRegistry::intern(const QJsonObject &artistJson)
+{
+    return intern(artistJson.value("name").toString(),
+                  artistJson.value("id").toString(),
+                  artistJson.value("href").toString(),
+                  artistJson.value("uri").toString());
+}
+
+/**
+Method to find an artist by id.
+@param id spotify id of the artist (or "name:" + name for artists without id).
+@return the artist entry, nullptr if the artist is not in the registry.
+*/
+ArtistEntry *ArtistRegistry::artist(const QString &id) const
+{
+    return artists.value(id, nullptr);
+}
+
+int ArtistRegistry::count() const
+{
+    return artists.size();
+}
+
+/**
+Method to delete all entries. Must only be called when no TreeItem refers to them.
+*/
+void ArtistRegistry::clear()
+{
+    qDeleteAll(artists);
+    artists.clear();
+}
+
+/**
+Method to get the Json object of an artist in the format of the playlists files.
+*/
+QJsonObject ArtistRegistry::toJson(const ArtistEntry *artist)
+{
+    return QJsonObject({{"name", artist->name},
+                        {"id", artist->id},
+                        {"href", artist->href},
+                        {"uri", artist->uri}});
+}
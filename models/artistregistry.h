@@ -0,0 +1,56 @@
+#ifndef ARTISTREGISTRY_H
+#define ARTISTREGISTRY_H
+
+#include <QString>
+#include <QHash>
+#include <QSet>
+#include <QVector>
+#include <QJsonObject>
+
+struct TrackEntry;
+
+/**
+ * Data of an artist shared by all tracks of the artist in a TreeModel.
+ * The set of tracks is kept by the track entries, which add and remove themselves when their artists change.
+ */
+struct ArtistEntry
+{
+    QString name;
+    QString id;
+    QString href;
+    QString uri;
+
+    QSet<TrackEntry*> tracks;
+};
+
+/**
+ * Implementation of ArtistRegistry class to store each artist of a TreeModel only once.
+ *
+ * Artists are interned by id (or by name for artists without id, such as artists of local files), so
+ * tracks hold references to the shared entries instead of copies of the artist data. The registry owns
+ * the entries and must outlive the tracks that refer to them.
+ */
+class ArtistRegistry
+{
+public:
+    ArtistRegistry();
+    ~ArtistRegistry();
+
+    ArtistEntry *intern(const QString &name, const QString &id, const QString &href, const QString &uri);
+    ArtistEntry *intern(const QJsonObject &artistJson);
+    ArtistEntry *artist(const QString &id) const;
+    int count() const;
+    void clear();
+
+    static QJsonObject toJson(const ArtistEntry *artist);
+
+private:
+    ArtistRegistry(const ArtistRegistry&) = delete;
+    ArtistRegistry &operator=(const ArtistRegistry&) = delete;
+
+    static QString key(const QString &name, const QString &id);
+
+    QHash<QString, ArtistEntry*> artists;
+};
+
+#endif // ARTISTREGISTRY_H
@@ -0,0 +1,216 @@
+#include "audiofeaturestore.h"
+#include "stringpool.h"
+
+#include <QSet>
+
+static const char *featureNames[] = {"danceability", "energy", "loudness", "speechiness", "acousticness",
+                                     "instrumentalness", "liveness", "valence", "tempo"};
+
+AudioFeatureStore::AudioFeatureStore()
+    : normalizedValid(false)
+{}
+
+/**
+Method to get the name of a feature, the same as in the Json data of the audio features endpoint.
+*/
+const char *AudioFeatureStore::featureName(int feature)
+{
+    return feature >= 0 && feature < FeaturesCount ? featureNames[feature] : "";
+}
+
+int AudioFeatureStore::count() const
+{
+    return ids.size();
+}
+
+/**
+Method to find the row of a track.
+@param trackId spotify id of the track.
+@return the row, -1 if the store doesn't have the features of the track.
+*/
+int AudioFeatureStore::row(const QString &trackId) const
+{
+    return rows.value(trackId, -1);
+}
+
+QString AudioFeatureStore::trackId(int trackRow) const
+{
+    return ids.value(trackRow);
+}
+
+float AudioFeatureStore::value(int trackRow, Feature feature) const
+{
+    return columns[feature][trackRow];
+}
+
+/**
+Method to get the values of a feature for all tracks, in row order.
+@return pointer to count() values, valid until the store changes.
+*/
+const float *AudioFeatureStore::column(Feature feature) const
+{
+    return columns[feature].constData();
+}
+
+/**
+Method to store the audio features of a track. The features of a track already stored are replaced.
+@param featuresJson Json object of the audio features endpoint (id and a value for each feature).
+@return false if the object doesn't have the id or a feature of the track.
+*/
+bool AudioFeatureStore::set(const QJsonObject &featuresJson)
+{
+    const QString id = featuresJson.value("id").toString();
+    if(id.isEmpty())
+        return false;
+
+    for(int feature = 0; feature < FeaturesCount; feature++)
+        if(!featuresJson.value(featureNames[feature]).isDouble())
+            return false;
+
+    int trackRow = row(id);
+    if(trackRow < 0)
+    {
+        trackRow = ids.size();
+        rows.insert(id, trackRow);
+        ids.append(StringPool::global().intern(id));
+        for(int feature = 0; feature < FeaturesCount; feature++)
+            columns[feature].append(0.0f);
+    }
+
+    for(int feature = 0; feature < FeaturesCount; feature++)
+        columns[feature][trackRow] = float(featuresJson.value(featureNames[feature]).toDouble());
+
+    normalizedValid = false;
+    return true;
+}
+
+/**
+Method to store the audio features of several tracks, as received in the audio features endpoint (tracks
+not found are null and are skipped).
+@return number of tracks stored.
+*/
+int AudioFeatureStore::set(const QJsonArray &featuresArray)
+{
+    int stored = 0;
+    for(const auto features : featuresArray)
+        if(set(features.toObject()))
+            stored++;
+
+    return stored;
+}
+
+/**
+Method to get the ids of tracks without features in the store.
+@param trackIds ids of the tracks.
+@return ids without features, once each.
+*/
+QStringList AudioFeatureStore::missingIds(const QStringList &trackIds) const
+{
+    QStringList missing;
+    QSet<QString> added;
+
+    for(const QString &id : trackIds)
+    {
+        if(id.isEmpty() || rows.contains(id) || added.contains(id))
+            continue;
+
+        added.insert(id);
+        missing.append(id);
+    }
+
+    return missing;
+}
+
+void AudioFeatureStore::clear()
+{
+    rows.clear();
+    ids.clear();
+    for(int feature = 0; feature < FeaturesCount; feature++)
+    {
+        columns[feature].clear();
+        normalized[feature].clear();
+    }
+    normalizedValid = false;
+}
+
+/**
+Method to get the minimum, maximum, mean and deviation of a feature over all tracks of the store.
+*/
+FeatureSummary AudioFeatureStore::summary(Feature feature) const
+{
+    return FeatureKernels::summarize(columns[feature].constData(), count());
+}
+
+/**
+Method to get the summary of a feature over some tracks, e.g. the tracks of a playlist.
+@param feature feature summarized.
+@param trackRows rows of the tracks, a track can be repeated.
+*/
+FeatureSummary AudioFeatureStore::summary(Feature feature, const QVector<int> &trackRows) const
+{
+    //Values are gathered in a contiguous array so the summary is computed by the kernels
+    QVector<float> values;
+    values.reserve(trackRows.size());
+    for(const int trackRow : trackRows)
+        values.append(columns[feature][trackRow]);
+
+    return FeatureKernels::summarize(values.constData(), values.size());
+}
+
+/**
+Method to get the normalized values of a feature (z-score: difference to the mean divided by the deviation),
+so all features weigh the same in distances.
+@return pointer to count() values, valid until the store changes.
+*/
+const float *AudioFeatureStore::normalizedColumn(Feature feature) const
+{
+    normalizeColumns();
+    return normalized[feature].constData();
+}
+
+/**
+Method to get the normalized features of a track, in feature order.
+*/
+QVector<float> AudioFeatureStore::normalizedRow(int trackRow) const
+{
+    normalizeColumns();
+
+    QVector<float> features(FeaturesCount);
+    for(int feature = 0; feature < FeaturesCount; feature++)
+        features[feature] = normalized[feature][trackRow];
+
+    return features;
+}
+
+/**
+Method to compute the squared euclidean distance of the normalized features of each track to a query.
+@param query normalized value of each feature, e.g. normalizedRow() of a track or the mean of several rows.
+@param distances distances of the tracks in row order, resized to count().
+*/
+void AudioFeatureStore::squaredDistances(const QVector<float> &query, QVector<float> &distances) const
+{
+    normalizeColumns();
+
+    distances.fill(0.0f, count());
+    for(int feature = 0; feature < FeaturesCount && feature < query.size(); feature++)
+        FeatureKernels::addSquaredDistance(normalized[feature].constData(), query[feature], distances.data(), count());
+}
+
+void AudioFeatureStore::normalizeColumns() const
+{
+    if(normalizedValid)
+        return;
+
+    for(int feature = 0; feature < FeaturesCount; feature++)
+    {
+        const FeatureSummary featureSummary = summary(Feature(feature));
+        const double deviation = featureSummary.deviation();
+
+        normalized[feature].resize(count());
+        FeatureKernels::normalize(columns[feature].constData(), float(featureSummary.mean()),
+                                  deviation > 0.0 ? float(1.0 / deviation) : 0.0f,
+                                  normalized[feature].data(), count());
+    }
+
+    normalizedValid = true;
+}
@@ -0,0 +1,61 @@
+#ifndef AUDIOFEATURESTORE_H
+#define AUDIOFEATURESTORE_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QVector>
+#include <QJsonObject>
+#include <QJsonArray>
+#include "featurekernels.h"
+
+/**
+ * Implementation of AudioFeatureStore class to store the audio features of the tracks of the library
+ * (danceability, energy, tempo, etc., as returned by the audio features endpoint).
+ *
+ * The store is columnar: each feature is a contiguous array of floats with one value per track, and tracks
+ * are rows found by track id. Loops over all tracks of a feature read a single array, so they are computed
+ * by the vectorized FeatureKernels: summaries of a feature, normalization of the features (z-score, cached
+ * until the store changes) and squared distances of all tracks to a vector of normalized features.
+ */
+class AudioFeatureStore
+{
+public:
+    enum Feature {Danceability, Energy, Loudness, Speechiness, Acousticness, Instrumentalness, Liveness,
+                  Valence, Tempo, FeaturesCount};
+
+    AudioFeatureStore();
+
+    static const char *featureName(int feature);
+
+    int count() const;
+    int row(const QString &trackId) const;
+    QString trackId(int trackRow) const;
+    float value(int trackRow, Feature feature) const;
+    const float *column(Feature feature) const;
+
+    bool set(const QJsonObject &featuresJson);
+    int set(const QJsonArray &featuresArray);
+    QStringList missingIds(const QStringList &trackIds) const;
+    void clear();
+
+    FeatureSummary summary(Feature feature) const;
+    FeatureSummary summary(Feature feature, const QVector<int> &trackRows) const;
+
+    const float *normalizedColumn(Feature feature) const;
+    QVector<float> normalizedRow(int trackRow) const;
+    void squaredDistances(const QVector<float> &query, QVector<float> &distances) const;
+
+private:
+    void normalizeColumns() const;
+
+    QHash<QString, int> rows;
+    QStringList ids;
+    QVector<float> columns[FeaturesCount];
+
+    //Normalized columns, computed on demand after the store changes
+    mutable QVector<float> normalized[FeaturesCount];
+    mutable bool normalizedValid;
+};
+
+#endif // AUDIOFEATURESTORE_H
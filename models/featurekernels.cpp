@@ -0,0 +1,305 @@
+#include "featurekernels.h"
+
+#include <cmath>
+#include <algorithm>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FEATUREKERNELS_SSE
+#include <emmintrin.h>
+#endif
+
+//AVX versions are compiled for their own target, so the rest of the application doesn't require AVX
+#if defined(FEATUREKERNELS_SSE) && defined(__GNUC__)
+#define FEATUREKERNELS_AVX
+#include <immintrin.h>
+#define AVX_TARGET __attribute__((target("avx")))
+#endif
+
+//Number of values summed in float lanes before the partial sums are added in double
+static const int summaryBlock = 4096;
+
+double FeatureSummary::mean() const
+{
+    return count > 0 ? sum / count : 0.0;
+}
+
+double FeatureSummary::deviation() const
+{
+    if(count <= 0)
+        return 0.0;
+
+    const double variance = sumSquares / count - mean() * mean();
+    return variance > 0.0 ? std::sqrt(variance) : 0.0;
+}
+
+static FeatureSummary emptySummary()
+{
+    return {0, std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest(), 0.0, 0.0};
+}
+
+static void addToSummary(FeatureSummary &summary, const float *column, int count)
+{
+    for(int i = 0; i < count; i++)
+    {
+        summary.minimum = std::min(summary.minimum, column[i]);
+        summary.maximum = std::max(summary.maximum, column[i]);
+        summary.sum += column[i];
+        summary.sumSquares += double(column[i]) * column[i];
+    }
+    summary.count += count;
+}
+
+/*
+ * Scalar kernels, also used for the last values of the vectorized kernels
+ */
+
+static void addSquaredDistanceScalar(const float *column, float value, float *distances, int count)
+{
+    for(int i = 0; i < count; i++)
+    {
+        const float difference = column[i] - value;
+        distances[i] += difference * difference;
+    }
+}
+
+static void normalizeScalar(const float *column, float offset, float scale, float *normalized, int count)
+{
+    for(int i = 0; i < count; i++)
+        normalized[i] = (column[i] - offset) * scale;
+}
+
+#ifndef FEATUREKERNELS_SSE
+static FeatureSummary summarizeScalar(const float *column, int count)
+{
+    FeatureSummary summary = emptySummary();
+    addToSummary(summary, column, count);
+    return summary;
+}
+#endif
+
+#ifdef FEATUREKERNELS_SSE
+
+static float horizontalSum(__m128 lanes)
+{
+    float values[4];
+    _mm_storeu_ps(values, lanes);
+    return (values[0] + values[1]) + (values[2] + values[3]);
+}
+
+static void addSquaredDistanceSse(const float *column, float value, float *distances, int count)
+{
+    const __m128 query = _mm_set1_ps(value);
+
+    int i = 0;
+    for(; i + 4 <= count; i += 4)
+    {
+        const __m128 difference = _mm_sub_ps(_mm_loadu_ps(column + i), query);
+        _mm_storeu_ps(distances + i, _mm_add_ps(_mm_loadu_ps(distances + i), _mm_mul_ps(difference, difference)));
+    }
+    addSquaredDistanceScalar(column + i, value, distances + i, count - i);
+}
+
+static void normalizeSse(const float *column, float offset, float scale, float *normalized, int count)
+{
+    const __m128 offsets = _mm_set1_ps(offset);
+    const __m128 scales = _mm_set1_ps(scale);
+
+    int i = 0;
+    for(; i + 4 <= count; i += 4)
+        _mm_storeu_ps(normalized + i, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(column + i), offsets), scales));
+    normalizeScalar(column + i, offset, scale, normalized + i, count - i);
+}
+
+static FeatureSummary summarizeSse(const float *column, int count)
+{
+    FeatureSummary summary = emptySummary();
+    __m128 minimum = _mm_set1_ps(summary.minimum);
+    __m128 maximum = _mm_set1_ps(summary.maximum);
+
+    int i = 0;
+    while(i + 4 <= count)
+    {
+        __m128 sum = _mm_setzero_ps();
+        __m128 sumSquares = _mm_setzero_ps();
+
+        const int blockEnd = std::min(count, i + summaryBlock) & ~3;
+        for(; i < blockEnd; i += 4)
+        {
+            const __m128 values = _mm_loadu_ps(column + i);
+            minimum = _mm_min_ps(minimum, values);
+            maximum = _mm_max_ps(maximum, values);
+            sum = _mm_add_ps(sum, values);
+            sumSquares = _mm_add_ps(sumSquares, _mm_mul_ps(values, values));
+        }
+
+        summary.sum += horizontalSum(sum);
+        summary.sumSquares += horizontalSum(sumSquares);
+    }
+
+    float minimums[4], maximums[4];
+    _mm_storeu_ps(minimums, minimum);
+    _mm_storeu_ps(maximums, maximum);
+    for(int lane = 0; lane < 4; lane++)
+    {
+        summary.minimum = std::min(summary.minimum, minimums[lane]);
+        summary.maximum = std::max(summary.maximum, maximums[lane]);
+    }
+    summary.count = i;
+
+    addToSummary(summary, column + i, count - i);
+    return summary;
+}
+
+#endif
+
+#ifdef FEATUREKERNELS_AVX
+
+AVX_TARGET static float horizontalSumAvx(__m256 lanes)
+{
+    float values[8];
+    _mm256_storeu_ps(values, lanes);
+    return ((values[0] + values[1]) + (values[2] + values[3])) + ((values[4] + values[5]) + (values[6] + values[7]));
+}
+
+AVX_TARGET static void addSquaredDistanceAvx(const float *column, float value, float *distances, int count)
+{
+    const __m256 query = _mm256_set1_ps(value);
+
+    int i = 0;
+    for(; i + 8 <= count; i += 8)
+    {
+        const __m256 difference = _mm256_sub_ps(_mm256_loadu_ps(column + i), query);
+        _mm256_storeu_ps(distances + i, _mm256_add_ps(_mm256_loadu_ps(distances + i),
+                                                      _mm256_mul_ps(difference, difference)));
+    }
+    addSquaredDistanceScalar(column + i, value, distances + i, count - i);
+}
+
+AVX_TARGET static void normalizeAvx(const float *column, float offset, float scale, float *normalized, int count)
+{
+    const __m256 offsets = _mm256_set1_ps(offset);
+    const __m256 scales = _mm256_set1_ps(scale);
+
+    int i = 0;
+    for(; i + 8 <= count; i += 8)
+        _mm256_storeu_ps(normalized + i, _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(column + i), offsets), scales));
+    normalizeScalar(column + i, offset, scale, normalized + i, count - i);
+}
+
+AVX_TARGET static FeatureSummary summarizeAvx(const float *column, int count)
+{
+    FeatureSummary summary = emptySummary();
+    __m256 minimum = _mm256_set1_ps(summary.minimum);
+    __m256 maximum = _mm256_set1_ps(summary.maximum);
+
+    int i = 0;
+    while(i + 8 <= count)
+    {
+        __m256 sum = _mm256_setzero_ps();
+        __m256 sumSquares = _mm256_setzero_ps();
+
+        const int blockEnd = std::min(count, i + summaryBlock) & ~7;
+        for(; i < blockEnd; i += 8)
+        {
+            const __m256 values = _mm256_loadu_ps(column + i);
+            minimum = _mm256_min_ps(minimum, values);
+            maximum = _mm256_max_ps(maximum, values);
+            sum = _mm256_add_ps(sum, values);
+            sumSquares = _mm256_add_ps(sumSquares, _mm256_mul_ps(values, values));
+        }
+
+        summary.sum += horizontalSumAvx(sum);
+        summary.sumSquares += horizontalSumAvx(sumSquares);
+    }
+
+    float minimums[8], maximums[8];
+    _mm256_storeu_ps(minimums, minimum);
+    _mm256_storeu_ps(maximums, maximum);
+    for(int lane = 0; lane < 8; lane++)
+    {
+        summary.minimum = std::min(summary.minimum, minimums[lane]);
+        summary.maximum = std::max(summary.maximum, maximums[lane]);
+    }
+    summary.count = i;
+
+    addToSummary(summary, column + i, count - i);
+    return summary;
+}
+
+#endif
+
+/**
+ * Versions of the kernels used, chosen from the instruction sets of the processor.
+ */
+struct KernelsTable
+{
+    void (*addSquaredDistance)(const float*, float, float*, int);
+    void (*normalize)(const float*, float, float, float*, int);
+    FeatureSummary (*summarize)(const float*, int);
+    const char *instructionSet;
+};
+
+static KernelsTable selectKernels()
+{
+#ifdef FEATUREKERNELS_AVX
+    if(__builtin_cpu_supports("avx"))
+        return {addSquaredDistanceAvx, normalizeAvx, summarizeAvx, "avx"};
+#endif
+#ifdef FEATUREKERNELS_SSE
+    return {addSquaredDistanceSse, normalizeSse, summarizeSse, "sse"};
+#else
+    return {addSquaredDistanceScalar, normalizeScalar, summarizeScalar, "scalar"};
+#endif
+}
+
+static const KernelsTable &kernels()
+{
+    static const KernelsTable table = selectKernels();
+    return table;
+}
+
+/**
+Method to add the squared distances of the values of a column to a value: distances[i] += (column[i] - value)^2.
+Called for each feature, the distances accumulate the squared euclidean distance to a query vector.
+@param column values of a feature.
+@param value value of the feature in the query.
+@param distances distances accumulated, with count values.
+@param count number of values.
+*/
+void FeatureKernels::addSquaredDistance(const float *column, float value, float *distances, int count)
+{
+    kernels().addSquaredDistance(column, value, distances, count);
+}
+
+/**
+Method to normalize the values of a column: normalized[i] = (column[i] - offset) * scale.
+@param column values of a feature.
+@param offset value subtracted, e.g. the mean.
+@param scale factor applied after the offset, e.g. the inverse of the deviation.
+@param normalized values normalized, with count values (can be the column itself).
+@param count number of values.
+*/
+void FeatureKernels::normalize(const float *column, float offset, float scale, float *normalized, int count)
+{
+    kernels().normalize(column, offset, scale, normalized, count);
+}
+
+/**
+Method to get the minimum, maximum, sum and sum of squares of the values of a column.
+@param column values of a feature.
+@param count number of values.
+@return the summary, with minimum greater than maximum if count is 0.
+*/
+FeatureSummary FeatureKernels::summarize(const float *column, int count)
+{
+    return kernels().summarize(column, count);
+}
+
+/**
+Method to get the name of the instruction set of the kernels used: avx, sse or scalar.
+*/
+const char *FeatureKernels::instructionSet()
+{
+    return kernels().instructionSet;
+}
@@ -0,0 +1,40 @@
+#ifndef FEATUREKERNELS_H
+#define FEATUREKERNELS_H
+
+/**
+ * Summary of a column of feature values: minimum, maximum, sum and sum of squares.
+ */
+struct FeatureSummary
+{
+    int count;
+    float minimum;
+    float maximum;
+    double sum;
+    double sumSquares;
+
+    double mean() const;
+    double deviation() const;
+};
+
+/**
+ * Implementation of FeatureKernels class, the vectorized loops over columns of float values used by the audio
+ * features store: distances to a query, normalization and summaries.
+ *
+ * Each kernel has a scalar, an SSE (4 floats per instruction) and an AVX (8 floats per instruction) version.
+ * The version is chosen once, when the kernels are first used, from the instruction sets of the processor:
+ * AVX when the processor supports it (checked at run time, so the application doesn't require AVX), SSE on
+ * x86 processors and scalar elsewhere. Columns don't need to be aligned.
+ * Sums are accumulated in float lanes in blocks and each block is added in double, so long columns keep
+ * their precision.
+ */
+class FeatureKernels
+{
+public:
+    static void addSquaredDistance(const float *column, float value, float *distances, int count);
+    static void normalize(const float *column, float offset, float scale, float *normalized, int count);
+    static FeatureSummary summarize(const float *column, int count);
+
+    static const char *instructionSet();
+};
+
+#endif // FEATUREKERNELS_H
@@ -0,0 +1,240 @@
+#include "modelloader.h"
+#include "utils/tracer.h"
+#include "utils/logger.h"
+
+#include <QFile>
+#include <QJsonDocument>
+#include <QElapsedTimer>
+
+//Time spent inserting rows in each chunk, so the frames painted while loading are not delayed
+static const int defaultFrameBudgetMs = 8;
+
+//Tracks of a playlist appended with one insertion of rows, the budget is checked between insertions
+static const int chunkRows = 256;
+
+ModelLoader::ModelLoader(TreeModel *treeModel, QObject *parent)
+    : QObject(parent),
+      model(treeModel),
+      frameBudgetMs(defaultFrameBudgetMs),
+      playlistPosition(0),
+      trackPosition(-1),
+      loading(false),
+      rowsLoaded(0),
+      rowsCount(0)
+{
+    //Each chunk is inserted after the events waiting when the previous one finished
+    chunkTimer.setSingleShot(true);
+    chunkTimer.setInterval(0);
+    connect(&chunkTimer, &QTimer::timeout, this, &ModelLoader::loadChunk);
+}
+
+/**
+Method to load the playlists file in the model (see TreeModel::loadModelData). The file is read and parsed
+at once, the rows are inserted in chunks after this method returns.
+@param filePath the file name and path.
+@return false if the file can't be opened.
+*/
+bool ModelLoader::loadFile(const QString &filePath)
+{
+    TRACE_SCOPE("load model file", "model");
+
+    QFile loadFile(filePath);
+
+    if (!loadFile.open(QIODevice::ReadOnly)) {
+        LOG_WARNING("model", "Couldn't open file " + filePath);
+        return false;
+    }
+
+    QJsonObject root_obj;
+    {
+        TRACE_SCOPE("parse json", "json");
+        root_obj = QJsonDocument::fromJson(loadFile.readAll()).object();
+    }
+
+    load(root_obj);
+    return true;
+}
+
+/**
+Method to start the load of a library in the model, in the format of the playlists file. A load in progress
+is stopped and its rows are kept. finishedSignal is emitted when all the rows are inserted.
+@param libraryJson Json object with the playlists array.
+*/
+void ModelLoader::load(const QJsonObject &libraryJson)
+{
+    chunkTimer.stop();
+
+    model->modelType = MODEL_TYPE_PLAYLIST;
+    playlistsJson = libraryJson.value("playlists").toArray();
+    playlistPosition = 0;
+    playlistIndex = QPersistentModelIndex();
+    tracksJson = QJsonArray();
+    trackPosition = -1;
+    rowsLoaded = 0;
+    rowsCount = 0;
+
+    for(const auto playlistValue : playlistsJson)
+        rowsCount += 1 + playlistValue.toObject().value("tracks").toArray().size();
+
+    if(playlistsJson.isEmpty())
+    {
+        stop(false);
+        return;
+    }
+
+    loading = true;
+    emit progressSignal(rowsLoaded, rowsCount);
+    chunkTimer.start();
+}
+
+/**
+Method to insert at once the rows not loaded yet, e.g. before the model is saved when the application is closed.
+*/
+void ModelLoader::finish()
+{
+    if(!loading)
+        return;
+
+    TRACE_SCOPE("finish model load", "model");
+
+    chunkTimer.stop();
+    insertRows(-1);
+
+    if(loading)
+    {
+        emit progressSignal(rowsLoaded, rowsCount);
+        stop(true);
+    }
+}
+
+bool ModelLoader::isLoading() const
+{
+    return loading;
+}
+
+int ModelLoader::loadedRows() const
+{
+    return rowsLoaded;
+}
+
+int ModelLoader::totalRows() const
+{
+    return rowsCount;
+}
+
+/**
+Method to set the time spent inserting rows in each chunk.
+@param milliseconds time of each chunk, at least one row is inserted in a chunk.
+*/
+void ModelLoader::setFrameBudget(int milliseconds)
+{
+    frameBudgetMs = qMax(0, milliseconds);
+}
+
+/**
+SLOT method called by the chunk timer to insert the next chunk of rows and schedule the following one.
+*/
+void ModelLoader::loadChunk()
+{
+    TRACE_SCOPE("load model chunk", "model");
+
+    const bool pending = insertRows(frameBudgetMs);
+
+    //The load failed and was already stopped
+    if(!loading)
+        return;
+
+    emit progressSignal(rowsLoaded, rowsCount);
+
+    if(pending)
+        chunkTimer.start();
+    else
+        stop(true);
+}
+
+/**
+Method to append the next playlists and tracks of the library to the model. A playlist is appended first,
+without tracks, and its tracks are appended in ranges of chunkRows. If a playlist is removed from the model
+while its tracks are loaded, the rest of its tracks are skipped.
+@param budgetMs time after which no more rows are inserted, negative to insert all rows.
+@return true if there are rows left to insert.
+*/
+bool ModelLoader::insertRows(int budgetMs)
+{
+    QElapsedTimer budgetTimer;
+    budgetTimer.start();
+
+    while(playlistPosition < playlistsJson.size())
+    {
+        if(trackPosition < 0)
+        {
+            const QJsonObject playlistJson = playlistsJson[playlistPosition].toObject();
+            tracksJson = playlistJson.value("tracks").toArray();
+            playlistIndex = model->appendPlaylistFromJson(playlistJson);
+
+            //A playlist with incomplete data is skipped with its tracks, the rest of the library is loaded.
+            //Playlists without tracks (e.g. created and not filled yet) are kept
+            if(!playlistIndex.isValid())
+                LOG_WARNING("model", QString("Playlist %1 of the library skipped: incomplete data").arg(playlistPosition));
+
+            trackPosition = 0;
+            rowsLoaded++;
+        }
+        else if(!playlistIndex.isValid())
+        {
+            rowsLoaded += tracksJson.size() - trackPosition;
+            trackPosition = tracksJson.size();
+        }
+        else
+        {
+            const int count = qMin(chunkRows, tracksJson.size() - trackPosition);
+
+            //A range with a track with incomplete data is appended one track at a time, skipping that track
+            if(!model->appendTracksFromJson(playlistIndex, tracksJson, trackPosition, count))
+            {
+                for(int i = trackPosition; i < trackPosition + count; i++)
+                {
+                    if(!model->appendTracksFromJson(playlistIndex, tracksJson, i, 1))
+                        LOG_WARNING("model", QString("Track %1 of playlist %2 skipped: incomplete data")
+                                    .arg(i).arg(playlistPosition));
+                }
+            }
+
+            trackPosition += count;
+            rowsLoaded += count;
+        }
+
+        if(trackPosition == tracksJson.size())
+        {
+            playlistPosition++;
+            playlistIndex = QPersistentModelIndex();
+            tracksJson = QJsonArray();
+            trackPosition = -1;
+        }
+
+        if(budgetMs >= 0 && budgetTimer.elapsed() >= budgetMs)
+            return playlistPosition < playlistsJson.size();
+    }
+
+    return false;
+}
+
+/**
+Method to end the load. The rows already loaded are kept, they may have been edited during the load.
+@param loaded true if the library was loaded, false if it has no playlists (e.g. the file is not valid Json).
+*/
+void ModelLoader::stop(bool loaded)
+{
+    chunkTimer.stop();
+    loading = false;
+
+    //The parsed library is released, the model keeps its own copy of the data
+    playlistsJson = QJsonArray();
+    tracksJson = QJsonArray();
+    playlistIndex = QPersistentModelIndex();
+
+    if(!loaded)
+        LOG_WARNING("model", "Model not set: the library has no playlists");
+
+    emit finishedSignal(loaded);
+}
@@ -0,0 +1,67 @@
+#ifndef MODELLOADER_H
+#define MODELLOADER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QPersistentModelIndex>
+#include "treemodel.h"
+
+/**
+ * Implementation of ModelLoader class to fill a TreeModel with a playlists library without blocking the
+ * interface, e.g. the playlists file at startup.
+ *
+ * The playlists and tracks are appended in chunks: each chunk inserts rows until the frame budget is spent
+ * and the next chunk runs after the events waiting in the event loop (painting, scrolling, input). The rows
+ * are inserted with the model signals, so the views show the library while it is loaded, and the progress
+ * is emitted after each chunk. Data of the model already loaded can be used and edited during the load.
+ *
+ * The data is checked like in TreeModel::loadModelData, but a playlist or track with incomplete data is skipped
+ * with a warning instead of stopping the load, so the rows already shown (and edited) are kept. Playlists
+ * without tracks are loaded.
+ */
+class ModelLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    ModelLoader(TreeModel *treeModel, QObject *parent = nullptr);
+
+    bool loadFile(const QString &filePath);
+    void load(const QJsonObject &libraryJson);
+    void finish();
+
+    bool isLoading() const;
+    int loadedRows() const;
+    int totalRows() const;
+    void setFrameBudget(int milliseconds);
+
+signals:
+    void progressSignal(int loadedRows, int totalRows);
+    void finishedSignal(bool loaded);
+
+private slots:
+    void loadChunk();
+
+private:
+    bool insertRows(int budgetMs);
+    void stop(bool loaded);
+
+    TreeModel *model;
+    QTimer chunkTimer;
+    int frameBudgetMs;
+
+    //Playlists of the library, the playlist being loaded and the position of its next track
+    QJsonArray playlistsJson;
+    int playlistPosition;
+    QPersistentModelIndex playlistIndex;
+    QJsonArray tracksJson;
+    int trackPosition;
+
+    bool loading;
+    int rowsLoaded;
+    int rowsCount;
+};
+
+#endif // MODELLOADER_H
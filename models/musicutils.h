@@ -3,18 +3,94 @@
 
 #include <iostream>
 #include <vector>
+#include <utility>
+#include <string>
+#include <functional>
 
 using namespace std;
 
+/**
+ * Format of the text written by Playlist::JoinTracks. Each track field is written between itemPrefix
+ * and itemSuffix, items are separated by separator and the whole list is written between open and close.
+ * e.g. a Json array of strings is {",", "\"", "\"", "[", "]"}.
+ * The same format is used by JoinItems for other lists of items.
+*/
+struct JoinFormat
+{
+    string separator;
+    string itemPrefix;
+    string itemSuffix;
+    string open;
+    string close;
+};
+
+inline size_t JoinedLength(const string &text){ return text.size();}
+
+template <class Output>
+void AppendJoined(Output &out, const string &text){ out.append(text.data(), text.size());}
+
+/**
+Function to compute the size of the text written by JoinItems with the same arguments.
+@param items list of items joined.
+@param field member or function giving the text of an item.
+@param format separators of the text.
+@param first position of the first item joined.
+@param last position after the last item joined.
+@return size of the text in bytes.
+*/
+template <class List, class Field>
+size_t JoinedSize(const List &items, Field field, const JoinFormat &format, size_t first, size_t last)
+{
+    if(first >= last)
+        return format.open.size() + format.close.size();
+
+    size_t size = format.open.size() + format.close.size()
+            + (last - first) * (format.itemPrefix.size() + format.itemSuffix.size())
+            + (last - first - 1) * format.separator.size();
+    for(size_t i = first; i < last; i++)
+        size += JoinedLength(std::invoke(field, items[i]));
+
+    return size;
+}
+
+/**
+Function to append a field of a range of items to a text, after growing the output once to the exact size
+of the text (see Playlist::JoinTracks). Texts other than string are written by the JoinedLength and
+AppendJoined overloads of their type.
+@param out text where the items are appended, any type with size, reserve and append(data, size).
+@param items list of items joined.
+@param field member or function giving the text of an item.
+@param format separators of the text.
+@param first position of the first item joined.
+@param last position after the last item joined.
+*/
+template <class Output, class List, class Field>
+void JoinItems(Output &out, const List &items, Field field, const JoinFormat &format, size_t first, size_t last)
+{
+    out.reserve(out.size() + JoinedSize(items, field, format, first, last));
+    out.append(format.open.data(), format.open.size());
+    for(size_t i = first; i < last; i++)
+    {
+        if(i != first)
+            out.append(format.separator.data(), format.separator.size());
+
+        out.append(format.itemPrefix.data(), format.itemPrefix.size());
+        AppendJoined(out, std::invoke(field, items[i]));
+        out.append(format.itemSuffix.data(), format.itemSuffix.size());
+    }
+    out.append(format.close.data(), format.close.size());
+}
+
 /**
  * Implementation of basic class to handle tracks data.
  * This class doens't have communication with User Interface.
+ * Setters take values that are moved into the object, getters return references to the stored data.
 */
 class Track{
 
 public:
-    void SetName(string text){ name = text;}
-    string GetName(){return name;}
+    void SetName(string text){ name = std::move(text);}
+    const string &GetName() const {return name;}
 protected:
     string name;
 
@@ -24,19 +100,74 @@ protected:
  * Implementation of basic class to handle Playlists data. It is based in
  * tree structure where playlists have tracks children.
  * This class doens't have communication with User Interface.
+ * Tracks can be moved into the playlist (AddTrack) or constructed in place (EmplaceTrack), and the
+ * storage for a known number of tracks can be reserved before they are added (Reserve).
+ * A field of the tracks can be joined in a text (JoinTracks) with a single allocation, the exact size
+ * of the text is computed before writing it (JoinedSize).
 */
 template <class T>
 class Playlist{
 public:
-    void SetName(string text){ name = text;}
-    string GetName(){return name;}
-    void AddTrack(T track){ tracksArray.push_back(track);}
+    void SetName(string text){ name = std::move(text);}
+    const string &GetName() const {return name;}
+    void AddTrack(T track){ tracksArray.push_back(std::move(track));}
     void RemoveLastTrack(){ tracksArray.pop_back();}
 
+    template <class... Args>
+    T &EmplaceTrack(Args&&... args)
+    {
+        tracksArray.emplace_back(std::forward<Args>(args)...);
+        return tracksArray.back();
+    }
+
+    void Reserve(size_t tracksCount){ tracksArray.reserve(tracksCount);}
+    size_t TracksCount() const {return tracksArray.size();}
+    const vector<T> &GetTracks() const {return tracksArray;}
+
+    /**
+    Method to compute the size of the text written by JoinTracks with the same arguments.
+    @param field getter of the track field joined (e.g. &SpotifyTrack::GetURI).
+    @param format separators of the text.
+    @param first position of the first track joined.
+    @param count maximum number of tracks joined, all tracks from first by default.
+    @return size of the text in bytes.
+    */
+    size_t JoinedSize(const string &(T::*field)() const, const JoinFormat &format,
+                      size_t first = 0, size_t count = string::npos) const
+    {
+        return ::JoinedSize(tracksArray, field, format, first, JoinEnd(first, count));
+    }
+
+    /**
+    Method to append a field of the tracks to a text. The output grows once to the exact size of the
+    text before it is written, so the tracks can be written straight into a request body.
+    @param out text where the tracks are appended, any type with size, reserve and append(data, size)
+    (e.g. string or QByteArray).
+    @param field getter of the track field joined (e.g. &SpotifyTrack::GetURI).
+    @param format separators of the text.
+    @param first position of the first track joined.
+    @param count maximum number of tracks joined, all tracks from first by default. Long playlists can be
+    written in batches of count tracks.
+    */
+    template <class Output>
+    void JoinTracks(Output &out, const string &(T::*field)() const, const JoinFormat &format,
+                    size_t first = 0, size_t count = string::npos) const
+    {
+        JoinItems(out, tracksArray, field, format, first, JoinEnd(first, count));
+    }
+
 protected:
     string name;
     vector<T> tracksArray;
 
+private:
+    size_t JoinEnd(size_t first, size_t count) const
+    {
+        if(first >= tracksArray.size())
+            return first;
+        return count < tracksArray.size() - first ? first + count : tracksArray.size();
+    }
+
 };
 
 #endif // MUSICUTILS_H
@@ -0,0 +1,287 @@
+#ifndef RANKSEQUENCE_H
+#define RANKSEQUENCE_H
+
+#include <QtGlobal>
+
+template <class T> class RankSequence;
+
+/**
+ * Links of an element in a RankSequence. Elements stored in a sequence inherit this class, so the sequence
+ * doesn't allocate nodes and the position of an element can be computed from the element itself.
+ */
+template <class T>
+class RankSequenceNode
+{
+protected:
+    RankSequenceNode() : left(nullptr), right(nullptr), up(nullptr), size(1), priority(0) {}
+
+private:
+    template <class> friend class RankSequence;
+
+    RankSequenceNode *left;
+    RankSequenceNode *right;
+    RankSequenceNode *up;
+    int size;
+    quint32 priority;
+};
+
+/**
+ * Implementation of RankSequence class, an ordered sequence of elements stored in an implicit treap
+ * (a randomized balanced binary tree ordered by position, where each node keeps the size of its subtree).
+ *
+ * Access by position (at), position of an element (rank), insertion, removal and move of a range of elements
+ * take O(log n) expected time, instead of the O(n) element shifts of a vector. Iteration visits the elements
+ * in order in O(n).
+ * The sequence doesn't own the elements: removed elements are returned to the caller and clear() passes
+ * each element to a dispose function. An element can only be stored in one sequence at a time.
+ */
+template <class T>
+class RankSequence
+{
+public:
+    typedef RankSequenceNode<T> Node;
+
+    class const_iterator
+    {
+    public:
+        explicit const_iterator(const Node *node = nullptr) : node(node) {}
+
+        T *operator*() const { return static_cast<T*>(const_cast<Node*>(node)); }
+        bool operator==(const const_iterator &other) const { return node == other.node; }
+        bool operator!=(const const_iterator &other) const { return node != other.node; }
+
+        const_iterator &operator++()
+        {
+            if (node->right) {
+                node = leftmost(node->right);
+                return *this;
+            }
+
+            const Node *child = node;
+            node = node->up;
+            while (node && child == node->right) {
+                child = node;
+                node = node->up;
+            }
+            return *this;
+        }
+
+    private:
+        const Node *node;
+    };
+
+    RankSequence() : root(nullptr), seed(0x9e3779b9u) {}
+
+    int size() const { return sizeOf(root); }
+    bool isEmpty() const { return root == nullptr; }
+
+    const_iterator begin() const { return const_iterator(root ? leftmost(root) : nullptr); }
+    const_iterator end() const { return const_iterator(); }
+
+    /**
+    Method to get the element at a given position.
+    @param position position of the element in the sequence.
+    @return the element, or nullptr if position is out of range.
+    */
+    T *at(int position) const
+    {
+        if (position < 0 || position >= size())
+            return nullptr;
+
+        Node *node = root;
+        while (true) {
+            const int leftSize = sizeOf(node->left);
+            if (position < leftSize) {
+                node = node->left;
+            } else if (position == leftSize) {
+                return static_cast<T*>(node);
+            } else {
+                position -= leftSize + 1;
+                node = node->right;
+            }
+        }
+    }
+
+    /**
+    Method to get the position of an element in the sequence that stores it, walking up from the element.
+    @param item element stored in a sequence.
+    @return position of the element.
+    */
+    static int rank(const T *item)
+    {
+        const Node *node = item;
+        int position = sizeOf(node->left);
+
+        while (node->up) {
+            if (node == node->up->right)
+                position += sizeOf(node->up->left) + 1;
+            node = node->up;
+        }
+        return position;
+    }
+
+    /**
+    Method to insert an element before the element at a given position.
+    @param position position of the element inserted, size() to append it.
+    @param item element not stored in any sequence.
+    */
+    void insert(int position, T *item)
+    {
+        Node *node = item;
+        node->left = node->right = node->up = nullptr;
+        node->size = 1;
+        node->priority = nextPriority();
+
+        Node *before, *after;
+        split(root, position, before, after);
+        root = merge(merge(before, node), after);
+    }
+
+    /**
+    Method to remove the element at a given position.
+    @param position position of the element, in range.
+    @return the element removed.
+    */
+    T *takeAt(int position)
+    {
+        Node *before, *rest, *node, *after;
+        split(root, position, before, rest);
+        split(rest, 1, node, after);
+        root = merge(before, after);
+
+        return static_cast<T*>(node);
+    }
+
+    /**
+    Method to move a range of elements to other position of the sequence, keeping their order.
+    @param position position of the first element moved.
+    @param count number of elements moved, the range must be in the sequence.
+    @param destination position, before the move, of the element the range is moved before (size() to
+    move it to the end).
+    */
+    void move(int position, int count, int destination)
+    {
+        if (count <= 0 || (destination >= position && destination <= position + count))
+            return;
+
+        Node *before, *rest, *moved, *after;
+        split(root, position, before, rest);
+        split(rest, count, moved, after);
+        root = merge(before, after);
+
+        split(root, destination > position ? destination - count : destination, before, after);
+        root = merge(merge(before, moved), after);
+    }
+
+    /**
+    Method to remove all elements. Each element is passed to the dispose function once its links are no
+    longer read, so the function can destroy it.
+    @param dispose function called with each element removed.
+    */
+    template <class Function>
+    void clear(Function dispose)
+    {
+        disposeAll(root, dispose);
+        root = nullptr;
+    }
+
+private:
+    RankSequence(const RankSequence&) = delete;
+    RankSequence &operator=(const RankSequence&) = delete;
+
+    static int sizeOf(const Node *node)
+    {
+        return node ? node->size : 0;
+    }
+
+    static const Node *leftmost(const Node *node)
+    {
+        while (node->left)
+            node = node->left;
+        return node;
+    }
+
+    static void update(Node *node)
+    {
+        node->size = 1 + sizeOf(node->left) + sizeOf(node->right);
+        if (node->left)
+            node->left->up = node;
+        if (node->right)
+            node->right->up = node;
+    }
+
+    /**
+    Method to split a tree in the trees of its first count elements and of the remaining elements.
+    The roots returned don't have parent, the caller links them again.
+    */
+    static void split(Node *node, int count, Node *&left, Node *&right)
+    {
+        if (!node) {
+            left = right = nullptr;
+            return;
+        }
+
+        if (sizeOf(node->left) < count) {
+            split(node->right, count - sizeOf(node->left) - 1, node->right, right);
+            left = node;
+        } else {
+            split(node->left, count, left, node->left);
+            right = node;
+        }
+        update(node);
+
+        if (left)
+            left->up = nullptr;
+        if (right)
+            right->up = nullptr;
+    }
+
+    /**
+    Method to concatenate two trees, keeping the node with highest priority on top.
+    */
+    static Node *merge(Node *left, Node *right)
+    {
+        if (!left)
+            return right;
+        if (!right)
+            return left;
+
+        Node *top;
+        if (left->priority > right->priority) {
+            left->right = merge(left->right, right);
+            top = left;
+        } else {
+            right->left = merge(left, right->left);
+            top = right;
+        }
+        update(top);
+        top->up = nullptr;
+
+        return top;
+    }
+
+    template <class Function>
+    static void disposeAll(Node *node, Function &dispose)
+    {
+        if (!node)
+            return;
+
+        disposeAll(node->left, dispose);
+        disposeAll(node->right, dispose);
+        dispose(static_cast<T*>(node));
+    }
+
+    //Xorshift generator of the nodes priorities
+    quint32 nextPriority()
+    {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        return seed;
+    }
+
+    Node *root;
+    quint32 seed;
+};
+
+#endif // RANKSEQUENCE_H
@@ -0,0 +1,175 @@
+#include "similarityindex.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+SimilarityIndex::SimilarityIndex(const AudioFeatureStore &featureStore, const TrackRegistry *trackRegistry)
+    : store(featureStore),
+      registry(trackRegistry)
+{}
+
+/**
+Method to get the number of tracks indexed, the tracks with audio features.
+*/
+int SimilarityIndex::count() const
+{
+    return store.count();
+}
+
+/**
+Method to check if a track can be returned by the queries.
+@param row row of the track in the audio features store.
+@return true if the index has no registry or the track is in a playlist.
+*/
+bool SimilarityIndex::isCandidate(int row) const
+{
+    if(!registry)
+        return row >= 0 && row < store.count();
+
+    update();
+    const TrackEntry *track = rowTracks.value(row, nullptr);
+    return track && !track->items.isEmpty();
+}
+
+/**
+Method to find the k tracks nearest to a query vector.
+@param query normalized value of each feature (see AudioFeatureStore::normalizedRow).
+@param k maximum number of tracks returned.
+@param excludedRows rows never returned, e.g. the tracks of the query.
+@return the tracks found, nearest first.
+*/
+QVector<SimilarTrack> SimilarityIndex::nearest(const QVector<float> &query, int k, const QSet<int> &excludedRows) const
+{
+    QVector<SimilarTrack> found;
+    if(k <= 0 || store.count() == 0)
+        return found;
+
+    update();
+    store.squaredDistances(query, distances);
+
+    //Max-heap of the k nearest tracks seen, its top is the farthest of them
+    std::vector<std::pair<float, int>> heap;
+    heap.reserve(size_t(k) + 1);
+
+    const int rows = store.count();
+    for(int row = 0; row < rows; row++)
+    {
+        const float distance = distances[row];
+        if(int(heap.size()) == k && !(distance < heap.front().first))
+            continue;
+
+        if(registry && (!rowTracks[row] || rowTracks[row]->items.isEmpty()))
+            continue;
+
+        if(excludedRows.contains(row))
+            continue;
+
+        heap.emplace_back(distance, row);
+        std::push_heap(heap.begin(), heap.end());
+        if(int(heap.size()) > k)
+        {
+            std::pop_heap(heap.begin(), heap.end());
+            heap.pop_back();
+        }
+    }
+
+    std::sort_heap(heap.begin(), heap.end());
+
+    found.reserve(int(heap.size()));
+    for(const auto &track : heap)
+        found.append({store.trackId(track.second), track.second, track.first});
+
+    return found;
+}
+
+/**
+Method to find the k tracks most similar to a track.
+@param trackId spotify id of the track.
+@return the tracks found, nearest first, empty if the track has no audio features.
+*/
+QVector<SimilarTrack> SimilarityIndex::nearestToTrack(const QString &trackId, int k) const
+{
+    const int row = store.row(trackId);
+    if(row < 0)
+        return QVector<SimilarTrack>();
+
+    return nearest(store.normalizedRow(row), k, QSet<int>({row}));
+}
+
+/**
+Method to find the k tracks most similar to a group of tracks (e.g. a playlist), nearest to the centroid of
+their normalized features. The tracks of the group are not returned.
+@param trackIds spotify ids of the tracks, tracks without audio features are skipped.
+@return the tracks found, nearest first, empty if no track has audio features.
+*/
+QVector<SimilarTrack> SimilarityIndex::nearestToTracks(const QStringList &trackIds, int k) const
+{
+    QSet<int> rows;
+    for(const QString &id : trackIds)
+    {
+        const int row = store.row(id);
+        if(row >= 0)
+            rows.insert(row);
+    }
+
+    if(rows.isEmpty())
+        return QVector<SimilarTrack>();
+
+    QVector<float> centroid(AudioFeatureStore::FeaturesCount, 0.0f);
+    for(int feature = 0; feature < AudioFeatureStore::FeaturesCount; feature++)
+    {
+        const float *column = store.normalizedColumn(AudioFeatureStore::Feature(feature));
+
+        double sum = 0.0;
+        for(const int row : rows)
+            sum += column[row];
+        centroid[feature] = float(sum / rows.size());
+    }
+
+    return nearest(centroid, k, rows);
+}
+
+/**
+Method to forget the track entries resolved, when entries are deleted from the registry (see
+TrackRegistry::release). All rows are resolved again in the next query.
+*/
+void SimilarityIndex::tracksReleased()
+{
+    rowTracks.clear();
+    unresolvedRows.clear();
+}
+
+/**
+Method to resolve the track entries of the rows added to the store since the last query, and of the rows
+whose track was not interned yet.
+*/
+void SimilarityIndex::update() const
+{
+    if(!registry)
+        return;
+
+    //The store was cleared, all rows are resolved again
+    if(rowTracks.size() > store.count())
+    {
+        rowTracks.clear();
+        unresolvedRows.clear();
+    }
+
+    QVector<int> stillUnresolved;
+    for(const int row : qAsConst(unresolvedRows))
+    {
+        rowTracks[row] = registry->track(store.trackId(row));
+        if(!rowTracks[row])
+            stillUnresolved.append(row);
+    }
+    unresolvedRows.swap(stillUnresolved);
+
+    for(int row = rowTracks.size(); row < store.count(); row++)
+    {
+        const TrackEntry *track = registry->track(store.trackId(row));
+        rowTracks.append(track);
+        if(!track)
+            unresolvedRows.append(row);
+    }
+}
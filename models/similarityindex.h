@@ -0,0 +1,63 @@
+#ifndef SIMILARITYINDEX_H
+#define SIMILARITYINDEX_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QSet>
+#include "audiofeaturestore.h"
+#include "trackregistry.h"
+
+/**
+ * Track found by a SimilarityIndex query: its row in the audio features store and the squared distance of its
+ * normalized features to the query.
+ */
+struct SimilarTrack
+{
+    QString id;
+    int row;
+    float distance;
+};
+
+/**
+ * Implementation of SimilarityIndex class to find the tracks most similar to a track or to a playlist
+ * ("more like this") from their audio features, without requests to the server.
+ *
+ * Each track is a vector of its normalized features in the AudioFeatureStore, and the k nearest tracks to a
+ * query vector (the features of a track or the centroid of the tracks of a playlist) are found by euclidean
+ * distance: the distances of all tracks are computed by the vectorized kernels over the feature columns and
+ * the k smallest are kept in a bounded heap, in O(n log k) time without sorting all tracks.
+ *
+ * With a TrackRegistry, only the tracks currently in the playlists are candidates. Each row of the store is
+ * resolved once to its track entry and the membership is read from the items of the entry at query time, so
+ * changes of the playlists don't rebuild the index and features received later only resolve the new rows.
+ * Without a registry every track of the store is a candidate.
+ */
+class SimilarityIndex
+{
+public:
+    explicit SimilarityIndex(const AudioFeatureStore &featureStore, const TrackRegistry *trackRegistry = nullptr);
+
+    int count() const;
+    bool isCandidate(int row) const;
+
+    QVector<SimilarTrack> nearest(const QVector<float> &query, int k, const QSet<int> &excludedRows = QSet<int>()) const;
+    QVector<SimilarTrack> nearestToTrack(const QString &trackId, int k) const;
+    QVector<SimilarTrack> nearestToTracks(const QStringList &trackIds, int k) const;
+    void tracksReleased();
+
+private:
+    void update() const;
+
+    const AudioFeatureStore &store;
+    const TrackRegistry *registry;
+
+    //Track entry of each row of the store, resolved as rows are added (nullptr if the track is not interned)
+    mutable QVector<const TrackEntry*> rowTracks;
+    mutable QVector<int> unresolvedRows;
+
+    //Distances of the last query, kept to avoid an allocation for each query
+    mutable QVector<float> distances;
+};
+
+#endif // SIMILARITYINDEX_H
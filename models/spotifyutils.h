@@ -13,12 +13,13 @@ class SpotifyTrack: public Track
 {
 
 public:
-    SpotifyTrack(){name=""; id=""; uri="";}
-    SpotifyTrack(string track_name, string track_id, string track_uri){name = track_name; id = track_id; uri=track_uri;}
-    void SetId(string id_in){id = id_in;}
-    string GetId(){return id;}
-    void SetURI(string uri_in){uri = uri_in;}
-    string GetURI(){return uri;}
+    SpotifyTrack(){}
+    SpotifyTrack(string track_name, string track_id, string track_uri)
+        : id(std::move(track_id)), uri(std::move(track_uri)) {name = std::move(track_name);}
+    void SetId(string id_in){id = std::move(id_in);}
+    const string &GetId() const {return id;}
+    void SetURI(string uri_in){uri = std::move(uri_in);}
+    const string &GetURI() const {return uri;}
 
 private:
     string id;
@@ -36,37 +37,24 @@ class SpotifyPlaylist: public Playlist<SpotifyTrack>
 {
 
 public:
-    void SetId(string id_in){id = id_in;}
-    string GetId(){return id;}
-    void SetURI(string uri_in){uri = uri_in;}
-    string GetURI(){return uri;}
-    void SetHref(string href_in){href = href_in;}
-    string GetHref(){return href;}
+    void SetId(string id_in){id = std::move(id_in);}
+    const string &GetId() const {return id;}
+    void SetURI(string uri_in){uri = std::move(uri_in);}
+    const string &GetURI() const {return uri;}
+    void SetHref(string href_in){href = std::move(href_in);}
+    const string &GetHref() const {return href;}
 
-    string GetTracksListStr(string separator)
+    string GetTracksListStr(const string &separator) const
     {
-        string result = "";
-        if(tracksArray.size()>0)
-        {
-            for (vector<SpotifyTrack>::iterator it = tracksArray.begin() ; it != tracksArray.end(); ++it)
-            {
-                result += it->GetName() + separator;
-            }
-        }
+        string result;
+        JoinTracks(result, &SpotifyTrack::GetName, {"", "", separator, "", ""});
         return result;
     }
 
-    string GetTracksUrisListStr(string separator)
+    string GetTracksUrisListStr(const string &separator) const
     {
-        string result = "";
-        if(tracksArray.size()>0)
-        {
-            result = tracksArray.begin()->GetURI();
-            for (vector<SpotifyTrack>::iterator it = tracksArray.begin()+1 ; it != tracksArray.end(); ++it)
-            {
-                result += separator + it->GetURI() ;
-            }
-        }
+        string result;
+        JoinTracks(result, &SpotifyTrack::GetURI, {separator, "", "", "", ""});
         return result;
     }
 
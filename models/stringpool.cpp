@@ -0,0 +1,99 @@
+#include "stringpool.h"
+
+StringPool::StringPool()
+    : lookups(0),
+      hits(0),
+      bytesSaved(0)
+{}
+
+/**
+Method to get the pool shared by all models and api replies of the application.
+*/
+StringPool &StringPool::global()
+{
+    static StringPool pool;
+    return pool;
+}
+
+/**
+Method to get the shared instance of a string.
+@param value string to intern.
+@return an instance equal to value that shares its buffer with all strings interned with the same value.
+*/
+QString StringPool::intern(const QString &value)
+{
+    if(value.isEmpty())
+        return value;
+
+    const uint hash = qHash(value);
+    Shard &shard = shards[hash % shardsCount];
+
+    lookups.fetch_add(1, std::memory_order_relaxed);
+
+    QMutexLocker locker(&shard.mutex);
+
+    auto it = shard.strings.constFind(value);
+    if(it != shard.strings.constEnd())
+    {
+        hits.fetch_add(1, std::memory_order_relaxed);
+        bytesSaved.fetch_add(quint64(value.size()) * sizeof(QChar), std::memory_order_relaxed);
+        return *it;
+    }
+
+    shard.strings.insert(value);
+    return value;
+}
+
+/**
+Method to release the strings that are only referenced by the pool, e.g. after a model is destroyed.
+*/
+void StringPool::prune()
+{
+    for(Shard &shard : shards)
+    {
+        QMutexLocker locker(&shard.mutex);
+
+        for(auto it = shard.strings.begin(); it != shard.strings.end();)
+        {
+            if(it->isDetached())
+                it = shard.strings.erase(it);
+            else
+                ++it;
+        }
+    }
+}
+
+void StringPool::clear()
+{
+    for(Shard &shard : shards)
+    {
+        QMutexLocker locker(&shard.mutex);
+        shard.strings.clear();
+    }
+}
+
+/**
+Method to get the counters of the pool.
+@return Json object with the strings and bytes stored in the pool, the lookups, the hits (strings shared
+instead of stored again) and the bytes de-duplicated by the hits.
+*/
+QJsonObject StringPool::statistics() const
+{
+    quint64 strings = 0;
+    quint64 bytes = 0;
+
+    for(const Shard &shard : shards)
+    {
+        QMutexLocker locker(&shard.mutex);
+
+        strings += quint64(shard.strings.size());
+        for(const QString &value : shard.strings)
+            bytes += quint64(value.size()) * sizeof(QChar);
+    }
+
+    return QJsonObject({{"strings", double(strings)},
+                        {"bytes_stored", double(bytes)},
+                        {"lookups", double(lookups.load())},
+                        {"hits", double(hits.load())},
+                        {"bytes_saved", double(bytesSaved.load())}});
+}
@@ -0,0 +1,50 @@
+#ifndef STRINGPOOL_H
+#define STRINGPOOL_H
+
+#include <QString>
+#include <QSet>
+#include <QMutex>
+#include <QJsonObject>
+#include <atomic>
+
+/**
+ * Implementation of StringPool class to share equal QString values (names, ids, hrefs, uris) read from Json data.
+ *
+ * intern() returns the instance already in the pool for an equal string, so all copies share one implicitly
+ * shared buffer and the string read from Json is released. The pool is thread-safe: strings are distributed in
+ * shards, each one locked by its own mutex. Strings only referenced by the pool are released by prune().
+ * Counters of lookups, hits and bytes de-duplicated are reported by statistics().
+ */
+class StringPool
+{
+public:
+    StringPool();
+
+    static StringPool &global();
+
+    QString intern(const QString &value);
+    void prune();
+    void clear();
+
+    QJsonObject statistics() const;
+
+private:
+    StringPool(const StringPool&) = delete;
+    StringPool &operator=(const StringPool&) = delete;
+
+    static const int shardsCount = 16;
+
+    struct Shard
+    {
+        mutable QMutex mutex;
+        QSet<QString> strings;
+    };
+
+    Shard shards[shardsCount];
+
+    std::atomic<quint64> lookups;
+    std::atomic<quint64> hits;
+    std::atomic<quint64> bytesSaved;
+};
+
+#endif // STRINGPOOL_H
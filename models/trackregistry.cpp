@@ -0,0 +1,394 @@
+#include "trackregistry.h"
+#include "treeitem.h"
+#include "stringpool.h"
+
+#include <QJsonArray>
+
+/**
+Method to get a data field of the track by its head label (name, id, href or uri).
+@return the field value, empty if the label is not a field of tracks.
+*/
+QString TrackEntry::field(const QString &head) const
+{
+    if(head == "name")
+        return name;
+    if(head == "id")
+        return id;
+    if(head == "href")
+        return href;
+    if(head == "uri")
+        return uri;
+    return QString();
+}
+
+/**
+Method to check if the track has its data, tracks imported with only an id or uri don't have name.
+*/
+bool TrackEntry::isHydrated() const
+{
+    return !name.isEmpty();
+}
+
+bool TrackEntry::setField(const QString &head, const QString &value)
+{
+    if(head == "name")
+        name = value;
+    else if(head == "id")
+        id = value;
+    else if(head == "href")
+        href = value;
+    else if(head == "uri")
+        uri = value;
+    else
+        return false;
+    return true;
+}
+
+/**
+Method to replace the artists of the track, keeping the tracks of each artist up to date.
+@param trackArtists entries of the artists, owned by the ArtistRegistry of the model.
+*/
+void TrackEntry::setArtists(const QVector<ArtistEntry*> &trackArtists)
+{
+    for(ArtistEntry *artist : qAsConst(artists))
+        artist->tracks.remove(this);
+
+    artists = trackArtists;
+
+    for(ArtistEntry *artist : qAsConst(artists))
+        artist->tracks.insert(this);
+}
+
+TrackRegistry::TrackRegistry(ArtistRegistry &artistRegistry)
+    : artists(artistRegistry)
+{}
+
+TrackRegistry::~TrackRegistry()
+{
+    clear();
+}
+
+/**
+Method to get the key of a track in the registry.
+@return the id, or the uri for tracks without id, empty for tracks without id nor uri (not shared).
+*/
+QString TrackRegistry::key(const QString &id, const QString &uri)
+{
+    if(!id.isEmpty())
+        return id;
+    return uri.isEmpty() ? QString() : "uri:" + uri;
+}
+
+/**
+Method to fill the fields of the track that has no data yet (e.g. imported with only an id or uri) with the
+data of other occurrence of the track.
+@param trackJson Json object of the track.
+@return false if the track already has data or the Json object has no data.
+*/
+bool TrackRegistry::fill(TrackEntry *track, const QJsonObject &trackJson)
+{
+    const QString name = trackJson.value("name").toString();
+    if(track->isHydrated() || name.isEmpty())
+        return false;
+
+    StringPool &pool = StringPool::global();
+    track->name = pool.intern(name);
+    if(track->href.isEmpty())
+        track->href = pool.intern(trackJson.value("href").toString());
+
+    const QJsonArray artistsArray = trackJson.value("artists").toArray();
+    if(track->artists.isEmpty() && !artistsArray.isEmpty())
+    {
+        QVector<ArtistEntry*> trackArtists;
+        trackArtists.reserve(artistsArray.size());
+        for(const auto artistValue : artistsArray)
+            trackArtists.append(artists.intern(artistValue.toObject()));
+        track->setArtists(trackArtists);
+    }
+
+    return true;
+}
+
+/**
+Method to get the shared entry of a track, creating it (and interning its artists) if the track is not in
+the registry yet. The data of an existing entry is kept, an entry without data is filled with the data of
+the Json object. Tracks without id nor uri (e.g. local files known only by name) get an entry of their own.
+@param trackJson Json object of the track (name, id, href, uri and optional artists array).
+@param filled set to true if an existing entry without data was filled, its other items show the data.
+@return the track entry owned by the registry.
+*/
+TrackEntry *TrackRegistry::intern(const QJsonObject &trackJson, bool *filled)
+{
+    const QString name = trackJson.value("name").toString();
+    const QString id = trackJson.value("id").toString();
+    const QString uri = trackJson.value("uri").toString();
+    const QString trackKey = key(id, uri);
+
+    if(filled)
+        *filled = false;
+
+    auto it = trackKey.isEmpty() ? tracks.constEnd() : tracks.constFind(trackKey);
+    if(it != tracks.constEnd())
+    {
+        const bool entryFilled = fill(it.value(), trackJson);
+        if(filled)
+            *filled = entryFilled;
+        return it.value();
+    }
+
+    StringPool &pool = StringPool::global();
+
+    TrackEntry *track = new TrackEntry;
+    track->name = pool.intern(name);
+    track->id = pool.intern(id);
+    track->href = pool.intern(trackJson.value("href").toString());
+    track->uri = pool.intern(uri);
+
+    const QJsonArray artistsArray = trackJson.value("artists").toArray();
+    QVector<ArtistEntry*> trackArtists;
+    trackArtists.reserve(artistsArray.size());
+    for(const auto artistValue : artistsArray)
+        trackArtists.append(artists.intern(artistValue.toObject()));
+    track->setArtists(trackArtists);
+
+    if(trackKey.isEmpty())
+        unkeyedTracks.insert(track);
+    else
+        tracks.insert(trackKey, track);
+    return track;
+}
+
+/**
+Method to find a track by id.
+@param id spotify id of the track.
+@return the track entry, nullptr if the track is not in the registry.
+*/
+TrackEntry *TrackRegistry::track(const QString &id) const
+{
+    return tracks.value(id, nullptr);
+}
+
+/**
+Method to get the ids of the tracks with id.
+*/
+QStringList TrackRegistry::ids() const
+{
+    QStringList trackIds;
+    trackIds.reserve(tracks.size());
+
+    for(const TrackEntry *track : tracks)
+        if(!track->id.isEmpty())
+            trackIds.append(track->id);
+
+    return trackIds;
+}
+
+/**
+Method to get the ids of the tracks without data, including the ids in the uris of tracks without id.
+@return ids of the tracks to hydrate, once each.
+*/
+QStringList TrackRegistry::missingIds() const
+{
+    QStringList ids;
+    QSet<QString> added;
+
+    for(const TrackEntry *track : tracks)
+    {
+        if(track->isHydrated())
+            continue;
+
+        const QString id = track->id.isEmpty() ? idFromUri(track->uri) : track->id;
+        if(!id.isEmpty() && !added.contains(id))
+        {
+            added.insert(id);
+            ids.append(id);
+        }
+    }
+
+    return ids;
+}
+
+/**
+Method to change a data field of a track, registering the track by its new key when the id or uri used as
+key changes.
+@param track track entry owned by the registry.
+@param head head label of the field (name, id, href or uri).
+@param value new value of the field.
+@return false if the label is not a field of tracks or the new key is the key of other track.
+*/
+bool TrackRegistry::setField(TrackEntry *track, const QString &head, const QString &value)
+{
+    const QString oldKey = key(track->id, track->uri);
+    const QString oldValue = track->field(head);
+
+    if(!track->setField(head, StringPool::global().intern(value)))
+        return false;
+
+    const QString newKey = key(track->id, track->uri);
+    if(newKey == oldKey)
+        return true;
+
+    if(!newKey.isEmpty() && tracks.contains(newKey))
+    {
+        track->setField(head, oldValue);
+        return false;
+    }
+
+    if(oldKey.isEmpty())
+        unkeyedTracks.remove(track);
+    else
+        tracks.remove(oldKey);
+
+    if(newKey.isEmpty())
+        unkeyedTracks.insert(track);
+    else
+        tracks.insert(newKey, track);
+    return true;
+}
+
+/**
+Method to fill the tracks without data with a track received from the server. A track imported with its uri
+is registered by id; if the track was also imported with its id, the items of the first one move to the
+second one, so each track has one entry.
+@param trackJson Json object of the track (name, id, href, uri and artists array).
+@return entries changed, empty if no track without data matches the track.
+*/
+QVector<TrackEntry*> TrackRegistry::hydrate(const QJsonObject &trackJson)
+{
+    QVector<TrackEntry*> changed;
+
+    const QString id = trackJson.value("id").toString();
+    if(id.isEmpty())
+        return changed;
+
+    const QString uri = trackJson.value("uri").toString();
+    const QString uriKey = key(QString(), uri);
+
+    TrackEntry *byId = tracks.value(id, nullptr);
+    TrackEntry *byUri = uri.isEmpty() ? nullptr : tracks.value(uriKey, nullptr);
+
+    //The entry imported by uri takes the id key when no entry has it yet
+    if(byUri && !byId)
+    {
+        tracks.remove(uriKey);
+        tracks.insert(id, byUri);
+    }
+
+    //Otherwise the entry imported by uri is merged in the entry imported by id
+    if(byUri && byId && byUri != byId)
+    {
+        const QSet<TreeItem*> items = byUri->items;
+        for(TreeItem *item : items)
+            item->setTrack(byId);
+
+        tracks.remove(uriKey);
+        byUri->setArtists(QVector<ArtistEntry*>());
+        delete byUri;
+        byUri = nullptr;
+
+        //The items moved show the data of the entry even if it was already filled
+        if(byId->isHydrated())
+            changed.append(byId);
+    }
+
+    StringPool &pool = StringPool::global();
+    const QJsonArray artistsArray = trackJson.value("artists").toArray();
+
+    for(TrackEntry *track : {byId, byUri})
+    {
+        if(!track || track->isHydrated() || changed.contains(track))
+            continue;
+
+        track->name = pool.intern(trackJson.value("name").toString());
+        track->id = pool.intern(id);
+        track->href = pool.intern(trackJson.value("href").toString());
+        if(!uri.isEmpty())
+            track->uri = pool.intern(uri);
+
+        QVector<ArtistEntry*> trackArtists;
+        trackArtists.reserve(artistsArray.size());
+        for(const auto artistValue : artistsArray)
+            trackArtists.append(artists.intern(artistValue.toObject()));
+        track->setArtists(trackArtists);
+
+        changed.append(track);
+    }
+
+    return changed;
+}
+
+/**
+Method to delete the entries no item refers to anymore, e.g. after their rows were removed, so removed
+tracks are not hydrated nor requested again (ids, missingIds).
+@param candidates entries whose items were removed, the entries still referred are kept.
+@return number of entries deleted.
+*/
+int TrackRegistry::release(const QSet<TrackEntry*> &candidates)
+{
+    int released = 0;
+
+    for(TrackEntry *track : candidates)
+    {
+        if(!track->items.isEmpty())
+            continue;
+
+        const QString trackKey = key(track->id, track->uri);
+        if(trackKey.isEmpty() ? !unkeyedTracks.remove(track) : tracks.value(trackKey, nullptr) != track)
+            continue;
+
+        tracks.remove(trackKey);
+        track->setArtists(QVector<ArtistEntry*>());
+        delete track;
+        released++;
+    }
+
+    return released;
+}
+
+int TrackRegistry::count() const
+{
+    return tracks.size() + unkeyedTracks.size();
+}
+
+/**
+Method to delete all entries. Must only be called when no TreeItem refers to them.
+*/
+void TrackRegistry::clear()
+{
+    for(TrackEntry *track : qAsConst(tracks))
+        track->setArtists(QVector<ArtistEntry*>());
+    for(TrackEntry *track : qAsConst(unkeyedTracks))
+        track->setArtists(QVector<ArtistEntry*>());
+
+    qDeleteAll(tracks);
+    tracks.clear();
+    qDeleteAll(unkeyedTracks);
+    unkeyedTracks.clear();
+}
+
+/**
+Method to get the id of a track from its uri.
+@param uri uri of the track (spotify:track:{id}).
+@return the id, empty if the uri is not the uri of a spotify track (e.g. a local file).
+*/
+QString TrackRegistry::idFromUri(const QString &uri)
+{
+    static const QString prefix = "spotify:track:";
+    return uri.startsWith(prefix) ? uri.mid(prefix.size()) : QString();
+}
+
+/**
+Method to get the Json object of a track with its artists in the format of the playlists files.
+*/
+QJsonObject TrackRegistry::toJson(const TrackEntry *track)
+{
+    QJsonArray artistsArray;
+    for(const ArtistEntry *artist : track->artists)
+        artistsArray.append(ArtistRegistry::toJson(artist));
+
+    return QJsonObject({{"name", track->name},
+                        {"id", track->id},
+                        {"href", track->href},
+                        {"uri", track->uri},
+                        {"artists", artistsArray}});
+}
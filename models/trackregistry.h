@@ -0,0 +1,77 @@
+#ifndef TRACKREGISTRY_H
+#define TRACKREGISTRY_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QSet>
+#include <QVector>
+#include <QJsonObject>
+#include "artistregistry.h"
+
+class TreeItem;
+
+/**
+ * Data of a track shared by all playlists of a TreeModel that contain the track.
+ * The set of items is the reverse index of the track: each TreeItem row referring to the track adds and
+ * removes itself, so the playlists containing the track are the parents of its items.
+ */
+struct TrackEntry
+{
+    QString name;
+    QString id;
+    QString href;
+    QString uri;
+
+    QVector<ArtistEntry*> artists;
+    QSet<TreeItem*> items;
+
+    QString field(const QString &head) const;
+    bool isHydrated() const;
+    bool setField(const QString &head, const QString &value);
+    void setArtists(const QVector<ArtistEntry*> &trackArtists);
+};
+
+/**
+ * Implementation of TrackRegistry class to store each track of a TreeModel only once.
+ *
+ * Tracks are interned by id (or by uri for tracks without id, such as local files) and playlists hold ordered
+ * references to the shared entries. Tracks without id nor uri are not shared. Tracks imported with only an id or uri are hydrated later
+ * with the data received from the server (missingIds, hydrate). The artists of the tracks are interned in the ArtistRegistry
+ * of the same model. The registry owns the entries and must outlive the TreeItem objects that refer to them.
+ * Entries are deleted when the last item referring to them is removed (release).
+ */
+class TrackRegistry
+{
+public:
+    TrackRegistry(ArtistRegistry &artistRegistry);
+    ~TrackRegistry();
+
+    TrackEntry *intern(const QJsonObject &trackJson, bool *filled = nullptr);
+    TrackEntry *track(const QString &id) const;
+    QStringList ids() const;
+    QStringList missingIds() const;
+    bool setField(TrackEntry *track, const QString &head, const QString &value);
+    QVector<TrackEntry*> hydrate(const QJsonObject &trackJson);
+    int release(const QSet<TrackEntry*> &candidates);
+    int count() const;
+    void clear();
+
+    static QJsonObject toJson(const TrackEntry *track);
+    static QString idFromUri(const QString &uri);
+
+private:
+    TrackRegistry(const TrackRegistry&) = delete;
+    TrackRegistry &operator=(const TrackRegistry&) = delete;
+
+    static QString key(const QString &id, const QString &uri);
+    bool fill(TrackEntry *track, const QJsonObject &trackJson);
+
+    ArtistRegistry &artists;
+    QHash<QString, TrackEntry*> tracks;
+
+    //Tracks without id nor uri, which can't be told apart by their data and are not shared
+    QSet<TrackEntry*> unkeyedTracks;
+};
+
+#endif // TRACKREGISTRY_H
@@ -1,15 +1,41 @@
 #include "treeitem.h"
+#include "treeitemarena.h"
 
 
 TreeItem::TreeItem(const QVector<QVariant> &data, const QVector<QString> &headData, TreeItem *parent)
     : itemData(data),
+      parentItem(parent),
       itemHeadData(headData),
-      parentItem(parent)
+      itemTrack(nullptr),
+      itemArena(nullptr)
 {}
 
 TreeItem::~TreeItem()
 {
-    qDeleteAll(childItems);
+    //Items released together by the arena don't release children and track references one by one
+    if (itemArena && itemArena->isReleasing())
+        return;
+
+    setTrack(nullptr);
+    childItems.clear([this](TreeItem *child){ deleteChild(child); });
+}
+
+/**
+Method to create a child item, in the arena of this item if it has one.
+*/
+TreeItem *TreeItem::newChild(const QVector<QVariant> &data, const QVector<QString> &headData)
+{
+    if (itemArena)
+        return itemArena->create(data, headData, this);
+    return new TreeItem(data, headData, this);
+}
+
+void TreeItem::deleteChild(TreeItem *child)
+{
+    if (itemArena)
+        itemArena->destroy(child);
+    else
+        delete child;
 }
 
 TreeItem *TreeItem::child(int number)
@@ -21,7 +47,7 @@ TreeItem *TreeItem::child(int number)
 
 int TreeItem::childCount() const
 {
-    return childItems.count();
+    return childItems.size();
 }
 
 /**
@@ -32,7 +58,7 @@ than the current item is the root of the tree.
 int TreeItem::childNumber() const
 {
     if (parentItem)
-        return parentItem->childItems.indexOf(const_cast<TreeItem*>(this));
+        return RankSequence<TreeItem>::rank(this);
     return 0;
 }
 
@@ -75,7 +101,7 @@ bool TreeItem::insertChildren(int position, int count, int columns)
     for (int row = 0; row < count; ++row) {
         QVector<QVariant> data(columns);
         QVector<QString> head_data(columns);
-        TreeItem *item = new TreeItem(data, head_data, this);
+        TreeItem *item = newChild(data, head_data);
         childItems.insert(position, item);
     }
 
@@ -106,19 +132,32 @@ bool TreeItem::insertColumns(int position, int columns)
     return true;
 }
 
-TreeItem *TreeItem::parent()
-{
-    return parentItem;
-}
-
 bool TreeItem::removeChildren(int position, int count)
 {
     if (position < 0 || position + count > childItems.size())
         return false;
 
     for (int row = 0; row < count; ++row)
-        delete childItems.takeAt(position);
+        deleteChild(childItems.takeAt(position));
+
+    return true;
+}
+
+/**
+Method to move TreeItem children to other position in the current level, keeping their order.
+@param position position of the first child moved.
+@param count number of children moved.
+@param destination row, before the move, of the child the moved children are placed before (childCount()
+to place them at the end).
+@return true if the children are moved or false if the rows are out of children range.
+*/
+bool TreeItem::moveChildren(int position, int count, int destination)
+{
+    if (position < 0 || count < 0 || position + count > childItems.size()
+            || destination < 0 || destination > childItems.size())
+        return false;
 
+    childItems.move(position, count, destination);
     return true;
 }
 
@@ -148,6 +187,50 @@ bool TreeItem::setData(int column, const QVariant &value)
     return true;
 }
 
+/**
+Method to insert a TreeItem child that refers to a shared track. The child doesn't allocate data columns,
+its data is read from the track entry.
+@param position position in the current tree where the child will be inserted.
+@param track track entry, owned by the TrackRegistry of the model.
+@return true if the child is inserted or false if position is out of children range.
+*/
+bool TreeItem::insertTrack(int position, TrackEntry *track)
+{
+    if (position < 0 || position > childItems.size())
+        return false;
+
+    TreeItem *item = newChild(QVector<QVariant>(), QVector<QString>());
+    item->setTrack(track);
+    childItems.insert(position, item);
+
+    return true;
+}
+
+TreeItem *TreeItem::parent()
+{
+    return parentItem;
+}
+
+TrackEntry *TreeItem::track() const
+{
+    return itemTrack;
+}
+
+/**
+Method to set the track the item refers to, keeping the reverse index of the track (its items) up to date.
+@param track track entry, nullptr to remove the reference.
+*/
+void TreeItem::setTrack(TrackEntry *track)
+{
+    if (itemTrack)
+        itemTrack->items.remove(this);
+
+    itemTrack = track;
+
+    if (itemTrack)
+        itemTrack->items.insert(this);
+}
+
 bool TreeItem::setHeadData(int column, const QString &value)
 {
     if (column < 0 || column >= itemHeadData.size())
@@ -3,16 +3,24 @@
 
 #include <QVariant>
 #include <QVector>
+#include "trackregistry.h"
+#include "ranksequence.h"
+
+class TreeItemArena;
 
 /**
  * Implementation of TreeItem class based on Qt example to handle data in Tree structure.
  *
- * This class is be used to store the spotify data and represent elements such as Playlists, Tracks and
- * in lower level Artists. Such elements are related in a parent - child relationship.
+ * This class is be used to store the spotify data and represent elements such as Playlists and Tracks.
+ * Such elements are related in a parent - child relationship.
  * Columns in this class represent data stored of a given TreeItem and rows represent children elements of
- * a TreeItem.
+ * a TreeItem. Track items don't store their data: they refer to the track entry shared through the
+ * TrackRegistry of the model by all playlists that contain the track.
+ * Items created by a TreeItemArena create their children in the same arena.
+ * Children are kept in a RankSequence, so the row of a child and inserting, removing or moving children
+ * in the middle of a large playlist take O(log n) time.
  */
-class TreeItem
+class TreeItem : public RankSequenceNode<TreeItem>
 {
 public:
     explicit TreeItem(const QVector<QVariant> &data, const QVector<QString> &headData, TreeItem *parent=nullptr);
@@ -32,14 +40,27 @@ public:
     bool insertChildren(int position, int count, int columns);
     bool insertColumns(int position, int columns);
     bool removeChildren(int position, int count);
+    bool moveChildren(int position, int count, int destination);
     bool removeColumns(int position, int columns);
     bool setData(int column, const QVariant &value);
 
+    //Methods to access the shared track of a track item
+    bool insertTrack(int position, TrackEntry *track);
+    TrackEntry *track() const;
+    void setTrack(TrackEntry *track);
+
 private:
-    QVector<TreeItem*> childItems;
+    friend class TreeItemArena;
+
+    TreeItem *newChild(const QVector<QVariant> &data, const QVector<QString> &headData);
+    void deleteChild(TreeItem *child);
+
+    RankSequence<TreeItem> childItems;
     QVector<QVariant> itemData;
     TreeItem *parentItem;
     QVector<QString> itemHeadData;
+    TrackEntry *itemTrack;
+    TreeItemArena *itemArena;
 };
 
 
@@ -0,0 +1,112 @@
+#include "treeitemarena.h"
+
+#include <new>
+
+/**
+@param itemsPerBlock number of items of each block allocated.
+*/
+TreeItemArena::TreeItemArena(int itemsPerBlock)
+    : blockSize(qMax(1, itemsPerBlock)),
+      usedInLastBlock(0),
+      freeSlots(nullptr),
+      liveItems(0),
+      releasing(false)
+{}
+
+TreeItemArena::~TreeItemArena()
+{
+    releaseAll();
+}
+
+TreeItemArena::Slot *TreeItemArena::allocateSlot()
+{
+    if(freeSlots)
+    {
+        Slot *slot = freeSlots;
+        freeSlots = slot->nextFree;
+        return slot;
+    }
+
+    if(blocks.isEmpty() || usedInLastBlock == blockSize)
+    {
+        Slot *block = static_cast<Slot*>(::operator new(sizeof(Slot) * size_t(blockSize)));
+        for(int i = 0; i < blockSize; i++)
+            block[i].used = false;
+
+        blocks.append(block);
+        usedInLastBlock = 0;
+    }
+
+    return &blocks.last()[usedInLastBlock++];
+}
+
+/**
+Method to construct an item in the arena. The item creates its children in the same arena.
+@param data columns data of the item.
+@param headData head labels of the columns.
+@param parent parent item, nullptr for the root item.
+@return the item, released by destroy() or releaseAll().
+*/
+TreeItem *TreeItemArena::create(const QVector<QVariant> &data, const QVector<QString> &headData, TreeItem *parent)
+{
+    Slot *slot = allocateSlot();
+
+    TreeItem *item = new (slot->storage) TreeItem(data, headData, parent);
+    item->itemArena = this;
+
+    slot->used = true;
+    liveItems++;
+    return item;
+}
+
+/**
+Method to destroy an item and its children, returning their slots to the free list.
+*/
+void TreeItemArena::destroy(TreeItem *item)
+{
+    if(!item)
+        return;
+
+    item->~TreeItem();
+
+    Slot *slot = reinterpret_cast<Slot*>(item);
+    slot->used = false;
+    slot->nextFree = freeSlots;
+    freeSlots = slot;
+    liveItems--;
+}
+
+/**
+Method to destroy all items of the arena and free its blocks.
+*/
+void TreeItemArena::releaseAll()
+{
+    releasing = true;
+
+    for(Slot *block : qAsConst(blocks))
+    {
+        const int count = block == blocks.last() ? usedInLastBlock : blockSize;
+        for(int i = 0; i < count; i++)
+        {
+            if(block[i].used)
+                reinterpret_cast<TreeItem*>(block[i].storage)->~TreeItem();
+        }
+        ::operator delete(block);
+    }
+
+    blocks.clear();
+    usedInLastBlock = 0;
+    freeSlots = nullptr;
+    liveItems = 0;
+    releasing = false;
+}
+
+bool TreeItemArena::isReleasing() const
+{
+    return releasing;
+}
+
+int TreeItemArena::itemsCount() const
+{
+    return liveItems;
+}
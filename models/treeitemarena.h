@@ -0,0 +1,56 @@
+#ifndef TREEITEMARENA_H
+#define TREEITEMARENA_H
+
+#include <QVector>
+#include <QVariant>
+#include <QString>
+#include "treeitem.h"
+
+/**
+ * Implementation of TreeItemArena class, a slab allocator of the TreeItem objects of a TreeModel.
+ *
+ * Items are constructed in blocks of contiguous slots, so the children of a playlist loaded together are
+ * contiguous in memory. Items removed one by one return their slot to a free list reused by the next item.
+ * releaseAll() destroys every item in block order, without visiting the tree and without freeing the items
+ * one by one: items destroyed by it don't delete their children or update the tracks registry, so it must
+ * only be called when the whole tree and its registries are discarded.
+ */
+class TreeItemArena
+{
+public:
+    explicit TreeItemArena(int itemsPerBlock = 1024);
+    ~TreeItemArena();
+
+    TreeItem *create(const QVector<QVariant> &data, const QVector<QString> &headData, TreeItem *parent);
+    void destroy(TreeItem *item);
+    void releaseAll();
+
+    bool isReleasing() const;
+    int itemsCount() const;
+
+private:
+    TreeItemArena(const TreeItemArena&) = delete;
+    TreeItemArena &operator=(const TreeItemArena&) = delete;
+
+    struct Slot
+    {
+        //Storage of the item while the slot is used, link of the free list otherwise
+        union
+        {
+            alignas(TreeItem) unsigned char storage[sizeof(TreeItem)];
+            Slot *nextFree;
+        };
+        bool used;
+    };
+
+    Slot *allocateSlot();
+
+    int blockSize;
+    QVector<Slot*> blocks;
+    int usedInLastBlock;
+    Slot *freeSlots;
+    int liveItems;
+    bool releasing;
+};
+
+#endif // TREEITEMARENA_H
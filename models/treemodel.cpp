@@ -1,10 +1,25 @@
 #include "treemodel.h"
 #include "treeitem.h"
-
-#include <QtWidgets>
+#include "stringpool.h"
+#include "utils/tracer.h"
+#include "utils/logger.h"
+
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QMimeData>
+#include <QDataStream>
+#include <QDebug>
+#include <algorithm>
+
+//Mime type of the tracks rows dragged in the views, encoded as the playlist row and the tracks rows
+static const char *tracksRowsMimeType = "application/x-spotifyapp-tracks-rows";
 
 TreeModel::TreeModel(const QStringList &headers, QObject *parent)
-    : QAbstractItemModel(parent)
+    : QAbstractItemModel(parent),
+      tracksRegistry(artistsRegistry),
+      similarityIndex(featuresStore, &tracksRegistry)
 {
     QVector<QVariant> rootData;
     QVector<QString> rootHeadData;
@@ -16,13 +31,19 @@ TreeModel::TreeModel(const QStringList &headers, QObject *parent)
 
     //Sets head labels and data(empty) for root item in the tree head labels are the
     //ones shown in QTreeView heads.
-    rootItem = new TreeItem(rootData,rootHeadData);
+    rootItem = itemsArena.create(rootData,rootHeadData,nullptr);
 }
 
 
 TreeModel::~TreeModel()
 {
-    delete rootItem;
+    //Items are released in one pass over the arena blocks instead of visiting the tree
+    itemsArena.releaseAll();
+    tracksRegistry.clear();
+    artistsRegistry.clear();
+
+    //Strings of this model that are not used by other models are released from the pool
+    StringPool::global().prune();
 }
 
 /**
@@ -55,7 +76,60 @@ QVariant TreeModel::data(const QModelIndex &index, int role) const
 
     TreeItem *item = getItem(index);
 
-    return item->data(index.column());
+    return itemData(item, index.column());
+}
+
+/**
+*Method to get a column data of a TreeItem. Data of track items is read from the shared track entry,
+*and the artist column of tracks is the first artist of the track.
+*@param item TreeItem object.
+*@param column number of column data.
+*@return the data in QVariant.
+*/
+QVariant TreeModel::itemData(TreeItem *item, int column) const
+{
+    const TrackEntry *track = item->track();
+    if (!track)
+        return item->data(column);
+
+    if (column == artistColumn())
+        return track->artists.isEmpty() ? QVariant() : QVariant(track->artists.first()->name);
+
+    const QString head = trackHeadData(column);
+    return head.isEmpty() ? QVariant() : QVariant(track->field(head));
+}
+
+/**
+*Method to get the head label of a column data of a TreeItem, taken from the track columns for track items.
+*/
+QString TreeModel::itemHeadData(TreeItem *item, int column) const
+{
+    if (item->track())
+        return trackHeadData(column);
+
+    return item->headData(column);
+}
+
+/**
+*Method to get the head label of a column of track items: name, id, href and uri followed by the
+*artist in the last column.
+*/
+QString TreeModel::trackHeadData(int column) const
+{
+    static const QStringList trackHeaders = {"name","id","href","uri"};
+
+    if (column == artistColumn())
+        return "artist";
+
+    return trackHeaders.value(column);
+}
+
+/**
+*Method to get the column where the main artist of tracks is displayed (last column of the model).
+*/
+int TreeModel::artistColumn() const
+{
+    return rootItem->columnCount() - 1;
 }
 
 /**
@@ -71,7 +145,7 @@ QString TreeModel::headData(const QModelIndex &index) const
 
     TreeItem *item = getItem(index);
 
-    return item->headData(index.column());
+    return itemHeadData(item, index.column());
 }
 
 Qt::ItemFlags TreeModel::flags(const QModelIndex &index) const
@@ -79,7 +153,13 @@ Qt::ItemFlags TreeModel::flags(const QModelIndex &index) const
     if (!index.isValid())
         return Qt::NoItemFlags;
 
-    return Qt::ItemIsEditable | QAbstractItemModel::flags(index);
+    Qt::ItemFlags itemFlags = Qt::ItemIsEditable | Qt::ItemIsDropEnabled | QAbstractItemModel::flags(index);
+
+    //Tracks can be dragged to other position of their playlist
+    if (getItem(index)->parent() != rootItem)
+        itemFlags |= Qt::ItemIsDragEnabled;
+
+    return itemFlags;
 }
 
 /**
@@ -195,13 +275,199 @@ bool TreeModel::removeRows(int position, int rows, const QModelIndex &parent)
     if (!parentItem)
         return false;
 
+    //Tracks of the rows removed are released from the registry if no other playlist refers to them
+    QSet<TrackEntry*> removedTracks;
+    for(int row = position; row < position + rows && row < parentItem->childCount(); row++)
+        collectTracks(parentItem->child(row), removedTracks);
+
     beginRemoveRows(parent, position, position + rows - 1);
     const bool success = parentItem->removeChildren(position, rows);
     endRemoveRows();
 
+    if(tracksRegistry.release(removedTracks) > 0)
+    {
+        similarityIndex.tracksReleased();
+        StringPool::global().prune();
+    }
+
+    return success;
+}
+
+/**
+*Method to add the tracks referred by an item and its children to a set.
+*@param item TreeItem object, a playlist or a track.
+*@param tracks set where the track entries are added.
+*/
+void TreeModel::collectTracks(TreeItem *item, QSet<TrackEntry*> &tracks)
+{
+    if(item->track())
+        tracks.insert(item->track());
+
+    for(int i = 0; i < item->childCount(); i++)
+        collectTracks(item->child(i), tracks);
+}
+
+/**
+*Method to move rows to other position of the same parent. Rows are moved in O(log n) time, so tracks
+*can be reordered in large playlists.
+*@param sourceParent index of the parent of the rows.
+*@param sourceRow first row moved.
+*@param count number of rows moved.
+*@param destinationParent index of the parent where rows are moved, only the source parent is supported.
+*@param destinationChild row, before the move, where the rows are placed.
+*@return true if the rows were moved.
+*/
+bool TreeModel::moveRows(const QModelIndex &sourceParent, int sourceRow, int count,
+                         const QModelIndex &destinationParent, int destinationChild)
+{
+    TreeItem *parentItem = getItem(sourceParent);
+    if (!parentItem || getItem(destinationParent) != parentItem || count <= 0
+            || sourceRow < 0 || sourceRow + count > parentItem->childCount()
+            || destinationChild < 0 || destinationChild > parentItem->childCount())
+        return false;
+
+    if (!beginMoveRows(sourceParent, sourceRow, sourceRow + count - 1, destinationParent, destinationChild))
+        return false;
+    const bool success = parentItem->moveChildren(sourceRow, count, destinationChild);
+    endMoveRows();
+
     return success;
 }
 
+/**
+*Method to move tracks of a playlist to other position, keeping their order. The tracks don't need to
+*be contiguous.
+*@param playlistIndex index of the playlist.
+*@param rows rows of the tracks moved.
+*@param destination row, before the move, where the tracks are placed.
+*@return true if the tracks were moved or already were in the destination.
+*/
+bool TreeModel::moveTracks(const QModelIndex &playlistIndex, QVector<int> rows, int destination)
+{
+    if (!playlistIndex.isValid() || playlistIndex.parent().isValid())
+        return false;
+
+    const QModelIndex parent = playlistIndex.sibling(playlistIndex.row(), 0);
+    const int tracksCount = rowCount(parent);
+    if (destination < 0 || destination > tracksCount)
+        return false;
+
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+    if (rows.isEmpty() || rows.first() < 0 || rows.last() >= tracksCount)
+        return false;
+
+    //Tracks above the destination are moved first, each one shifts the next ones up by one row
+    int movedAbove = 0;
+    for (const int row : qAsConst(rows))
+    {
+        if (row >= destination)
+            break;
+        if (row - movedAbove != destination - 1)
+            moveRows(parent, row - movedAbove, 1, parent, destination);
+        movedAbove++;
+    }
+
+    //Tracks below the destination are placed after the tracks already moved, the rows below them don't change
+    int movedBelow = 0;
+    for (const int row : qAsConst(rows))
+    {
+        if (row < destination)
+            continue;
+        if (row != destination + movedBelow)
+            moveRows(parent, row, 1, parent, destination + movedBelow);
+        movedBelow++;
+    }
+
+    return true;
+}
+
+Qt::DropActions TreeModel::supportedDropActions() const
+{
+    return Qt::MoveAction;
+}
+
+QStringList TreeModel::mimeTypes() const
+{
+    return QStringList(tracksRowsMimeType);
+}
+
+/**
+*Method to encode the tracks dragged in a view. Only tracks of one playlist can be dragged.
+*@param indexes indexes of the tracks dragged.
+*@return mime data with the playlist row and the tracks rows, or nullptr if there are no tracks to drag.
+*/
+QMimeData *TreeModel::mimeData(const QModelIndexList &indexes) const
+{
+    QModelIndex playlistIndex;
+    QVector<int> rows;
+
+    for (const QModelIndex &index : indexes)
+    {
+        if (!index.isValid() || !index.parent().isValid())
+            continue;
+        if (playlistIndex.isValid() && index.parent() != playlistIndex)
+            return nullptr;
+
+        playlistIndex = index.parent();
+        rows.append(index.row());
+    }
+
+    if (rows.isEmpty())
+        return nullptr;
+
+    QByteArray encoded;
+    QDataStream stream(&encoded, QIODevice::WriteOnly);
+    stream << playlistIndex.row() << rows;
+
+    QMimeData *data = new QMimeData();
+    data->setData(tracksRowsMimeType, encoded);
+    return data;
+}
+
+/**
+*Method to move the tracks dropped in a view. Tracks dropped on a track are placed before it and tracks
+*dropped on their playlist are placed at its end.
+*@param data mime data created by mimeData().
+*@param action drop action, only Qt::MoveAction is handled.
+*@param row row where the tracks are dropped, -1 if they are dropped on parent.
+*@param column column where the tracks are dropped.
+*@param parent index of the item where the tracks are dropped.
+*@return always false, the tracks are already moved, so the view doesn't remove the dragged rows as it
+*does after a drop that copies them.
+*/
+bool TreeModel::dropMimeData(const QMimeData *data, Qt::DropAction action,
+                             int row, int column, const QModelIndex &parent)
+{
+    Q_UNUSED(column);
+
+    if (action != Qt::MoveAction || !data || !data->hasFormat(tracksRowsMimeType))
+        return false;
+
+    QModelIndex playlistIndex = parent;
+    int destination = row;
+    if (parent.isValid() && parent.parent().isValid())
+    {
+        playlistIndex = parent.parent();
+        destination = parent.row();
+    }
+
+    if (!playlistIndex.isValid())
+        return false;
+    if (destination < 0)
+        destination = rowCount(playlistIndex);
+
+    int playlistRow;
+    QVector<int> rows;
+    QDataStream stream(data->data(tracksRowsMimeType));
+    stream >> playlistRow >> rows;
+
+    //Tracks are only reordered inside their playlist
+    if (playlistRow == playlistIndex.row())
+        moveTracks(playlistIndex, rows, destination);
+
+    return false;
+}
 
 int TreeModel::rowCount(const QModelIndex &parent) const
 {
@@ -217,6 +483,18 @@ bool TreeModel::setData(const QModelIndex &index, const QVariant &value, int rol
         return false;
 
     TreeItem *item = getItem(index);
+
+    //Data of a track is shared, so the change is shown in all playlists containing the track
+    if (TrackEntry *track = item->track())
+    {
+        //The registry keeps the track registered by its key when the id, uri or name changes
+        if (!tracksRegistry.setField(track, trackHeadData(index.column()), value.toString()))
+            return false;
+
+        emitTrackChanged(track, index.column(), index.column());
+        return true;
+    }
+
     bool result = item->setData(index.column(), value);
 
     if (result)
@@ -225,9 +503,27 @@ bool TreeModel::setData(const QModelIndex &index, const QVariant &value, int rol
     return result;
 }
 
+/**
+*Method to notify the views that columns data of a track changed in all items referring to the track.
+*/
+void TreeModel::emitTrackChanged(TrackEntry *track, int firstColumn, int lastColumn)
+{
+    for (TreeItem *item : qAsConst(track->items))
+    {
+        const int row = item->childNumber();
+        emit dataChanged(createIndex(row, firstColumn, item), createIndex(row, lastColumn, item),
+                         {Qt::DisplayRole, Qt::EditRole});
+    }
+}
+
 bool TreeModel::setHeadData(const QModelIndex &index, const QString &value)
 {
     TreeItem *item = getItem(index);
+
+    //Head labels of track items are the same for all tracks
+    if (item->track())
+        return false;
+
     return item->setHeadData(index.column(), value);
 }
 
@@ -253,11 +549,13 @@ bool TreeModel::setHeaderData(int section, Qt::Orientation orientation,
 */
 bool TreeModel::loadModelData(const QString filePath)
 {
+    TRACE_SCOPE("load model file", "model");
+
     modelType = MODEL_TYPE_PLAYLIST;
     QFile loadFile(filePath);
 
     if (!loadFile.open(QIODevice::ReadOnly)) {
-        qWarning("Couldn't open save file.");
+        LOG_WARNING("model", "Couldn't open file " + filePath);
         return 0;
     }
 
@@ -265,15 +563,18 @@ bool TreeModel::loadModelData(const QString filePath)
 
     QStringList childrenHeader = {"name","id","href","uri"};
 
-    QJsonDocument loadDoc(QJsonDocument::fromJson(saveData));
-    const auto root_obj = loadDoc.object();
+    QJsonObject root_obj;
+    {
+        TRACE_SCOPE("parse json", "json");
+        root_obj = QJsonDocument::fromJson(saveData).object();
+    }
 
     QStringList arrayLevels = {"playlists", "tracks", "artists"};
 
     //Insert recursively children in the rootItem
     if(!AddChildrenFromJson(root_obj,rootItem,arrayLevels,childrenHeader))
     {
-        qDebug()<<"Model not set"<<endl;
+        LOG_WARNING("model", "Model not set");
         return 0;
     }
 
@@ -288,6 +589,8 @@ bool TreeModel::loadModelData(const QString filePath)
 */
 bool TreeModel::loadModelData(QJsonObject parentJson , int model_type)
 {
+    TRACE_SCOPE("build model", "model");
+
     QStringList arrayLevels = {"playlists","tracks","artists"};
     if(model_type == MODEL_TYPE_TRACK)
         arrayLevels.pop_front();
@@ -297,7 +600,7 @@ bool TreeModel::loadModelData(QJsonObject parentJson , int model_type)
     //Insert recursively children in the rootItem
     if(!AddChildrenFromJson(parentJson,rootItem,arrayLevels,childrenHeader))
     {
-        qDebug()<<"Model not set "<<endl;
+        LOG_WARNING("model", "Model not set");
         return 0;
     }
 
@@ -331,6 +634,10 @@ bool TreeModel::AddChildrenFromJson(QJsonObject parentJson, TreeItem *parentItem
     if(headers.size()==0)
         return 0;
 
+    //Tracks are not copied in each playlist: items refer to the entries shared in the tracks registry
+    if(childrenLabel == "tracks")
+        return addTracksFromJson(childrenArrayJson, parentItem, headers, itemsArrays.contains("artists"));
+
     int dataCount = headers.size();
 
     for(int i=0; i<childrenArrayJson.size(); i++)
@@ -345,22 +652,14 @@ bool TreeModel::AddChildrenFromJson(QJsonObject parentJson, TreeItem *parentItem
         {
             if(!childItemJson.contains(headers[j]))
             {
-                qDebug()<<"Model child not created: Array object data incomplete"<<endl;
+                LOG_WARNING("model", "Model child not created: Array object data incomplete");
                 parentItem->removeChildren(0,parentItem->childCount());
                 return 0;
             }
-            parentItem->child(parentItem->childCount() - 1)->setData(j,QVariant(childItemJson.value(headers[j]).toString()));
+            parentItem->child(parentItem->childCount() - 1)->setData(j,QVariant(StringPool::global().intern(childItemJson.value(headers[j]).toString())));
             parentItem->child(parentItem->childCount() - 1)->setHeadData(j,headers[j]);
         }
 
-        //Adds artist information to tracks column data for display purposes
-        if(parentJson.contains("artists"))
-        {
-            const auto childItemJson0 = childrenArrayJson[0].toObject();
-            parentItem->setData(parentItem->columnCount()-1,childItemJson0.value("name").toString());
-            parentItem->setHeadData(parentItem->columnCount()-1,"artist");
-        }
-
         if(itemsArrays.size()==0)
             return 1;
         else
@@ -375,6 +674,144 @@ bool TreeModel::AddChildrenFromJson(QJsonObject parentJson, TreeItem *parentItem
     return 1;
 }
 
+/**
+*Method to add the tracks of a playlist from Json data. Each track (and its artists) is interned in the
+*registries of the model, so a track present in many playlists is stored only once.
+*@param tracksArrayJson array with the tracks Json objects.
+*@param playlistItem playlist TreeItem object that receives the track items.
+*@param headers List with the labels that each track and artist Json object must contain.
+*@param withArtists true if each track must have a non empty array of artists.
+*Tracks with only an id or uri (e.g. imported from other applications) are added without data, to be hydrated
+*with the data of the server (see missingTrackIds).
+*/
+bool TreeModel::addTracksFromJson(const QJsonArray &tracksArrayJson, TreeItem *playlistItem, const QStringList &headers, bool withArtists)
+{
+    for(const auto trackValue : tracksArrayJson)
+    {
+        const auto trackJson = trackValue.toObject();
+
+        if(!isTrackJsonValid(trackJson, headers, withArtists))
+        {
+            LOG_WARNING("model", "Model child not created: Array object data incomplete");
+            playlistItem->removeChildren(0,playlistItem->childCount());
+            return 0;
+        }
+
+        playlistItem->insertTrack(playlistItem->childCount(), tracksRegistry.intern(trackJson));
+    }
+
+    return 1;
+}
+
+/**
+*Method to check if a track Json object can be added to a playlist: it has all the labels of headers (and
+*artists with them), or at least an id or uri to be hydrated later.
+*@param trackJson Json object of the track.
+*@param headers List with the labels that each track and artist Json object must contain.
+*@param withArtists true if the track must have a non empty array of artists.
+*/
+bool TreeModel::isTrackJsonValid(const QJsonObject &trackJson, const QStringList &headers, bool withArtists)
+{
+    bool complete = true;
+    for(const QString &header : headers)
+        complete = complete && trackJson.contains(header);
+
+    if(withArtists)
+    {
+        const auto artistsArrayJson = trackJson.value("artists").toArray();
+        complete = complete && !artistsArrayJson.isEmpty();
+
+        for(const auto artistValue : artistsArrayJson)
+            for(const QString &header : headers)
+                complete = complete && artistValue.toObject().contains(header);
+    }
+
+    const bool stub = !trackJson.value("id").toString().isEmpty()
+            || !TrackRegistry::idFromUri(trackJson.value("uri").toString()).isEmpty();
+
+    return complete || stub;
+}
+
+/**
+*Method to append a playlist, without its tracks, at the end of the model. Unlike loadModelData the row is
+*inserted with the model signals, so the views show it at once (see ModelLoader).
+*@param playlistJson Json object of the playlist (name, id, href and uri).
+*@return index of the playlist appended, invalid if the playlist data is incomplete.
+*/
+QModelIndex TreeModel::appendPlaylistFromJson(const QJsonObject &playlistJson)
+{
+    const QStringList headers = {"name","id","href","uri"};
+
+    for(const QString &header : headers)
+    {
+        if(!playlistJson.contains(header))
+        {
+            LOG_WARNING("model", "Model child not created: Array object data incomplete");
+            return QModelIndex();
+        }
+    }
+
+    const int row = rootItem->childCount();
+    beginInsertRows(QModelIndex(), row, row);
+    rootItem->insertChildren(row, 1, rootItem->columnCount());
+
+    TreeItem *playlistItem = rootItem->child(row);
+    for(int j = 0; j < headers.size(); j++)
+    {
+        playlistItem->setData(j,QVariant(StringPool::global().intern(playlistJson.value(headers[j]).toString())));
+        playlistItem->setHeadData(j,headers[j]);
+    }
+    endInsertRows();
+
+    return createIndex(row, 0, playlistItem);
+}
+
+/**
+*Method to append a range of the tracks of a playlist Json object at the end of the playlist, with one
+*insertion of rows in the views. The tracks are checked before any of them is appended.
+*@param playlistIndex index of the playlist TreeItem object.
+*@param tracksArrayJson array with the tracks Json objects (name, id, href, uri and artists array).
+*@param first position in tracksArrayJson of the first track appended.
+*@param count number of tracks appended.
+*@return true if the tracks were appended, false if the data of a track is incomplete (nothing is appended).
+*/
+bool TreeModel::appendTracksFromJson(const QModelIndex &playlistIndex, const QJsonArray &tracksArrayJson, int first, int count)
+{
+    const QStringList headers = {"name","id","href","uri"};
+    TreeItem *playlistItem = getItem(playlistIndex);
+    if(!playlistIndex.isValid() || count <= 0 || first < 0 || first + count > tracksArrayJson.size())
+        return false;
+
+    for(int i = first; i < first + count; i++)
+    {
+        if(!isTrackJsonValid(tracksArrayJson[i].toObject(), headers, true))
+        {
+            LOG_WARNING("model", "Model child not created: Array object data incomplete");
+            return false;
+        }
+    }
+
+    //Tracks already in the model without data are filled by the tracks appended, their other rows are updated
+    QSet<TrackEntry*> filledTracks;
+
+    const int position = playlistItem->childCount();
+    beginInsertRows(playlistIndex, position, position + count - 1);
+    for(int i = first; i < first + count; i++)
+    {
+        bool filled = false;
+        TrackEntry *track = tracksRegistry.intern(tracksArrayJson[i].toObject(), &filled);
+        playlistItem->insertTrack(playlistItem->childCount(), track);
+        if(filled)
+            filledTracks.insert(track);
+    }
+    endInsertRows();
+
+    for(TrackEntry *track : qAsConst(filledTracks))
+        emitTrackChanged(track, 0, columnCount() - 1);
+
+    return true;
+}
+
 /**
 *Method to save the current user playlists Tree model in (.json). It crates a Json root object and adds information
 *from the TreeItem objects of the model.
@@ -383,6 +820,7 @@ bool TreeModel::AddChildrenFromJson(QJsonObject parentJson, TreeItem *parentItem
 */
 bool TreeModel::saveModelDataOffline(QString filePath)
 {
+    TRACE_SCOPE("save model", "save");
 
     QJsonDocument playlistsJsonDoc;
     QJsonObject root_obj;
@@ -411,7 +849,7 @@ bool TreeModel::saveModelDataOffline(QString filePath)
         }
         else
         {
-            qDebug()<<"Error - Playlists not saved: Problem with child index"<<endl;
+            LOG_ERROR("model", "Playlists not saved: Problem with child index");
             return false;
         }
         QJsonArray tracksArray;
@@ -436,39 +874,11 @@ bool TreeModel::saveModelDataOffline(QString filePath)
             }
             else
             {
-                qDebug()<<"Error - Playlists not saved: Problem with child index"<<endl;
+                LOG_ERROR("model", "Playlists not saved: Problem with child index");
                 return false;
             }
 
-            QJsonArray artistsArray;
-            int N_artists= rowCount(track_item_index);
-            for(int r=0;r<N_artists; r++)
-            {
-                QModelIndex artist_item_index;
-                if(hasIndex(r,0,track_item_index))
-                {
-                    QJsonObject artistObj;
-
-                    //get child index of each artist item data in the current track item
-                    artist_item_index = index(r,0,track_item_index);
-
-                    QModelIndex data_index;
-                    for (int k=0;k< columnCount(artist_item_index); k++)
-                    {
-                        auto data_index = index(r,k,track_item_index);
-                        //Insert key-data pairs in artist Json object
-                        if(childrenHeader.contains(headData(data_index)))
-                            artistObj.insert(headData(data_index),data_index.data().toString());
-                    }
-                    artistsArray.append(artistObj);
-                }
-                else
-                {
-                    qDebug()<<"Error - Playlists not saved: Problem with child index"<<endl;
-                    return false;
-                }
-            }
-            trackObj.insert("artists",artistsArray);
+            trackObj.insert("artists",trackArtists(track_item_index));
             tracksArray.append(trackObj);
 
         }
@@ -484,13 +894,13 @@ bool TreeModel::saveModelDataOffline(QString filePath)
     QFile saveFile(filePath);
 
     if (!saveFile.open(QIODevice::WriteOnly)) {
-        qWarning("Couldn't open save file.");
+        LOG_ERROR("model", "Couldn't open save file " + filePath);
         return false;
     }
 
     if(saveFile.write(playlistsJsonDoc.toJson())==-1)
     {
-        qDebug()<<"Error during write operation to file"<<endl;
+        LOG_ERROR("model", "Error during write operation to file " + filePath);
         return false;
     }
 
@@ -512,9 +922,9 @@ QVariant TreeModel::findDataByHead(QString headName, QModelIndex &itemIndex)
     if(item==rootItem)
         return QVariant();
 
-    for( int i=0; i< item->columnCount(); i++)
-        if(item->headData(i)==headName)
-            return item->data(i);
+    for( int i=0; i< columnCount(); i++)
+        if(itemHeadData(item, i)==headName)
+            return itemData(item, i);
 
     return QVariant();
 
@@ -524,3 +934,258 @@ int TreeModel::getModelType()
 {
     return modelType;
 }
+
+const ArtistRegistry &TreeModel::artistRegistry() const
+{
+    return artistsRegistry;
+}
+
+const TrackRegistry &TreeModel::trackRegistry() const
+{
+    return tracksRegistry;
+}
+
+/**
+*Method to insert a track in a playlist. The track is interned in the tracks registry, so a track already
+*present in other playlists is shared with them.
+*@param position row of the track in the playlist.
+*@param playlistIndex index of the playlist TreeItem object.
+*@param trackJson Json object of the track (name, id, href, uri and artists array).
+*@return true if the track was inserted, false if the position is out of the playlist range.
+*/
+bool TreeModel::insertTrack(int position, const QModelIndex &playlistIndex, const QJsonObject &trackJson)
+{
+    TreeItem *playlistItem = getItem(playlistIndex);
+    if(position < 0 || position > playlistItem->childCount())
+        return false;
+
+    bool filled = false;
+    TrackEntry *track = tracksRegistry.intern(trackJson, &filled);
+
+    beginInsertRows(playlistIndex, position, position);
+    const bool success = playlistItem->insertTrack(position, track);
+    endInsertRows();
+
+    if(filled)
+        emitTrackChanged(track, 0, columnCount() - 1);
+
+    return success;
+}
+
+/**
+*Method to get a track with its artists in the format of the playlists files.
+*@param trackIndex index of the track TreeItem object.
+*@return the track Json object, empty if the index is not a track.
+*/
+QJsonObject TreeModel::trackJson(const QModelIndex &trackIndex) const
+{
+    if(!trackIndex.isValid())
+        return QJsonObject();
+
+    const TrackEntry *track = getItem(trackIndex)->track();
+    return track ? TrackRegistry::toJson(track) : QJsonObject();
+}
+
+/**
+*Method to get the artists of a track in the format of the playlists files.
+*@param trackIndex index of the track TreeItem object.
+*@return array with the Json objects of the artists (name, id, href, uri), empty if the index is not a track.
+*/
+QJsonArray TreeModel::trackArtists(const QModelIndex &trackIndex) const
+{
+    return trackJson(trackIndex).value("artists").toArray();
+}
+
+/**
+*Method to get the uris of the tracks of a playlist, in playlist order.
+*@param playlistIndex index of the playlist TreeItem object.
+*@return uris of the tracks, tracks without uri are skipped.
+*/
+QStringList TreeModel::trackUris(const QModelIndex &playlistIndex) const
+{
+    QStringList uris;
+    if(!playlistIndex.isValid() || playlistIndex.parent().isValid())
+        return uris;
+
+    TreeItem *playlistItem = getItem(playlistIndex);
+    uris.reserve(playlistItem->childCount());
+
+    for(int i = 0; i < playlistItem->childCount(); i++)
+    {
+        const TrackEntry *track = playlistItem->child(i)->track();
+        if(track && !track->uri.isEmpty())
+            uris.append(track->uri);
+    }
+
+    return uris;
+}
+
+/**
+*Method to get the ids of the tracks of the model without data, to request them from the server.
+*@return ids of the tracks, once each.
+*/
+QStringList TreeModel::missingTrackIds() const
+{
+    return tracksRegistry.missingIds();
+}
+
+/**
+*Method to fill the tracks without data with the tracks received from the server. All rows of each track
+*are updated in place and the views are notified.
+*@param tracksJson array with the Json objects of the tracks (name, id, href, uri and artists array).
+*@return number of tracks filled.
+*/
+int TreeModel::hydrateTracks(const QJsonArray &tracksJson)
+{
+    int hydrated = 0;
+
+    for(const auto trackValue : tracksJson)
+    {
+        for(TrackEntry *track : tracksRegistry.hydrate(trackValue.toObject()))
+        {
+            emitTrackChanged(track, 0, columnCount() - 1);
+            hydrated++;
+        }
+    }
+
+    return hydrated;
+}
+
+const AudioFeatureStore &TreeModel::audioFeatures() const
+{
+    return featuresStore;
+}
+
+/**
+*Method to get the ids of the tracks of the model without audio features, to request them from the server.
+*@return ids of the tracks, once each.
+*/
+QStringList TreeModel::missingFeatureIds() const
+{
+    return featuresStore.missingIds(tracksRegistry.ids());
+}
+
+/**
+*Method to store the audio features received from the server.
+*@param featuresJson array with the audio features Json objects, as in the audio features endpoint reply.
+*@return number of tracks stored.
+*/
+int TreeModel::setAudioFeatures(const QJsonArray &featuresJson)
+{
+    return featuresStore.set(featuresJson);
+}
+
+/**
+*Method to get the summary (minimum, maximum, mean, deviation) of a feature over the tracks of a playlist.
+*Tracks without audio features are not counted.
+*@param playlistIndex index of the playlist TreeItem object.
+*@param feature feature summarized.
+*/
+FeatureSummary TreeModel::playlistFeatureSummary(const QModelIndex &playlistIndex, AudioFeatureStore::Feature feature) const
+{
+    QVector<int> rows;
+    if(playlistIndex.isValid() && !playlistIndex.parent().isValid())
+    {
+        TreeItem *playlistItem = getItem(playlistIndex);
+        rows.reserve(playlistItem->childCount());
+
+        for(int i = 0; i < playlistItem->childCount(); i++)
+        {
+            const TrackEntry *track = playlistItem->child(i)->track();
+            const int row = track ? featuresStore.row(track->id) : -1;
+            if(row >= 0)
+                rows.append(row);
+        }
+    }
+
+    return featuresStore.summary(feature, rows);
+}
+
+/**
+*Method to find the tracks of the playlists most similar to a track or to a playlist ("more like this"), from
+*their audio features and without requests to the server. For a playlist the tracks nearest to the centroid
+*of its tracks are found, and the tracks of the playlist are not returned.
+*@param index index of a track or playlist TreeItem object.
+*@param k maximum number of tracks returned.
+*@return array with the Json objects of the tracks found, nearest first.
+*/
+QJsonArray TreeModel::similarTracks(const QModelIndex &index, int k) const
+{
+    QJsonArray tracksJson;
+    if(!index.isValid())
+        return tracksJson;
+
+    TreeItem *item = getItem(index);
+    QVector<SimilarTrack> found;
+
+    if(item->track())
+        found = similarityIndex.nearestToTrack(item->track()->id, k);
+    else if(!index.parent().isValid())
+    {
+        QStringList ids;
+        ids.reserve(item->childCount());
+        for(int i = 0; i < item->childCount(); i++)
+        {
+            const TrackEntry *track = item->child(i)->track();
+            if(track)
+                ids.append(track->id);
+        }
+        found = similarityIndex.nearestToTracks(ids, k);
+    }
+
+    for(const SimilarTrack &similar : qAsConst(found))
+    {
+        const TrackEntry *track = tracksRegistry.track(similar.id);
+        if(track)
+            tracksJson.append(TrackRegistry::toJson(track));
+    }
+
+    return tracksJson;
+}
+
+/**
+*Method to find all tracks of an artist in the model, without visiting the playlists.
+*@param artistId spotify id of the artist.
+*@return list with the index (first column) of each track item of the artist, in all playlists.
+*/
+QModelIndexList TreeModel::tracksByArtist(const QString &artistId) const
+{
+    QModelIndexList tracks;
+
+    const ArtistEntry *artist = artistsRegistry.artist(artistId);
+    if(!artist)
+        return tracks;
+
+    for(const TrackEntry *track : artist->tracks)
+        for(TreeItem *item : track->items)
+            tracks.append(createIndex(item->childNumber(), 0, item));
+
+    return tracks;
+}
+
+/**
+*Method to find the playlists that contain a track, using the reverse index of the track.
+*@param trackId spotify id of the track.
+*@return list with the index (first column) of each playlist containing the track, once per playlist.
+*/
+QModelIndexList TreeModel::playlistsContaining(const QString &trackId) const
+{
+    QModelIndexList playlists;
+
+    const TrackEntry *track = tracksRegistry.track(trackId);
+    if(!track)
+        return playlists;
+
+    QSet<TreeItem*> visited;
+    for(TreeItem *item : track->items)
+    {
+        TreeItem *playlistItem = item->parent();
+        if(!playlistItem || playlistItem == rootItem || visited.contains(playlistItem))
+            continue;
+
+        visited.insert(playlistItem);
+        playlists.append(createIndex(playlistItem->childNumber(), 0, playlistItem));
+    }
+
+    return playlists;
+}
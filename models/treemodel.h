@@ -4,6 +4,12 @@
 #include <QAbstractItemModel>
 #include <QModelIndex>
 #include <QVariant>
+#include <QJsonArray>
+#include "artistregistry.h"
+#include "trackregistry.h"
+#include "audiofeaturestore.h"
+#include "similarityindex.h"
+#include "treeitemarena.h"
 
 #define MODEL_TYPE_PLAYLIST 0
 #define MODEL_TYPE_TRACK 1
@@ -54,6 +60,16 @@ public:
                     const QModelIndex &parent = QModelIndex()) override;
     bool removeRows(int position, int rows,
                     const QModelIndex &parent = QModelIndex()) override;
+    bool moveRows(const QModelIndex &sourceParent, int sourceRow, int count,
+                  const QModelIndex &destinationParent, int destinationChild) override;
+
+    //Methods to reorder tracks of a playlist by drag and drop in the views
+    Qt::DropActions supportedDropActions() const override;
+    QStringList mimeTypes() const override;
+    QMimeData *mimeData(const QModelIndexList &indexes) const override;
+    bool dropMimeData(const QMimeData *data, Qt::DropAction action,
+                      int row, int column, const QModelIndex &parent) override;
+    bool moveTracks(const QModelIndex &playlistIndex, QVector<int> rows, int destination);
 
     QString headData(const QModelIndex &index) const;
     bool setHeadData(const QModelIndex &index, const QString &value);
@@ -63,12 +79,51 @@ public:
     bool loadModelData(const QString filePath);
     bool loadModelData(QJsonObject parentJson, int model_type);
     bool AddChildrenFromJson(QJsonObject parentJson, TreeItem *parentItem, QStringList itemsArrays, QStringList headers);
+    QModelIndex appendPlaylistFromJson(const QJsonObject &playlistJson);
+    bool appendTracksFromJson(const QModelIndex &playlistIndex, const QJsonArray &tracksArrayJson, int first, int count);
     int getModelType();
 
+    //Methods to access tracks and artists, shared by the playlists in the tracks and artists registries
+    const ArtistRegistry &artistRegistry() const;
+    const TrackRegistry &trackRegistry() const;
+    bool insertTrack(int position, const QModelIndex &playlistIndex, const QJsonObject &trackJson);
+    QJsonObject trackJson(const QModelIndex &trackIndex) const;
+    QJsonArray trackArtists(const QModelIndex &trackIndex) const;
+    QStringList trackUris(const QModelIndex &playlistIndex) const;
+    QStringList missingTrackIds() const;
+    int hydrateTracks(const QJsonArray &tracksJson);
+
+    //Methods to access the audio features of the tracks, stored by track id
+    const AudioFeatureStore &audioFeatures() const;
+    QStringList missingFeatureIds() const;
+    int setAudioFeatures(const QJsonArray &featuresJson);
+    FeatureSummary playlistFeatureSummary(const QModelIndex &playlistIndex, AudioFeatureStore::Feature feature) const;
+    QJsonArray similarTracks(const QModelIndex &index, int k) const;
+
+    QModelIndexList tracksByArtist(const QString &artistId) const;
+    QModelIndexList playlistsContaining(const QString &trackId) const;
+
 
 
 private:
     TreeItem *getItem(const QModelIndex &index) const;
+    QVariant itemData(TreeItem *item, int column) const;
+    QString itemHeadData(TreeItem *item, int column) const;
+    QString trackHeadData(int column) const;
+    int artistColumn() const;
+    bool addTracksFromJson(const QJsonArray &tracksArrayJson, TreeItem *playlistItem, const QStringList &headers, bool withArtists);
+    static bool isTrackJsonValid(const QJsonObject &trackJson, const QStringList &headers, bool withArtists);
+    void emitTrackChanged(TrackEntry *track, int firstColumn, int lastColumn);
+    static void collectTracks(TreeItem *item, QSet<TrackEntry*> &tracks);
+
+    //Artists registry is declared first so it outlives the tracks that refer to its entries
+    ArtistRegistry artistsRegistry;
+    TrackRegistry tracksRegistry;
+    AudioFeatureStore featuresStore;
+    SimilarityIndex similarityIndex;
+
+    //All items of the tree are allocated in the arena and released together with the model
+    TreeItemArena itemsArena;
     TreeItem *rootItem;
     QJsonDocument *jsonData;
 };
@@ -2,7 +2,9 @@ QT       += core gui network networkauth uitools
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
-CONFIG += c++11
+CONFIG += c++2a
+# GCC 10 enables the coroutines of the request layer (api/asynctask.h) only with this flag
+*-g++*: QMAKE_CXXFLAGS += -fcoroutines
 CONFIG += qt debug
 # You can make your code fail to compile if it uses deprecated APIs.
 # In order to do so, uncomment the following line.
@@ -12,16 +14,48 @@ SOURCES += \
     main.cpp \
     interface/mainwindow.cpp\
     api/spotifyapi.cpp \
+    api/playlistsync.cpp \
+    api/asynctask.cpp \
+    api/operationqueue.cpp \
+    api/networkthread.cpp \
     models/treeitem.cpp \
-    models/treemodel.cpp
+    models/treeitemarena.cpp \
+    models/treemodel.cpp \
+    models/modelloader.cpp \
+    models/artistregistry.cpp \
+    models/trackregistry.cpp \
+    models/audiofeaturestore.cpp \
+    models/featurekernels.cpp \
+    models/similarityindex.cpp \
+    models/stringpool.cpp \
+    utils/tracer.cpp \
+    utils/networkmetrics.cpp \
+    utils/logger.cpp
 
 HEADERS += \
     interface/mainwindow.h \
     models/musicutils.h \
     api/spotifyapi.h \
+    api/playlistsync.h \
+    api/asynctask.h \
+    api/operationqueue.h \
+    api/networkthread.h \
     models/spotifyutils.h \
     models/treeitem.h \
-    models/treemodel.h
+    models/ranksequence.h \
+    models/treeitemarena.h \
+    models/treemodel.h \
+    models/modelloader.h \
+    models/artistregistry.h \
+    models/trackregistry.h \
+    models/audiofeaturestore.h \
+    models/featurekernels.h \
+    models/similarityindex.h \
+    models/stringpool.h \
+    utils/tracer.h \
+    utils/networkmetrics.h \
+    utils/logger.h \
+    utils/mpscqueue.h
 
 FORMS += \
     interface/mainwindow.ui
@@ -0,0 +1,61 @@
+#include "mockspotifyserver.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTextStream>
+
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("mockspotifyserver");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Local stub of Spotify Web API and accounts servers for load and latency tests");
+    parser.addHelpOption();
+
+    QCommandLineOption portOption("port", "Listening port.", "port", "9090");
+    QCommandLineOption playlistsOption("playlists", "Number of user playlists.", "count", "20");
+    QCommandLineOption tracksOption("tracks", "Number of tracks per playlist.", "count", "100");
+    QCommandLineOption artistsOption("artists", "Number of artists per track.", "count", "2");
+    QCommandLineOption trackPoolOption("track-pool", "Number of distinct tracks in the library.", "count", "5000");
+    QCommandLineOption artistPoolOption("artist-pool", "Number of distinct artists in the library.", "count", "500");
+    QCommandLineOption pageSizeOption("page-size", "Maximum number of playlist tracks per page.", "count", "100");
+    QCommandLineOption latencyOption("latency", "Delay of each response in milliseconds.", "ms", "0");
+    QCommandLineOption jitterOption("jitter", "Maximum random delay added to latency in milliseconds.", "ms", "0");
+    QCommandLineOption rateLimitOption("rate-limit-every", "Answer every Nth api request with 429 (0 disables).", "n", "0");
+    QCommandLineOption retryAfterOption("retry-after", "Retry-After of 429 responses in seconds.", "seconds", "1");
+    QCommandLineOption paddingOption("padding", "Extra bytes added to each track object.", "bytes", "0");
+    QCommandLineOption tokenExpiryOption("token-expiry", "Access tokens lifetime in seconds.", "seconds", "3600");
+    QCommandLineOption seedOption("seed", "Seed of the synthetic library and jitter.", "seed", "1");
+
+    parser.addOptions({portOption, playlistsOption, tracksOption, artistsOption, trackPoolOption, artistPoolOption,
+                       pageSizeOption, latencyOption, jitterOption, rateLimitOption, retryAfterOption, paddingOption,
+                       tokenExpiryOption, seedOption});
+    parser.process(a);
+
+    MockServerConfig config;
+    config.playlists = parser.value(playlistsOption).toInt();
+    config.tracksPerPlaylist = parser.value(tracksOption).toInt();
+    config.artistsPerTrack = parser.value(artistsOption).toInt();
+    config.trackPool = qMax(1, parser.value(trackPoolOption).toInt());
+    config.artistPool = qMax(1, parser.value(artistPoolOption).toInt());
+    config.pageSize = qMax(1, parser.value(pageSizeOption).toInt());
+    config.latencyMs = parser.value(latencyOption).toInt();
+    config.jitterMs = parser.value(jitterOption).toInt();
+    config.rateLimitEvery = parser.value(rateLimitOption).toInt();
+    config.retryAfterSeconds = parser.value(retryAfterOption).toInt();
+    config.payloadPadding = parser.value(paddingOption).toInt();
+    config.tokenExpiry = parser.value(tokenExpiryOption).toInt();
+    config.seed = parser.value(seedOption).toUInt();
+
+    MockSpotifyServer server(config);
+    if(!server.Listen(QHostAddress::LocalHost, quint16(parser.value(portOption).toUInt())))
+    {
+        QTextStream(stderr) << "Unable to listen on port " << parser.value(portOption) << endl;
+        return 1;
+    }
+
+    QTextStream(stdout) << "Mock Spotify Web API listening on " << server.BaseUrl() << endl;
+
+    return a.exec();
+}
@@ -0,0 +1,15 @@
+QT       += core network
+QT       -= gui
+
+CONFIG += c++11 console
+CONFIG += qt debug
+CONFIG -= app_bundle
+
+TARGET = mockspotifyserver
+
+SOURCES += \
+    main.cpp \
+    mockspotifyserver.cpp
+
+HEADERS += \
+    mockspotifyserver.h
@@ -0,0 +1,772 @@
+#include "mockspotifyserver.h"
+
+#include <QJsonDocument>
+#include <QUrlQuery>
+#include <QTimer>
+#include <QSet>
+#include <algorithm>
+
+/**
+Function to mix two integers into a well distributed hash, used to generate the synthetic library
+deterministically from the server seed.
+*/
+static quint32 Mix(quint32 a, quint32 b)
+{
+    quint32 h = (a * 0x9E3779B1u) ^ (b + 0x7F4A7C15u + (a << 6) + (a >> 2));
+    h ^= h >> 16;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35u;
+    h ^= h >> 16;
+    return h;
+}
+
+static QByteArray ReasonPhrase(int status)
+{
+    switch(status)
+    {
+    case 200: return "OK";
+    case 201: return "Created";
+    case 204: return "No Content";
+    case 302: return "Found";
+    case 400: return "Bad Request";
+    case 401: return "Unauthorized";
+    case 404: return "Not Found";
+    case 429: return "Too Many Requests";
+    default: return "Unknown";
+    }
+}
+
+MockSpotifyServer::MockSpotifyServer(const MockServerConfig &serverConfig, QObject *parent)
+    : QObject(parent),
+      config(serverConfig),
+      random(serverConfig.seed),
+      requestCount(0),
+      tokenCount(0)
+{
+    connect(&server, &QTcpServer::newConnection, this, &MockSpotifyServer::NewConnection);
+}
+
+bool MockSpotifyServer::Listen(const QHostAddress &address, quint16 port)
+{
+    return server.listen(address, port);
+}
+
+/**
+Method to get the base address of the server, to be used as api and accounts url by the clients.
+*/
+QString MockSpotifyServer::BaseUrl() const
+{
+    return QString("http://%1:%2").arg(server.serverAddress().toString()).arg(server.serverPort());
+}
+
+quint64 MockSpotifyServer::RequestCount() const
+{
+    return requestCount;
+}
+
+void MockSpotifyServer::NewConnection()
+{
+    while(server.hasPendingConnections())
+    {
+        QTcpSocket *socket = server.nextPendingConnection();
+
+        connect(socket, &QTcpSocket::readyRead, this, &MockSpotifyServer::ReadRequest);
+        connect(socket, &QTcpSocket::disconnected, this, [=](){
+            buffers.remove(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+/**
+SLOT Method called when data is received in a connection. Complete requests in the connection buffer
+are answered in order; partial requests wait for more data. Connections are kept alive unless the client
+asks to close them.
+*/
+void MockSpotifyServer::ReadRequest()
+{
+    QTcpSocket *socket = qobject_cast<QTcpSocket*>(sender());
+    if(!socket)
+        return;
+
+    QByteArray &buffer = buffers[socket];
+    buffer.append(socket->readAll());
+
+    while(true)
+    {
+        const int headerEnd = buffer.indexOf("\r\n\r\n");
+        if(headerEnd < 0)
+            return;
+
+        const QList<QByteArray> lines = buffer.left(headerEnd).split('\n');
+        const QList<QByteArray> requestLine = lines.value(0).trimmed().split(' ');
+        if(requestLine.size() < 3)
+        {
+            socket->disconnectFromHost();
+            return;
+        }
+
+        int contentLength = 0;
+        bool keepAlive = requestLine[2] == "HTTP/1.1";
+        for(int i = 1; i < lines.size(); i++)
+        {
+            const QByteArray line = lines[i].trimmed();
+            const int colon = line.indexOf(':');
+            if(colon < 0)
+                continue;
+
+            const QByteArray name = line.left(colon).trimmed().toLower();
+            const QByteArray value = line.mid(colon + 1).trimmed().toLower();
+            if(name == "content-length")
+                contentLength = value.toInt();
+            else if(name == "connection")
+                keepAlive = value != "close";
+        }
+
+        if(buffer.size() < headerEnd + 4 + contentLength)
+            return;
+
+        const QByteArray body = buffer.mid(headerEnd + 4, contentLength);
+        buffer.remove(0, headerEnd + 4 + contentLength);
+
+        const QUrl url(BaseUrl() + QString::fromUtf8(requestLine[1]));
+        const bool isAuthorization = url.path() == "/authorize" || url.path() == "/api/token";
+        requestCount++;
+
+        HttpResponse response;
+        if(config.rateLimitEvery > 0 && !isAuthorization && requestCount % quint64(config.rateLimitEvery) == 0)
+        {
+            response = ErrorResponse(429, "API rate limit exceeded");
+            response.headers.append(qMakePair(QByteArray("Retry-After"), QByteArray::number(config.retryAfterSeconds)));
+        }
+        else
+            response = Route(requestLine[0], url, body);
+
+        const int delay = config.latencyMs + (config.jitterMs > 0 ? int(random.bounded(config.jitterMs + 1)) : 0);
+        if(delay > 0)
+            QTimer::singleShot(delay, socket, [=](){ this->SendResponse(socket, response, keepAlive); });
+        else
+            SendResponse(socket, response, keepAlive);
+
+        if(!keepAlive)
+            return;
+    }
+}
+
+void MockSpotifyServer::SendResponse(QTcpSocket *socket, const HttpResponse &response, bool keepAlive)
+{
+    QByteArray data = "HTTP/1.1 " + QByteArray::number(response.status) + " " + ReasonPhrase(response.status) + "\r\n";
+
+    if(!response.body.isEmpty())
+        data += "Content-Type: application/json\r\n";
+    data += "Content-Length: " + QByteArray::number(response.body.size()) + "\r\n";
+    data += keepAlive ? "Connection: keep-alive\r\n" : "Connection: close\r\n";
+
+    for(const auto &header : response.headers)
+        data += header.first + ": " + header.second + "\r\n";
+
+    data += "\r\n";
+    data += response.body;
+
+    socket->write(data);
+
+    if(!keepAlive)
+        socket->disconnectFromHost();
+}
+
+MockSpotifyServer::HttpResponse MockSpotifyServer::JsonResponse(int status, const QJsonObject &obj)
+{
+    HttpResponse response;
+    response.status = status;
+    response.body = QJsonDocument(obj).toJson(QJsonDocument::Compact);
+    return response;
+}
+
+MockSpotifyServer::HttpResponse MockSpotifyServer::ErrorResponse(int status, const QString &message)
+{
+    return JsonResponse(status, QJsonObject({{"error", QJsonObject({{"status", status}, {"message", message}})}}));
+}
+
+/**
+Method to select the endpoint that answers a request.
+@param method HTTP method of the request.
+@param url full address of the request.
+@param body data sent with the request.
+@return the response of the endpoint, 404 if the endpoint is not implemented.
+*/
+MockSpotifyServer::HttpResponse MockSpotifyServer::Route(const QByteArray &method, const QUrl &url, const QByteArray &body)
+{
+    const QString path = url.path();
+    const QStringList parts = path.split('/', Qt::SkipEmptyParts);
+
+    if(method == "GET" && path == "/authorize")
+        return Authorize(url);
+
+    if(method == "POST" && path == "/api/token")
+        return Token(body);
+
+    if(method == "GET" && path == "/v1/me")
+        return JsonResponse(200, QJsonObject({{"id", "mockuser"},
+                                              {"display_name", "Mock User"},
+                                              {"uri", "spotify:user:mockuser"}}));
+
+    if(method == "PUT" && path == "/v1/me/player/play")
+    {
+        HttpResponse response;
+        response.status = 204;
+        return response;
+    }
+
+    if(method == "GET" && path == "/v1/search")
+        return Search(url);
+
+    if(method == "GET" && path == "/v1/me/playlists")
+        return Playlists(url);
+
+    if(parts.size() == 4 && parts[0] == "v1" && parts[1] == "users" && parts[3] == "playlists")
+    {
+        if(method == "GET")
+            return Playlists(url);
+        if(method == "POST")
+            return CreatePlaylist(body);
+    }
+
+    if(parts.size() == 4 && parts[0] == "v1" && parts[1] == "playlists" && parts[3] == "tracks")
+    {
+        if(method == "GET")
+            return PlaylistTracks(url, parts[2]);
+        if(method == "POST")
+            return AddTracks(url, parts[2], body);
+        if(method == "DELETE")
+            return RemoveTracks(parts[2], body);
+        if(method == "PUT")
+            return ReorderTracks(parts[2], body);
+    }
+
+    if(method == "GET" && path == "/v1/artists")
+        return Artists(url);
+
+    if(method == "GET" && path == "/v1/tracks")
+        return Tracks(url);
+
+    if(method == "GET" && path == "/v1/audio-features")
+        return AudioFeatures(url);
+
+    if(method == "GET" && parts.size() == 4 && parts[0] == "v1" && parts[1] == "artists" && parts[3] == "top-tracks")
+        return TopTracks(parts[2]);
+
+    return ErrorResponse(404, "Service not found");
+}
+
+/**
+Method to create the id of a synthetic object. The first char identifies the kind of object
+('p' playlist, 't' track, 'a' artist, 'c' created playlist) followed by its index, resulting in a
+22 chars id like spotify ids.
+*/
+QString MockSpotifyServer::MockId(char kind, int index) const
+{
+    return QChar(kind) + QString("%1").arg(index, 21, 10, QChar('0'));
+}
+
+int MockSpotifyServer::IndexFromId(const QString &id) const
+{
+    bool ok = false;
+    const int index = id.mid(1).toInt(&ok);
+    return ok ? index : -1;
+}
+
+int MockSpotifyServer::PlaylistTrack(int playlist, int position) const
+{
+    return int(Mix(config.seed ^ quint32(playlist), quint32(position)) % quint32(config.trackPool));
+}
+
+int MockSpotifyServer::TrackArtist(int track, int position) const
+{
+    return int(Mix(config.seed + quint32(track), quint32(position) + 7919u) % quint32(config.artistPool));
+}
+
+QJsonObject MockSpotifyServer::ArtistJson(int artist) const
+{
+    const QString id = MockId('a', artist);
+
+    return QJsonObject({{"name", QString("Mock Artist %1").arg(artist)},
+                        {"id", id},
+                        {"href", BaseUrl() + "/v1/artists/" + id},
+                        {"uri", "spotify:artist:" + id},
+                        {"type", "artist"}});
+}
+
+QJsonObject MockSpotifyServer::TrackJson(int track) const
+{
+    const QString id = MockId('t', track);
+
+    QJsonArray artists;
+    for(int k = 0; k < config.artistsPerTrack; k++)
+        artists.append(ArtistJson(TrackArtist(track, k)));
+
+    QJsonObject obj({{"name", QString("Mock Track %1").arg(track)},
+                     {"id", id},
+                     {"href", BaseUrl() + "/v1/tracks/" + id},
+                     {"uri", "spotify:track:" + id},
+                     {"duration_ms", 120000 + int((qint64(track) * 7919) % 180000)},
+                     {"popularity", track % 100},
+                     {"type", "track"},
+                     {"artists", artists}});
+
+    //Extra data to control the size of payloads
+    if(config.payloadPadding > 0)
+        obj.insert("padding", QString(config.payloadPadding, QChar('x')));
+
+    return obj;
+}
+
+QJsonObject MockSpotifyServer::PlaylistJson(int playlist) const
+{
+    const QString id = MockId('p', playlist);
+    const QString href = BaseUrl() + "/v1/playlists/" + id;
+
+    return QJsonObject({{"name", QString("Mock Playlist %1").arg(playlist)},
+                        {"id", id},
+                        {"href", href},
+                        {"uri", "spotify:playlist:" + id},
+                        {"public", false},
+                        {"owner", QJsonObject({{"id", "mockuser"}})},
+                        {"tracks", QJsonObject({{"href", href + "/tracks"}, {"total", config.tracksPerPlaylist}})}});
+}
+
+/**
+Method to create a paging object like the ones returned by spotify web api.
+@param items items of the page.
+@param url address of the request, used to create the next page address.
+@param offset position of the first item.
+@param limit maximum number of items in the page.
+@param total number of items in all pages.
+*/
+QJsonObject MockSpotifyServer::Page(const QJsonArray &items, const QUrl &url, int offset, int limit, int total) const
+{
+    QJsonValue next = QJsonValue::Null;
+    if(offset + limit < total)
+    {
+        QUrl nextUrl(url);
+        QUrlQuery query(nextUrl);
+        query.removeAllQueryItems("offset");
+        query.removeAllQueryItems("limit");
+        query.addQueryItem("offset", QString::number(offset + limit));
+        query.addQueryItem("limit", QString::number(limit));
+        nextUrl.setQuery(query);
+        next = nextUrl.toString();
+    }
+
+    return QJsonObject({{"href", url.toString()},
+                        {"items", items},
+                        {"limit", limit},
+                        {"offset", offset},
+                        {"total", total},
+                        {"next", next},
+                        {"previous", QJsonValue::Null}});
+}
+
+/**
+Endpoint of the authorization page: grants access immediately, redirecting to the client
+redirect uri with an authorization code.
+*/
+MockSpotifyServer::HttpResponse MockSpotifyServer::Authorize(const QUrl &url)
+{
+    const QUrlQuery query(url);
+
+    QUrl redirect(query.queryItemValue("redirect_uri", QUrl::FullyDecoded));
+    if(!redirect.isValid() || redirect.isEmpty())
+        return ErrorResponse(400, "Missing redirect_uri");
+
+    QUrlQuery redirectQuery;
+    redirectQuery.addQueryItem("code", "mockauthorizationcode");
+    redirectQuery.addQueryItem("state", query.queryItemValue("state"));
+    redirect.setQuery(redirectQuery);
+
+    HttpResponse response;
+    response.status = 302;
+    response.headers.append(qMakePair(QByteArray("Location"), redirect.toEncoded()));
+    return response;
+}
+
+/**
+Endpoint of access token requests, for authorization codes and refresh tokens.
+*/
+MockSpotifyServer::HttpResponse MockSpotifyServer::Token(const QByteArray &body)
+{
+    Q_UNUSED(body);
+    tokenCount++;
+
+    return JsonResponse(200, QJsonObject({{"access_token", QString("mockaccesstoken%1").arg(tokenCount)},
+                                          {"token_type", "Bearer"},
+                                          {"expires_in", config.tokenExpiry},
+                                          {"refresh_token", "mockrefreshtoken"},
+                                          {"scope", "user-read-private playlist-read-private playlist-modify-private"}}));
+}
+
+MockSpotifyServer::HttpResponse MockSpotifyServer::Playlists(const QUrl &url)
+{
+    const QUrlQuery query(url);
+    const int offset = qMax(0, query.queryItemValue("offset").toInt());
+    const int limit = query.hasQueryItem("limit") ? qBound(1, query.queryItemValue("limit").toInt(), 50) : 20;
+    const int total = config.playlists + createdPlaylistsIds.size();
+
+    QJsonArray items;
+    for(int i = offset; i < qMin(offset + limit, total); i++)
+    {
+        if(i < config.playlists)
+            items.append(PlaylistJson(i));
+        else
+            items.append(createdPlaylists.value(createdPlaylistsIds[i - config.playlists]));
+    }
+
+    return JsonResponse(200, Page(items, url, offset, limit, total));
+}
+
+MockSpotifyServer::HttpResponse MockSpotifyServer::PlaylistTracks(const QUrl &url, const QString &playlistId)
+{
+    const QUrlQuery query(url);
+    const int offset = qMax(0, query.queryItemValue("offset").toInt());
+    const int requestLimit = query.hasQueryItem("limit") ? query.queryItemValue("limit").toInt() : 100;
+    const int limit = qBound(1, requestLimit, config.pageSize);
+
+    QList<int> tracks;
+    if(createdPlaylists.contains(playlistId) || editedPlaylistsTracks.contains(playlistId))
+    {
+        const QStringList uris = createdPlaylists.contains(playlistId) ? createdPlaylistsTracks.value(playlistId)
+                                                                       : editedPlaylistsTracks.value(playlistId);
+        for(const QString &uri : uris)
+            tracks.append(IndexFromId(uri.section(':', 2)));
+    }
+    else
+    {
+        const int playlist = IndexFromId(playlistId);
+        if(!playlistId.startsWith('p') || playlist < 0 || playlist >= config.playlists)
+            return ErrorResponse(404, "Non existing id");
+
+        for(int i = 0; i < config.tracksPerPlaylist; i++)
+            tracks.append(PlaylistTrack(playlist, i));
+    }
+
+    QJsonArray items;
+    for(int i = offset; i < qMin(offset + limit, tracks.size()); i++)
+        items.append(QJsonObject({{"added_at", "2020-01-01T00:00:00Z"}, {"track", TrackJson(tracks[i])}}));
+
+    return JsonResponse(200, Page(items, url, offset, limit, tracks.size()));
+}
+
+/**
+Endpoint of search requests. Results are derived from the query text, so the same query
+always returns the same tracks or artists.
+*/
+MockSpotifyServer::HttpResponse MockSpotifyServer::Search(const QUrl &url)
+{
+    const QUrlQuery query(url);
+    const QString text = query.queryItemValue("q", QUrl::FullyDecoded);
+    const QString type = query.queryItemValue("type");
+    const int offset = qMax(0, query.queryItemValue("offset").toInt());
+    const int limit = query.hasQueryItem("limit") ? qBound(1, query.queryItemValue("limit").toInt(), 50) : 20;
+    const int total = 1000;
+    const quint32 start = Mix(config.seed, qHash(text));
+
+    QJsonArray items;
+    if(type == "track")
+    {
+        for(int i = offset; i < offset + limit; i++)
+            items.append(TrackJson(int((start + quint32(i)) % quint32(config.trackPool))));
+
+        return JsonResponse(200, QJsonObject({{"tracks", Page(items, url, offset, limit, total)}}));
+    }
+    if(type == "artist")
+    {
+        for(int i = offset; i < offset + limit; i++)
+            items.append(ArtistJson(int((start + quint32(i)) % quint32(config.artistPool))));
+
+        return JsonResponse(200, QJsonObject({{"artists", Page(items, url, offset, limit, total)}}));
+    }
+
+    return ErrorResponse(400, "Unsupported search type");
+}
+
+/**
+Endpoint of the data of several artists, given by the ids parameter (up to 50). Unknown ids are
+returned as null, as the server does.
+*/
+MockSpotifyServer::HttpResponse MockSpotifyServer::Artists(const QUrl &url)
+{
+    const QStringList ids = QUrlQuery(url).queryItemValue("ids").split(',', Qt::SkipEmptyParts);
+    if(ids.isEmpty() || ids.size() > 50)
+        return ErrorResponse(400, "Invalid ids");
+
+    QJsonArray artists;
+    for(const QString &id : ids)
+    {
+        const int artist = IndexFromId(id);
+        if(!id.startsWith('a') || artist < 0 || artist >= config.artistPool)
+        {
+            artists.append(QJsonValue());
+            continue;
+        }
+
+        QJsonObject obj = ArtistJson(artist);
+        obj.insert("popularity", artist % 100);
+        obj.insert("genres", QJsonArray({QString("mock genre %1").arg(artist % 20)}));
+        artists.append(obj);
+    }
+
+    return JsonResponse(200, QJsonObject({{"artists", artists}}));
+}
+
+/**
+Endpoint of the data of several tracks, given by the ids parameter (up to 50). Unknown ids are
+returned as null, as the server does.
+*/
+MockSpotifyServer::HttpResponse MockSpotifyServer::Tracks(const QUrl &url)
+{
+    const QStringList ids = QUrlQuery(url).queryItemValue("ids").split(',', Qt::SkipEmptyParts);
+    if(ids.isEmpty() || ids.size() > 50)
+        return ErrorResponse(400, "Invalid ids");
+
+    QJsonArray tracks;
+    for(const QString &id : ids)
+    {
+        const int track = IndexFromId(id);
+        if(!id.startsWith('t') || track < 0 || track >= config.trackPool)
+            tracks.append(QJsonValue());
+        else
+            tracks.append(TrackJson(track));
+    }
+
+    return JsonResponse(200, QJsonObject({{"tracks", tracks}}));
+}
+
+/**
+Endpoint of the audio features of several tracks, given by the ids parameter (up to 100). The features are
+derived from the track index, so they are the same in every run. Unknown ids are returned as null.
+*/
+MockSpotifyServer::HttpResponse MockSpotifyServer::AudioFeatures(const QUrl &url)
+{
+    const QStringList ids = QUrlQuery(url).queryItemValue("ids").split(',', Qt::SkipEmptyParts);
+    if(ids.isEmpty() || ids.size() > 100)
+        return ErrorResponse(400, "Invalid ids");
+
+    QJsonArray features;
+    for(const QString &id : ids)
+    {
+        const int track = IndexFromId(id);
+        if(!id.startsWith('t') || track < 0 || track >= config.trackPool)
+        {
+            features.append(QJsonValue());
+            continue;
+        }
+
+        features.append(QJsonObject({{"id", id},
+                                     {"danceability", (track * 37 % 101) / 100.0},
+                                     {"energy", (track * 53 % 101) / 100.0},
+                                     {"loudness", -60.0 + (track * 29 % 601) / 10.0},
+                                     {"speechiness", (track * 11 % 101) / 100.0},
+                                     {"acousticness", (track * 71 % 101) / 100.0},
+                                     {"instrumentalness", (track * 17 % 101) / 100.0},
+                                     {"liveness", (track * 43 % 101) / 100.0},
+                                     {"valence", (track * 61 % 101) / 100.0},
+                                     {"tempo", 60.0 + (track * 7 % 1401) / 10.0},
+                                     {"type", "audio_features"},
+                                     {"uri", "spotify:track:" + id}}));
+    }
+
+    return JsonResponse(200, QJsonObject({{"audio_features", features}}));
+}
+
+MockSpotifyServer::HttpResponse MockSpotifyServer::TopTracks(const QString &artistId)
+{
+    const int artist = IndexFromId(artistId);
+    if(!artistId.startsWith('a') || artist < 0 || artist >= config.artistPool)
+        return ErrorResponse(404, "Non existing id");
+
+    QJsonArray tracks;
+    for(int i = 0; i < 10; i++)
+        tracks.append(TrackJson(int(Mix(quint32(artist), quint32(i)) % quint32(config.trackPool))));
+
+    return JsonResponse(200, QJsonObject({{"tracks", tracks}}));
+}
+
+MockSpotifyServer::HttpResponse MockSpotifyServer::CreatePlaylist(const QByteArray &body)
+{
+    const QJsonObject request = QJsonDocument::fromJson(body).object();
+    if(!request.contains("name"))
+        return ErrorResponse(400, "Missing required field: name");
+
+    const QString id = MockId('c', createdPlaylistsIds.size());
+    const QString href = BaseUrl() + "/v1/playlists/" + id;
+
+    QJsonObject playlist({{"name", request.value("name")},
+                          {"description", request.value("description")},
+                          {"public", request.value("public")},
+                          {"id", id},
+                          {"href", href},
+                          {"uri", "spotify:playlist:" + id},
+                          {"owner", QJsonObject({{"id", "mockuser"}})},
+                          {"tracks", QJsonObject({{"href", href + "/tracks"}, {"total", 0}})}});
+
+    createdPlaylistsIds.append(id);
+    createdPlaylists.insert(id, playlist);
+
+    return JsonResponse(201, playlist);
+}
+
+/**
+Method to get the tracks uris of a playlist that can be changed by clients. The tracks of a synthetic playlist
+are copied the first time it is changed.
+@param playlistId id of the playlist.
+@return the tracks uris, or nullptr if the playlist doesn't exist.
+*/
+QStringList *MockSpotifyServer::EditableTracks(const QString &playlistId)
+{
+    if(createdPlaylists.contains(playlistId))
+        return &createdPlaylistsTracks[playlistId];
+
+    const int playlist = IndexFromId(playlistId);
+    if(!playlistId.startsWith('p') || playlist < 0 || playlist >= config.playlists)
+        return nullptr;
+
+    if(!editedPlaylistsTracks.contains(playlistId))
+    {
+        QStringList uris;
+        for(int i = 0; i < config.tracksPerPlaylist; i++)
+            uris.append("spotify:track:" + MockId('t', PlaylistTrack(playlist, i)));
+        editedPlaylistsTracks.insert(playlistId, uris);
+    }
+
+    return &editedPlaylistsTracks[playlistId];
+}
+
+/**
+Method to update the tracks total of a created playlist after its tracks change.
+*/
+void MockSpotifyServer::TracksChanged(const QString &playlistId)
+{
+    if(!createdPlaylists.contains(playlistId))
+        return;
+
+    QJsonObject playlist = createdPlaylists.value(playlistId);
+    playlist.insert("tracks", QJsonObject({{"href", playlist.value("href").toString() + "/tracks"},
+                                           {"total", createdPlaylistsTracks[playlistId].size()}}));
+    createdPlaylists.insert(playlistId, playlist);
+}
+
+/**
+Endpoint to add tracks to a playlist. Uris are read from the query (uris=a,b) or from the
+Json body ({"uris": [...], "position": n}); tracks are appended when there is no position.
+*/
+MockSpotifyServer::HttpResponse MockSpotifyServer::AddTracks(const QUrl &url, const QString &playlistId, const QByteArray &body)
+{
+    const QJsonObject bodyObj = QJsonDocument::fromJson(body).object();
+
+    QStringList uris = QUrlQuery(url).queryItemValue("uris", QUrl::FullyDecoded).split(',', Qt::SkipEmptyParts);
+    for(const auto uri : bodyObj.value("uris").toArray())
+        uris.append(uri.toString());
+
+    if(uris.isEmpty())
+        return ErrorResponse(400, "No uris provided");
+
+    QStringList *tracks = EditableTracks(playlistId);
+    if(!tracks)
+        return ErrorResponse(404, "Non existing id");
+
+    const int position = bodyObj.value("position").toInt(tracks->size());
+    if(position < 0 || position > tracks->size())
+        return ErrorResponse(400, "Index out of bounds");
+
+    for(int i = 0; i < uris.size(); i++)
+        tracks->insert(position + i, uris[i]);
+    TracksChanged(playlistId);
+
+    return JsonResponse(201, QJsonObject({{"snapshot_id", QString("mocksnapshot%1").arg(requestCount)}}));
+}
+
+/**
+Endpoint to remove tracks from a playlist. The Json body lists the tracks removed ({"tracks": [{"uri": u,
+"positions": [n]}]}): tracks with positions are removed only at those positions, otherwise all occurrences
+of the uri are removed.
+*/
+MockSpotifyServer::HttpResponse MockSpotifyServer::RemoveTracks(const QString &playlistId, const QByteArray &body)
+{
+    QStringList *tracks = EditableTracks(playlistId);
+    if(!tracks)
+        return ErrorResponse(404, "Non existing id");
+
+    const QJsonArray removed = QJsonDocument::fromJson(body).object().value("tracks").toArray();
+    if(removed.isEmpty())
+        return ErrorResponse(400, "No tracks provided");
+
+    QSet<int> positions;
+    for(const auto value : removed)
+    {
+        const QJsonObject track = value.toObject();
+        const QString uri = track.value("uri").toString();
+
+        if(!track.contains("positions"))
+        {
+            for(int i = 0; i < tracks->size(); i++)
+                if(tracks->at(i) == uri)
+                    positions.insert(i);
+            continue;
+        }
+
+        for(const auto position : track.value("positions").toArray())
+        {
+            const int i = position.toInt(-1);
+            if(i < 0 || i >= tracks->size() || tracks->at(i) != uri)
+                return ErrorResponse(400, "Could not remove tracks, please check parameters");
+            positions.insert(i);
+        }
+    }
+
+    QList<int> sorted = positions.values();
+    std::sort(sorted.begin(), sorted.end());
+    for(int i = sorted.size() - 1; i >= 0; i--)
+        tracks->removeAt(sorted[i]);
+    TracksChanged(playlistId);
+
+    return JsonResponse(200, QJsonObject({{"snapshot_id", QString("mocksnapshot%1").arg(requestCount)}}));
+}
+
+/**
+Endpoint to reorder or replace the tracks of a playlist. A Json body with uris replaces all tracks, otherwise
+the range of range_length tracks from range_start is moved before the track at insert_before.
+*/
+MockSpotifyServer::HttpResponse MockSpotifyServer::ReorderTracks(const QString &playlistId, const QByteArray &body)
+{
+    QStringList *tracks = EditableTracks(playlistId);
+    if(!tracks)
+        return ErrorResponse(404, "Non existing id");
+
+    const QJsonObject bodyObj = QJsonDocument::fromJson(body).object();
+
+    if(bodyObj.contains("uris"))
+    {
+        tracks->clear();
+        for(const auto uri : bodyObj.value("uris").toArray())
+            tracks->append(uri.toString());
+    }
+    else
+    {
+        const int start = bodyObj.value("range_start").toInt(-1);
+        const int length = bodyObj.value("range_length").toInt(1);
+        const int before = bodyObj.value("insert_before").toInt(-1);
+
+        if(start < 0 || length < 1 || start + length > tracks->size() || before < 0 || before > tracks->size())
+            return ErrorResponse(400, "Index out of bounds");
+
+        const QStringList range = tracks->mid(start, length);
+        tracks->erase(tracks->begin() + start, tracks->begin() + start + length);
+
+        const int insertAt = before > start ? qMax(start, before - length) : before;
+        for(int i = 0; i < range.size(); i++)
+            tracks->insert(insertAt + i, range[i]);
+    }
+    TracksChanged(playlistId);
+
+    return JsonResponse(200, QJsonObject({{"snapshot_id", QString("mocksnapshot%1").arg(requestCount)}}));
+}
@@ -0,0 +1,116 @@
+#ifndef MOCKSPOTIFYSERVER_H
+#define MOCKSPOTIFYSERVER_H
+
+#include <QObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QHash>
+#include <QUrl>
+#include <QRandomGenerator>
+
+/**
+ * Parameters of the synthetic library served and of the faults injected by MockSpotifyServer.
+ */
+struct MockServerConfig
+{
+    int playlists = 20;
+    int tracksPerPlaylist = 100;
+    int artistsPerTrack = 2;
+    int trackPool = 5000;
+    int artistPool = 500;
+    int pageSize = 100;
+    int latencyMs = 0;
+    int jitterMs = 0;
+    int rateLimitEvery = 0;
+    int retryAfterSeconds = 1;
+    int payloadPadding = 0;
+    int tokenExpiry = 3600;
+    quint32 seed = 1;
+};
+
+/**
+ * Implementation of a local stub of the Spotify Web API and accounts servers for load and latency tests.
+ *
+ * The server answers HTTP/1.1 requests (with keep-alive) with a deterministic synthetic library generated
+ * from MockServerConfig: user profile, paginated playlists and playlist tracks, search, artist top tracks,
+ * playlist creation, tracks insertion, removal and reordering, playback and the OAuth2 authorization code flow.
+ * Playlists changed by clients keep their tracks, so a later sync returns the changes.
+ * Latency, 429 (Too Many Requests) replies and payload size can be injected to reproduce server conditions.
+ */
+class MockSpotifyServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    MockSpotifyServer(const MockServerConfig &serverConfig, QObject *parent = nullptr);
+
+    bool Listen(const QHostAddress &address, quint16 port);
+    QString BaseUrl() const;
+    quint64 RequestCount() const;
+
+private slots:
+    void NewConnection();
+    void ReadRequest();
+
+private:
+    struct HttpResponse
+    {
+        int status;
+        QByteArray body;
+        QList<QPair<QByteArray, QByteArray>> headers;
+    };
+
+    HttpResponse Route(const QByteArray &method, const QUrl &url, const QByteArray &body);
+    void SendResponse(QTcpSocket *socket, const HttpResponse &response, bool keepAlive);
+    HttpResponse JsonResponse(int status, const QJsonObject &obj);
+    HttpResponse ErrorResponse(int status, const QString &message);
+
+    //Synthetic library data
+    QString MockId(char kind, int index) const;
+    int IndexFromId(const QString &id) const;
+    int PlaylistTrack(int playlist, int position) const;
+    int TrackArtist(int track, int position) const;
+    QJsonObject ArtistJson(int artist) const;
+    QJsonObject TrackJson(int track) const;
+    QJsonObject PlaylistJson(int playlist) const;
+    QJsonObject Page(const QJsonArray &items, const QUrl &url, int offset, int limit, int total) const;
+
+    //Endpoints
+    HttpResponse Authorize(const QUrl &url);
+    HttpResponse Token(const QByteArray &body);
+    HttpResponse Playlists(const QUrl &url);
+    HttpResponse PlaylistTracks(const QUrl &url, const QString &playlistId);
+    HttpResponse Search(const QUrl &url);
+    HttpResponse Artists(const QUrl &url);
+    HttpResponse Tracks(const QUrl &url);
+    HttpResponse AudioFeatures(const QUrl &url);
+    HttpResponse TopTracks(const QString &artistId);
+    HttpResponse CreatePlaylist(const QByteArray &body);
+    HttpResponse AddTracks(const QUrl &url, const QString &playlistId, const QByteArray &body);
+    HttpResponse RemoveTracks(const QString &playlistId, const QByteArray &body);
+    HttpResponse ReorderTracks(const QString &playlistId, const QByteArray &body);
+
+    QStringList *EditableTracks(const QString &playlistId);
+    void TracksChanged(const QString &playlistId);
+
+    QTcpServer server;
+    MockServerConfig config;
+    QRandomGenerator random;
+    quint64 requestCount;
+    int tokenCount;
+
+    //Data received from each connection that is not yet processed
+    QHash<QTcpSocket*, QByteArray> buffers;
+
+    //Playlists created by clients, kept in creation order with the tracks uris added to them
+    QStringList createdPlaylistsIds;
+    QHash<QString, QJsonObject> createdPlaylists;
+    QHash<QString, QStringList> createdPlaylistsTracks;
+
+    //Tracks uris of the synthetic playlists changed by clients
+    QHash<QString, QStringList> editedPlaylistsTracks;
+};
+
+#endif // MOCKSPOTIFYSERVER_H
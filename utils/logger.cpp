@@ -0,0 +1,316 @@
+#include "logger.h"
+#include "mpscqueue.h"
+
+#include <QDateTime>
+#include <QThread>
+#include <QJsonObject>
+#include <QJsonDocument>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <cstdio>
+
+/**
+ * Log entry, also the node of the intrusive lock-free queue between the callers and the writer thread.
+ */
+struct LogEntry
+{
+    std::atomic<LogEntry*> next;
+    LogLevel level;
+    const char *category;
+    QString message;
+    qint64 timeMs;
+    quint64 threadId;
+};
+
+//Queue with multiple producers (the callers) and a single consumer (the writer thread)
+typedef MpscQueue<LogEntry> LogQueue;
+
+std::atomic<int> Logger::minimumLevel(int(LogLevel::Off));
+
+static LogQueue queue;
+static std::thread writerThread;
+static std::atomic<bool> writerRunning(false);
+static std::atomic<bool> writerWaiting(false);
+static std::mutex writerMutex;
+static std::condition_variable writerCondition;
+static FILE *logOutput = nullptr;
+
+static QMutex sinkMutex;
+static LogUiSink *uiSink = nullptr;
+static LogLevel uiLevel = LogLevel::Warning;
+
+static QtMessageHandler previousMessageHandler = nullptr;
+
+static const char *LevelName(LogLevel level)
+{
+    switch(level)
+    {
+    case LogLevel::Debug: return "debug";
+    case LogLevel::Info: return "info";
+    case LogLevel::Warning: return "warning";
+    case LogLevel::Error: return "error";
+    default: return "off";
+    }
+}
+
+/**
+Function to route Qt messages (qDebug, qInfo, qWarning, qCritical) to the logger. Fatal messages are
+given to the previous handler, which aborts the application.
+*/
+static void QtMessageToLogger(QtMsgType type, const QMessageLogContext &context, const QString &message)
+{
+    if(type == QtFatalMsg)
+    {
+        Logger::Stop();
+        if(previousMessageHandler)
+            previousMessageHandler(type, context, message);
+        return;
+    }
+
+    LogLevel level = LogLevel::Debug;
+    if(type == QtInfoMsg)
+        level = LogLevel::Info;
+    else if(type == QtWarningMsg)
+        level = LogLevel::Warning;
+    else if(type == QtCriticalMsg)
+        level = LogLevel::Error;
+
+    LOG_AT(level, "qt", message);
+}
+
+/**
+Function to format an entry as a Json line, write it to the output and pass it to the interface sink.
+*/
+static void WriteEntry(const LogEntry &entry)
+{
+    QJsonObject line({{"time", QDateTime::fromMSecsSinceEpoch(entry.timeMs).toString(Qt::ISODateWithMs)},
+                      {"level", LevelName(entry.level)},
+                      {"category", entry.category},
+                      {"thread", double(entry.threadId)},
+                      {"message", entry.message}});
+
+    const QByteArray text = QJsonDocument(line).toJson(QJsonDocument::Compact);
+    fwrite(text.constData(), 1, size_t(text.size()), logOutput);
+    fputc('\n', logOutput);
+
+    QMutexLocker locker(&sinkMutex);
+    if(uiSink && entry.level >= uiLevel)
+        uiSink->Add(QString("[%1] %2: %3").arg(LevelName(entry.level), entry.category, entry.message));
+}
+
+/**
+Function of the writer thread: writes the queued entries in batches and sleeps while the queue is empty.
+It returns after the logger is stopped and the queue is empty.
+*/
+static void WriterLoop()
+{
+    while(true)
+    {
+        const bool running = writerRunning.load(std::memory_order_acquire);
+
+        int written = 0;
+        while(LogEntry *entry = queue.Pop())
+        {
+            WriteEntry(*entry);
+            delete entry;
+            written++;
+        }
+
+        if(written > 0)
+            fflush(logOutput);
+        else if(!running)
+            return;
+        else
+        {
+            std::unique_lock<std::mutex> lock(writerMutex);
+            writerWaiting.store(true);
+            writerCondition.wait_for(lock, std::chrono::milliseconds(50));
+            writerWaiting.store(false);
+        }
+    }
+}
+
+void Logger::SetLevel(LogLevel level)
+{
+    minimumLevel.store(int(level), std::memory_order_relaxed);
+}
+
+/**
+Method to get the level of a name (debug, info, warning, error, off).
+@param name level name, case insensitive.
+@param defaultLevel level returned if the name is not valid.
+*/
+LogLevel Logger::LevelFromName(const QString &name, LogLevel defaultLevel)
+{
+    const QString levelName = name.toLower();
+
+    for(int level = int(LogLevel::Debug); level <= int(LogLevel::Off); level++)
+        if(levelName == LevelName(LogLevel(level)))
+            return LogLevel(level);
+
+    return defaultLevel;
+}
+
+/**
+Method to start the logger with the level and file set by the environment variables
+SPOTIFYAPP_LOG_LEVEL and SPOTIFYAPP_LOG_FILE.
+@return true if the logger is running.
+*/
+bool Logger::Start()
+{
+    const LogLevel level = LevelFromName(qEnvironmentVariable("SPOTIFYAPP_LOG_LEVEL"), LogLevel::Info);
+    return Start(level, qEnvironmentVariable("SPOTIFYAPP_LOG_FILE"));
+}
+
+/**
+Method to start the writer thread of the logger.
+@param level minimum level of the entries written.
+@param fileName file where entries are appended, empty to write to the error output.
+@return true if the logger is running.
+*/
+bool Logger::Start(LogLevel level, const QString &fileName)
+{
+    if(writerRunning.load())
+        Stop();
+
+    logOutput = stderr;
+    if(!fileName.isEmpty())
+    {
+        FILE *file = fopen(fileName.toLocal8Bit().constData(), "a");
+        if(file)
+            logOutput = file;
+    }
+
+    writerRunning.store(true, std::memory_order_release);
+    writerThread = std::thread(WriterLoop);
+
+    previousMessageHandler = qInstallMessageHandler(QtMessageToLogger);
+    SetLevel(level);
+
+    return logOutput != stderr || fileName.isEmpty();
+}
+
+/**
+Method to stop the logger. The entries already queued are written before it returns.
+*/
+void Logger::Stop()
+{
+    if(!writerRunning.exchange(false))
+        return;
+
+    SetLevel(LogLevel::Off);
+    qInstallMessageHandler(previousMessageHandler);
+
+    writerCondition.notify_one();
+    if(writerThread.joinable() && writerThread.get_id() != std::this_thread::get_id())
+        writerThread.join();
+
+    if(logOutput && logOutput != stderr)
+        fclose(logOutput);
+    logOutput = nullptr;
+}
+
+/**
+Method to queue a log entry. Prefer the LOG_* macros, which skip building the message when the
+level is disabled.
+@param level entry level.
+@param category part of the application that logs the entry (e.g. "api", "model"), must be a string literal.
+@param message text of the entry.
+*/
+void Logger::Write(LogLevel level, const char *category, const QString &message)
+{
+    if(!IsEnabled(level))
+        return;
+
+    LogEntry *entry = new LogEntry;
+    entry->level = level;
+    entry->category = category;
+    entry->message = message;
+    entry->timeMs = QDateTime::currentMSecsSinceEpoch();
+    entry->threadId = quint64(quintptr(QThread::currentThreadId()));
+
+    queue.Push(entry);
+
+    if(writerWaiting.load(std::memory_order_relaxed))
+        writerCondition.notify_one();
+}
+
+/**
+Method to set the object that receives the log entries shown in the interface.
+@param sink interface sink, nullptr to stop showing entries.
+@param level minimum level of the entries shown.
+*/
+void Logger::SetUiSink(LogUiSink *sink, LogLevel level)
+{
+    QMutexLocker locker(&sinkMutex);
+    uiSink = sink;
+    uiLevel = level;
+}
+
+/**
+@param intervalMs time between two emissions of the buffered lines.
+@param maxLinesPerSecond maximum number of lines shown in each second.
+*/
+LogUiSink::LogUiSink(int intervalMs, int maxLinesPerSecond, QObject *parent)
+    : QObject(parent),
+      maxLines(maxLinesPerSecond),
+      linesInSecond(0),
+      droppedLines(0),
+      secondStartMs(0)
+{
+    connect(&flushTimer, &QTimer::timeout, this, &LogUiSink::Flush);
+    flushTimer.start(intervalMs);
+}
+
+LogUiSink::~LogUiSink()
+{
+    QMutexLocker locker(&sinkMutex);
+    if(uiSink == this)
+        uiSink = nullptr;
+}
+
+/**
+Method to buffer a line to be shown, called from the logger thread.
+@param line formatted log entry.
+*/
+void LogUiSink::Add(const QString &line)
+{
+    const qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
+
+    QMutexLocker locker(&mutex);
+    if(nowMs - secondStartMs >= 1000)
+    {
+        secondStartMs = nowMs;
+        linesInSecond = 0;
+    }
+
+    if(linesInSecond < maxLines)
+    {
+        lines.append(line);
+        linesInSecond++;
+    }
+    else
+        droppedLines++;
+}
+
+/**
+SLOT Method called by the flush timer to emit all buffered lines as one text block.
+*/
+void LogUiSink::Flush()
+{
+    QStringList text;
+    {
+        QMutexLocker locker(&mutex);
+        text.swap(lines);
+
+        if(droppedLines > 0)
+        {
+            text.append(QString("... %1 log messages not shown").arg(droppedLines));
+            droppedLines = 0;
+        }
+    }
+
+    if(!text.isEmpty())
+        emit LinesReadySignal(text.join('\n'), false);
+}
@@ -0,0 +1,91 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QMutex>
+#include <QTimer>
+#include <atomic>
+
+enum class LogLevel : int
+{
+    Debug = 0,
+    Info = 1,
+    Warning = 2,
+    Error = 3,
+    Off = 4
+};
+
+class LogUiSink;
+
+/**
+ * Implementation of Logger class, a leveled and structured logger with asynchronous output.
+ *
+ * Callers only push the entry to a lock-free queue (multiple producers, single consumer); a background thread
+ * formats each entry as a Json line (time, level, category, thread, message) and writes it to the log file or
+ * to the error output, flushing once per batch. Entries below the current level are discarded by the LOG_*
+ * macros before the message is built, so disabled debug messages don't format any text.
+ *
+ * The logger is off until Start() is called. Start() reads SPOTIFYAPP_LOG_LEVEL (debug, info, warning, error, off;
+ * default info) and SPOTIFYAPP_LOG_FILE (default: error output), and routes Qt messages (qDebug, qWarning) to it.
+ */
+class Logger
+{
+public:
+    static bool IsEnabled(LogLevel level) { return int(level) >= minimumLevel.load(std::memory_order_relaxed); }
+    static void SetLevel(LogLevel level);
+    static LogLevel LevelFromName(const QString &name, LogLevel defaultLevel);
+
+    static bool Start();
+    static bool Start(LogLevel level, const QString &fileName);
+    static void Stop();
+
+    static void Write(LogLevel level, const char *category, const QString &message);
+    static void SetUiSink(LogUiSink *sink, LogLevel level = LogLevel::Warning);
+
+private:
+    static std::atomic<int> minimumLevel;
+};
+
+/**
+ * Implementation of LogUiSink class to show log entries in the interface without stalling the event loop.
+ * Entries received from the logger thread are kept in a buffer and emitted as a single text block every
+ * interval. At most a number of lines per second are shown, the lines over the limit are counted and reported.
+ */
+class LogUiSink : public QObject
+{
+    Q_OBJECT
+
+public:
+    LogUiSink(int intervalMs = 100, int maxLinesPerSecond = 50, QObject *parent = nullptr);
+    ~LogUiSink();
+
+    void Add(const QString &line);
+
+signals:
+    void LinesReadySignal(QString text, bool clear);
+
+private slots:
+    void Flush();
+
+private:
+    QMutex mutex;
+    QStringList lines;
+    int maxLines;
+    int linesInSecond;
+    int droppedLines;
+    qint64 secondStartMs;
+    QTimer flushTimer;
+};
+
+#define LOG_AT(level, category, message) \
+    do { if(Logger::IsEnabled(level)) Logger::Write(level, category, message); } while(0)
+
+//The message expression is only evaluated if the level is enabled
+#define LOG_DEBUG(category, message) LOG_AT(LogLevel::Debug, category, message)
+#define LOG_INFO(category, message) LOG_AT(LogLevel::Info, category, message)
+#define LOG_WARNING(category, message) LOG_AT(LogLevel::Warning, category, message)
+#define LOG_ERROR(category, message) LOG_AT(LogLevel::Error, category, message)
+
+#endif // LOGGER_H
@@ -0,0 +1,68 @@
+#ifndef MPSCQUEUE_H
+#define MPSCQUEUE_H
+
+#include <atomic>
+
+/**
+ * Intrusive lock-free queue with multiple producers and a single consumer (Vyukov queue). Node must have a
+ * member std::atomic<Node*> next and be default constructible (one node is kept as stub).
+ * Producers only exchange the head pointer, the consumer is the only one reading the tail. The queue doesn't
+ * own the nodes: the consumer releases the nodes popped, and the nodes left when the queue is destroyed.
+ */
+template<typename Node>
+class MpscQueue
+{
+public:
+    MpscQueue() : head(&stub), tail(&stub) { stub.next.store(nullptr); }
+
+    void Push(Node *node)
+    {
+        node->next.store(nullptr, std::memory_order_relaxed);
+        Node *previous = head.exchange(node, std::memory_order_acq_rel);
+        previous->next.store(node, std::memory_order_release);
+    }
+
+    //Returns nullptr if the queue is empty or a producer is still linking its node
+    Node *Pop()
+    {
+        Node *first = tail;
+        Node *next = first->next.load(std::memory_order_acquire);
+
+        if(first == &stub)
+        {
+            if(!next)
+                return nullptr;
+            tail = next;
+            first = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+
+        if(next)
+        {
+            tail = next;
+            return first;
+        }
+
+        if(first != head.load(std::memory_order_acquire))
+            return nullptr;
+
+        Push(&stub);
+        next = first->next.load(std::memory_order_acquire);
+        if(next)
+        {
+            tail = next;
+            return first;
+        }
+        return nullptr;
+    }
+
+private:
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue &operator=(const MpscQueue&) = delete;
+
+    std::atomic<Node*> head;
+    Node *tail;
+    Node stub;
+};
+
+#endif // MPSCQUEUE_H
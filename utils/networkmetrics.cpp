@@ -0,0 +1,251 @@
+#include "networkmetrics.h"
+
+#include <QFile>
+#include <QSet>
+#include <QJsonDocument>
+#include <QStringList>
+#include <cmath>
+
+//Sub-buckets per power of two and number of buckets of the latency histograms (up to 2^40 us)
+static const int bucketsPerOctave = 4;
+static const int bucketsCount = 40 * bucketsPerOctave;
+
+NetworkMetrics::NetworkMetrics(QObject *parent)
+    : QObject(parent)
+{
+    //The timer is a child so it follows the metrics when they are moved to other thread
+    dumpTimer.setParent(this);
+    connect(&dumpTimer, &QTimer::timeout, this, &NetworkMetrics::Dump);
+}
+
+NetworkMetrics::~NetworkMetrics()
+{
+    if(!dumpFile.isEmpty())
+        Dump();
+}
+
+/**
+Method to get the name used to group requests of the same endpoint. Path segments that follow a
+collection (users, playlists, artists, tracks, albums, audio-features) are ids and are replaced by "{id}".
+@param verb HTTP method of the request.
+@param url address of the request, the query is not part of the name.
+@return endpoint name, e.g. "GET /v1/users/{id}/playlists".
+*/
+QString NetworkMetrics::EndpointName(const QByteArray &verb, const QUrl &url)
+{
+    static const QSet<QString> collections({"users", "playlists", "artists", "tracks", "albums", "audio-features"});
+
+    const QStringList segments = url.path().split('/');
+    QStringList nameSegments;
+    nameSegments.reserve(segments.size());
+
+    for(int i = 0; i < segments.size(); i++)
+    {
+        if(i > 0 && !segments[i].isEmpty() && collections.contains(segments[i-1]))
+            nameSegments.append("{id}");
+        else
+            nameSegments.append(segments[i]);
+    }
+
+    return QString::fromLatin1(verb) + " " + nameSegments.join('/');
+}
+
+/**
+Method to record a request sent to the server.
+@param endpoint endpoint name from EndpointName().
+@param bytesSent size of the request body.
+*/
+void NetworkMetrics::RequestStarted(const QString &endpoint, qint64 bytesSent)
+{
+    QMutexLocker locker(&mutex);
+
+    EndpointMetrics &metrics = endpoints[endpoint];
+    metrics.requests++;
+    metrics.inFlight++;
+    metrics.bytesSent += bytesSent;
+}
+
+/**
+Method to record the reply of a request.
+@param endpoint endpoint name from EndpointName().
+@param latencyUs time from the request sent to the reply finished, in microseconds.
+@param bytesReceived size of the reply body.
+@param error true if the request failed (network error or error status).
+*/
+void NetworkMetrics::RequestFinished(const QString &endpoint, qint64 latencyUs, qint64 bytesReceived, bool error)
+{
+    QMutexLocker locker(&mutex);
+
+    EndpointMetrics &metrics = endpoints[endpoint];
+    metrics.inFlight--;
+    metrics.bytesReceived += bytesReceived;
+    metrics.latency.Add(latencyUs);
+    if(error)
+        metrics.errors++;
+}
+
+/**
+Method to record a request sent again (token refreshed or rate limit).
+@param endpoint endpoint name from EndpointName().
+*/
+void NetworkMetrics::RequestRetried(const QString &endpoint)
+{
+    QMutexLocker locker(&mutex);
+    endpoints[endpoint].retries++;
+}
+
+/**
+Method to record the time spent parsing the Json data of a reply.
+@param endpoint endpoint name from EndpointName().
+@param parseUs parse time in microseconds.
+*/
+void NetworkMetrics::AddParseTime(const QString &endpoint, qint64 parseUs)
+{
+    QMutexLocker locker(&mutex);
+
+    EndpointMetrics &metrics = endpoints[endpoint];
+    metrics.parsed++;
+    metrics.parseUs += parseUs;
+}
+
+/**
+Method to get the current metrics of all endpoints. Times are reported in milliseconds.
+@return Json object with the endpoints metrics keyed by endpoint name and the total of requests in flight.
+*/
+QJsonObject NetworkMetrics::Snapshot() const
+{
+    QMutexLocker locker(&mutex);
+
+    QJsonObject endpointsJson;
+    int inFlight = 0;
+
+    for(auto it = endpoints.constBegin(); it != endpoints.constEnd(); ++it)
+    {
+        const EndpointMetrics &metrics = it.value();
+        const LatencyHistogram &latency = metrics.latency;
+        inFlight += metrics.inFlight;
+
+        QJsonObject latencyJson({{"p50", latency.Percentile(0.50) / 1000.0},
+                                 {"p95", latency.Percentile(0.95) / 1000.0},
+                                 {"p99", latency.Percentile(0.99) / 1000.0},
+                                 {"max", latency.maxUs / 1000.0},
+                                 {"mean", latency.total ? latency.sumUs / 1000.0 / latency.total : 0.0}});
+
+        QJsonObject parseJson({{"count", double(metrics.parsed)},
+                               {"total", metrics.parseUs / 1000.0},
+                               {"mean", metrics.parsed ? metrics.parseUs / 1000.0 / metrics.parsed : 0.0}});
+
+        endpointsJson.insert(it.key(), QJsonObject({{"requests", double(metrics.requests)},
+                                                    {"errors", double(metrics.errors)},
+                                                    {"retries", double(metrics.retries)},
+                                                    {"in_flight", metrics.inFlight},
+                                                    {"bytes_sent", double(metrics.bytesSent)},
+                                                    {"bytes_received", double(metrics.bytesReceived)},
+                                                    {"latency_ms", latencyJson},
+                                                    {"parse_ms", parseJson}}));
+    }
+
+    return QJsonObject({{"endpoints", endpointsJson}, {"in_flight", inFlight}});
+}
+
+void NetworkMetrics::Reset()
+{
+    QMutexLocker locker(&mutex);
+
+    //Requests in flight are kept so their replies are still matched
+    for(auto it = endpoints.begin(); it != endpoints.end(); ++it)
+    {
+        const int inFlight = it.value().inFlight;
+        it.value() = EndpointMetrics();
+        it.value().inFlight = inFlight;
+    }
+}
+
+/**
+Method to write the metrics periodically to a file. The file is also written when the registry is destroyed.
+@param fileName path and name of the (.json) file, empty to stop writing.
+@param intervalMs time between two writes.
+*/
+void NetworkMetrics::SetDumpFile(const QString &fileName, int intervalMs)
+{
+    dumpFile = fileName;
+
+    if(dumpFile.isEmpty())
+        dumpTimer.stop();
+    else
+        dumpTimer.start(intervalMs);
+}
+
+/**
+Method to write the metrics periodically to the file set by the environment variable SPOTIFYAPP_METRICS,
+every SPOTIFYAPP_METRICS_INTERVAL milliseconds (default 10000).
+@return true if the variable is set.
+*/
+bool NetworkMetrics::DumpFromEnvironment()
+{
+    const QString fileName = qEnvironmentVariable("SPOTIFYAPP_METRICS");
+    if(fileName.isEmpty())
+        return false;
+
+    bool ok = false;
+    int intervalMs = qEnvironmentVariableIntValue("SPOTIFYAPP_METRICS_INTERVAL", &ok);
+    SetDumpFile(fileName, ok && intervalMs > 0 ? intervalMs : 10000);
+    return true;
+}
+
+/**
+SLOT Method to write the current metrics to the dump file.
+@return true if the file was written.
+*/
+bool NetworkMetrics::Dump()
+{
+    if(dumpFile.isEmpty())
+        return false;
+
+    QFile file(dumpFile);
+    if(!file.open(QIODevice::WriteOnly))
+        return false;
+
+    return file.write(QJsonDocument(Snapshot()).toJson()) != -1;
+}
+
+void NetworkMetrics::LatencyHistogram::Add(qint64 latencyUs)
+{
+    if(counts.isEmpty())
+        counts.fill(0, bucketsCount);
+
+    int bucket = 0;
+    if(latencyUs > 1)
+        bucket = qMin(bucketsCount - 1, int(std::log2(double(latencyUs)) * bucketsPerOctave));
+
+    counts[bucket]++;
+    total++;
+    sumUs += latencyUs;
+    maxUs = qMax(maxUs, latencyUs);
+}
+
+/**
+Method to get the latency below which a fraction of the requests finished.
+@param fraction fraction of requests, e.g. 0.95 for p95.
+@return upper bound of the histogram bucket holding the percentile, limited by the maximum latency.
+*/
+qint64 NetworkMetrics::LatencyHistogram::Percentile(double fraction) const
+{
+    if(total == 0)
+        return 0;
+
+    const quint64 rank = quint64(std::ceil(fraction * total));
+    quint64 cumulative = 0;
+
+    for(int bucket = 0; bucket < counts.size(); bucket++)
+    {
+        cumulative += counts[bucket];
+        if(cumulative >= rank)
+        {
+            const qint64 upperBound = qint64(std::pow(2.0, double(bucket + 1) / bucketsPerOctave));
+            return qMin(upperBound, maxUs);
+        }
+    }
+
+    return maxUs;
+}
@@ -0,0 +1,83 @@
+#ifndef NETWORKMETRICS_H
+#define NETWORKMETRICS_H
+
+#include <QObject>
+#include <QString>
+#include <QHash>
+#include <QVector>
+#include <QUrl>
+#include <QJsonObject>
+#include <QMutex>
+#include <QTimer>
+
+/**
+ * Implementation of NetworkMetrics class, a registry of the requests sent to the web api grouped by endpoint.
+ *
+ * Endpoints are identified by the HTTP method and the url path with the ids replaced by "{id}"
+ * (e.g. "GET /v1/playlists/{id}/tracks"). For each endpoint it records the count of requests, errors, retries
+ * and requests in flight, the bytes sent and received, the time spent parsing replies and a latency histogram
+ * used to report percentiles (p50, p95, p99).
+ *
+ * Metrics are read with Snapshot() and can be written periodically to a (.json) file with SetDumpFile().
+ */
+class NetworkMetrics : public QObject
+{
+    Q_OBJECT
+
+public:
+    NetworkMetrics(QObject *parent = nullptr);
+    ~NetworkMetrics();
+
+    static QString EndpointName(const QByteArray &verb, const QUrl &url);
+
+    void RequestStarted(const QString &endpoint, qint64 bytesSent);
+    void RequestFinished(const QString &endpoint, qint64 latencyUs, qint64 bytesReceived, bool error);
+    void RequestRetried(const QString &endpoint);
+    void AddParseTime(const QString &endpoint, qint64 parseUs);
+
+    QJsonObject Snapshot() const;
+    void Reset();
+
+    void SetDumpFile(const QString &fileName, int intervalMs = 10000);
+    bool DumpFromEnvironment();
+
+public slots:
+    bool Dump();
+
+private:
+    /**
+     * Histogram of latencies with logarithmic buckets (4 buckets per power of two),
+     * so percentiles are reported with a relative error below 19%.
+     */
+    struct LatencyHistogram
+    {
+        QVector<quint64> counts;
+        quint64 total = 0;
+        qint64 sumUs = 0;
+        qint64 maxUs = 0;
+
+        void Add(qint64 latencyUs);
+        qint64 Percentile(double fraction) const;
+    };
+
+    struct EndpointMetrics
+    {
+        quint64 requests = 0;
+        quint64 errors = 0;
+        quint64 retries = 0;
+        int inFlight = 0;
+        qint64 bytesSent = 0;
+        qint64 bytesReceived = 0;
+        quint64 parsed = 0;
+        qint64 parseUs = 0;
+        LatencyHistogram latency;
+    };
+
+    mutable QMutex mutex;
+    QHash<QString, EndpointMetrics> endpoints;
+
+    QString dumpFile;
+    QTimer dumpTimer;
+};
+
+#endif // NETWORKMETRICS_H
@@ -0,0 +1,158 @@
+#include "tracer.h"
+
+#include <QFile>
+#include <QThread>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QJsonDocument>
+#include <chrono>
+
+std::atomic<bool> Tracer::enabled(false);
+QMutex Tracer::mutex;
+QVector<Tracer::Span> Tracer::ring;
+quint64 Tracer::spansCount = 0;
+QString Tracer::traceFile;
+
+/**
+Method to switch tracing on or off. Enabling the tracer clears previous spans.
+@param enable true to record spans.
+@param capacity maximum number of spans kept in the ring buffer.
+*/
+void Tracer::SetEnabled(bool enable, int capacity)
+{
+    QMutexLocker locker(&mutex);
+
+    if(enable)
+    {
+        ring = QVector<Span>(qMax(1, capacity));
+        spansCount = 0;
+    }
+    enabled.store(enable, std::memory_order_relaxed);
+}
+
+/**
+Method to enable tracing if the environment variable SPOTIFYAPP_TRACE is set.
+@return true if tracing was enabled.
+*/
+bool Tracer::EnableFromEnvironment()
+{
+    traceFile = qEnvironmentVariable("SPOTIFYAPP_TRACE");
+    if(traceFile.isEmpty())
+        return false;
+
+    SetEnabled(true);
+    return true;
+}
+
+/**
+Method to get the file where the trace is written at the end of the application, set by SPOTIFYAPP_TRACE.
+*/
+QString Tracer::TraceFile()
+{
+    return traceFile;
+}
+
+void Tracer::SetTraceFile(const QString &fileName)
+{
+    traceFile = fileName;
+}
+
+/**
+Method to get the current time of the trace clock (monotonic).
+@return time in microseconds.
+*/
+qint64 Tracer::NowUs()
+{
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+Method to record a span whose start and end are known, e.g. a request sent in one method and
+received in another one.
+@param name name of the span, must be a string literal (it is not copied).
+@param category category of the span, must be a string literal.
+@param startUs start time from NowUs().
+@param durationUs duration in microseconds.
+@param detail optional data shown in the span arguments (e.g. request url).
+*/
+void Tracer::AddSpan(const char *name, const char *category, qint64 startUs, qint64 durationUs, const QByteArray &detail)
+{
+    if(!IsEnabled())
+        return;
+
+    const quint64 threadId = quint64(quintptr(QThread::currentThreadId()));
+
+    QMutexLocker locker(&mutex);
+    if(ring.isEmpty())
+        return;
+
+    Span &span = ring[int(spansCount % quint64(ring.size()))];
+    span.name = name;
+    span.category = category;
+    span.startUs = startUs;
+    span.durationUs = durationUs;
+    span.threadId = threadId;
+    span.detail = detail;
+    spansCount++;
+}
+
+/**
+Method to get the spans in the ring buffer, from oldest to newest.
+*/
+QVector<Tracer::Span> Tracer::Spans()
+{
+    QMutexLocker locker(&mutex);
+
+    QVector<Span> spans;
+    if(ring.isEmpty())
+        return spans;
+
+    const quint64 capacity = quint64(ring.size());
+    const quint64 first = spansCount > capacity ? spansCount - capacity : 0;
+
+    spans.reserve(int(spansCount - first));
+    for(quint64 i = first; i < spansCount; i++)
+        spans.append(ring.at(int(i % capacity)));
+
+    return spans;
+}
+
+/**
+Method to save the recorded spans in Chrome trace event format (complete events, "ph":"X").
+@param fileName path and name of the (.json) trace file.
+@return true if the file was written.
+*/
+bool Tracer::WriteChromeTrace(const QString &fileName)
+{
+    QJsonArray events;
+
+    for(const Span &span : Spans())
+    {
+        QJsonObject event({{"name", span.name},
+                           {"cat", span.category},
+                           {"ph", "X"},
+                           {"ts", double(span.startUs)},
+                           {"dur", double(span.durationUs)},
+                           {"pid", 1},
+                           {"tid", double(span.threadId)}});
+
+        if(!span.detail.isEmpty())
+            event.insert("args", QJsonObject({{"detail", QString::fromUtf8(span.detail)}}));
+
+        events.append(event);
+    }
+
+    QFile file(fileName);
+    if(!file.open(QIODevice::WriteOnly))
+        return false;
+
+    QJsonObject root({{"traceEvents", events}, {"displayTimeUnit", "ms"}});
+    return file.write(QJsonDocument(root).toJson(QJsonDocument::Compact)) != -1;
+}
+
+void Tracer::Clear()
+{
+    QMutexLocker locker(&mutex);
+    spansCount = 0;
+}
@@ -0,0 +1,85 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+#include <QMutex>
+#include <atomic>
+
+/**
+ * Implementation of Tracer class to record timing spans of the application hot paths (requests, Json parsing,
+ * model build, view updates, saving) and export them in Chrome trace event format (chrome://tracing, Perfetto).
+ *
+ * Spans are kept in a ring buffer of fixed capacity, so the oldest spans are overwritten in long sessions.
+ * Tracing is switched at runtime: when disabled, a span costs only the check of an atomic flag.
+ * Setting the environment variable SPOTIFYAPP_TRACE to a file name enables tracing at startup and the trace
+ * is written to that file when the application finishes.
+ */
+class Tracer
+{
+public:
+    struct Span
+    {
+        const char *name;
+        const char *category;
+        qint64 startUs;
+        qint64 durationUs;
+        quint64 threadId;
+        QByteArray detail;
+    };
+
+    static bool IsEnabled() { return enabled.load(std::memory_order_relaxed); }
+    static void SetEnabled(bool enable, int capacity = 65536);
+    static bool EnableFromEnvironment();
+    static QString TraceFile();
+    static void SetTraceFile(const QString &fileName);
+
+    static qint64 NowUs();
+    static void AddSpan(const char *name, const char *category, qint64 startUs, qint64 durationUs,
+                        const QByteArray &detail = QByteArray());
+
+    static QVector<Span> Spans();
+    static bool WriteChromeTrace(const QString &fileName);
+    static void Clear();
+
+private:
+    static std::atomic<bool> enabled;
+    static QMutex mutex;
+    static QVector<Span> ring;
+    static quint64 spansCount;
+    static QString traceFile;
+};
+
+/**
+ * Implementation of TraceScope class to record a span covering the lifetime of the object (scope of a block).
+ * The start time is only read if tracing is enabled when the scope begins.
+ */
+class TraceScope
+{
+public:
+    TraceScope(const char *name, const char *category)
+        : spanName(name),
+          spanCategory(category),
+          startUs(Tracer::IsEnabled() ? Tracer::NowUs() : -1)
+    {}
+
+    ~TraceScope()
+    {
+        if(startUs >= 0)
+            Tracer::AddSpan(spanName, spanCategory, startUs, Tracer::NowUs() - startUs);
+    }
+
+private:
+    const char *spanName;
+    const char *spanCategory;
+    qint64 startUs;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+//Records a span from this line to the end of the current scope
+#define TRACE_SCOPE(name, category) TraceScope TRACE_CONCAT(traceScope, __LINE__)(name, category)
+
+#endif // TRACER_H